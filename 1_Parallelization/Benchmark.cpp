@@ -0,0 +1,44 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        https://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+ * Benchmarks the join engines of this stage on synthetic relations, see JoinBenchmark.h:
+ *
+ *   ./ParallelismBenchmark --benchmark_filter='DenseJoin/zipf' --benchmark_out=results.json --benchmark_out_format=json
+ *
+ * Join is performJoin of Join.cpp, which takes the dense join on dense title domains and the OpenMP hash join otherwise.
+ */
+
+#include "JoinUtils.hpp"
+#include "Join.hpp"
+#include "HashJoin.h"
+#include "SortMergeJoin.h"
+#include "DenseJoin.h"
+#include "JoinBenchmark.h"
+
+#include <vector>
+
+using Relations = BenchmarkRelations<CastRelation, TitleRelation>;
+
+int main(int argc, char** argv) {
+    const std::vector<JoinBenchmarkEngine<CastRelation, TitleRelation, ResultRelation>> engines = {
+        {"SHJ_UNORDERED_MAP", [](const Relations& r, int) {return performSHJ_UNORDERED_MAP(r.cast, r.title);}, false},
+        {"CHJ_MAP", [](const Relations& r, int threads) {return performCHJ_MAP(r.cast, r.title, threads);}, true},
+        {"CacheSizedHJ", [](const Relations& r, int threads) {return performCacheSizedThreadedHashJoin(r.cast, r.title, threads);}, true},
+        {"ThreadedSortJoin", [](const Relations& r, int threads) {return performThreadedSortJoin(r.cast, r.title, threads);}, true},
+        {"DenseJoin", [](const Relations& r, int threads) {return performDenseJoin(r.cast, r.title, minMaxTitle(r.title), threads);}, true},
+        {"Join", [](const Relations& r, int threads) {return performJoin(r.cast, r.title, threads);}, true},
+    };
+    return runJoinBenchmarks(argc, argv, engines);
+}
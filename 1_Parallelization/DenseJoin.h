@@ -0,0 +1,95 @@
+#ifndef PPDS_PARALLELISM_DENSEJOIN_H
+#define PPDS_PARALLELISM_DENSEJOIN_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <omp.h>
+
+#include "JoinUtils.hpp"
+
+/**
+ * @brief a key domain is dense if it has at most this many slots per title, the direct-addressed array then needs
+ * no more memory than a hash table over the same titles
+ */
+static constexpr const std::size_t DENSE_DOMAIN_FACTOR = 4;
+
+static constexpr const uint32_t DENSE_EMPTY = std::numeric_limits<uint32_t>::max();
+
+std::pair<int32_t, int32_t> minMaxCast(const std::vector<CastRelation>& leftRelation) {
+    int32_t min = std::numeric_limits<int32_t>::max();
+    int32_t max = std::numeric_limits<int32_t>::min();
+    #pragma omp parallel for reduction(min:min) reduction(max:max)
+    for(const auto& record : leftRelation) {
+        min = std::min(min, record.movieId);
+        max = std::max(max, record.movieId);
+    }
+    return {min, max};
+}
+
+std::pair<int32_t, int32_t> minMaxTitle(const std::vector<TitleRelation>& rightRelation) {
+    int32_t min = std::numeric_limits<int32_t>::max();
+    int32_t max = std::numeric_limits<int32_t>::min();
+    #pragma omp parallel for reduction(min:min) reduction(max:max)
+    for(const auto& record : rightRelation) {
+        min = std::min(min, record.titleId);
+        max = std::max(max, record.titleId);
+    }
+    return {min, max};
+}
+
+/**
+ * @brief true if the titleIds [min, max] of rightRelation are compact enough for performDenseJoin
+ */
+bool isDenseDomain(const std::pair<int32_t, int32_t> titleRange, const std::size_t numTitles) {
+    if(numTitles == 0 || numTitles >= DENSE_EMPTY) {
+        return false;
+    }
+    const auto range = static_cast<uint64_t>(static_cast<int64_t>(titleRange.second) - titleRange.first) + 1;
+    return range <= DENSE_DOMAIN_FACTOR * static_cast<uint64_t>(numTitles);
+}
+
+/**
+ * @brief join on a direct-addressed array instead of a hash table. heads[titleId - min] is the row of the last title
+ * with that id, next[row] chains the titles with the same id. The build is a parallel atomic exchange per title, a
+ * probe is a bounds check and one array load, no hashing and no collisions.
+ * @param titleRange min and max titleId of rightRelation, see minMaxTitle
+ */
+std::vector<ResultRelation> performDenseJoin(const std::vector<CastRelation>& leftRelation, const std::vector<TitleRelation>& rightRelation,
+                                             const std::pair<int32_t, int32_t> titleRange, const int numThreads = std::jthread::hardware_concurrency()) {
+    const auto [min, max] = titleRange;
+    const auto range = static_cast<std::size_t>(static_cast<int64_t>(max) - min) + 1;
+    std::vector<uint32_t> heads(range, DENSE_EMPTY);
+    std::vector<uint32_t> next(rightRelation.size());
+    #pragma omp parallel for num_threads(numThreads)
+    for(std::size_t row = 0; row < rightRelation.size(); ++row) {
+        std::atomic_ref<uint32_t> head(heads[static_cast<int64_t>(rightRelation[row].titleId) - min]);
+        next[row] = head.exchange(static_cast<uint32_t>(row), std::memory_order_relaxed);
+    }
+
+    std::vector<std::vector<std::pair<const CastRelation*, const TitleRelation*>>> localResults(numThreads);
+    std::vector<ResultRelation> results;
+    #pragma omp parallel num_threads(numThreads)
+    {
+        const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+        auto& matches = localResults[thread];
+        #pragma omp for schedule(static)
+        for(std::size_t i = 0; i < leftRelation.size(); ++i) {
+            const auto& record = leftRelation[i];
+            if(record.movieId < min || record.movieId > max) {
+                continue;
+            }
+            for(auto row = heads[static_cast<int64_t>(record.movieId) - min]; row != DENSE_EMPTY; row = next[row]) {
+                matches.emplace_back(&record, &rightRelation[row]);
+            }
+        }
+        materializeLocalResults(localResults, results);
+    }
+    return results;
+}
+
+#endif //PPDS_PARALLELISM_DENSEJOIN_H
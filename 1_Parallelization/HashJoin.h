@@ -11,6 +11,10 @@
 #include <span>
 #include <ranges>
 #include <algorithm>
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 #include "JoinUtils.hpp"
 
@@ -19,6 +19,10 @@
 #include "SortMergeJoin.h"
 #include "NestedLoopJoin.h"
 #include "MergeSort.h"
+#include "DenseJoin.h"
+#include "ScalingHarness.h"
+#include "DataGenerator.h"
+#include "DifferentialHarness.h"
 
 #include <unordered_map>
 #include <iostream>
@@ -30,29 +34,11 @@
 #include <span>
 //#include <experimental/simd>
 
-std::pair<int32_t, int32_t> minMaxCast(const std::vector<CastRelation>& leftRelation) {
-    int32_t min = std::numeric_limits<int32_t>::max();
-    int32_t max = std::numeric_limits<int32_t>::min();
-    #pragma omp parallel for reduction(min:min) reduction(max:max)
-    for(const auto& record : leftRelation) {
-        min = std::min(min, record.movieId);
-        max = std::max(max, record.movieId);
-    }
-    return {min, max};
-}
-
-std::pair<int32_t, int32_t> minMaxTitle(const std::vector<TitleRelation>& rightRelation) {
-    int32_t min = std::numeric_limits<int32_t>::max();
-    int32_t max = std::numeric_limits<int32_t>::min();
-    #pragma omp parallel for reduction(min:min) reduction(max:max)
-    for(const auto& record : rightRelation) {
-        min = std::min(min, record.titleId);
-        max = std::max(max, record.titleId);
-    }
-    return {min, max};
-}
-
 std::vector<ResultRelation> performJoin(const std::vector<CastRelation>& leftRelation, const std::vector<TitleRelation>& rightRelation, int numThreads = std::jthread::hardware_concurrency()) {
+    const auto titleRange = minMaxTitle(rightRelation);
+    if(isDenseDomain(titleRange, rightRelation.size())) {
+        return performDenseJoin(leftRelation, rightRelation, titleRange, numThreads);
+    }
     omp_set_num_threads(numThreads);
     std::vector<ResultRelation> results;
     std::size_t chunkSize = (rightRelation.size() / numThreads) + 1;
@@ -108,207 +94,131 @@ TEST(ParallelizationTest, TestJoiningTuples) {
     std::cout << "Result size: " << resultTuples.size() << std::endl;
     std::cout << "\n\n";
 }
-/*
-TEST(ParallelizationTest, TestThreadScaling) {
-    const auto leftRelation = load<CastRelation>(DATA_DIRECTORY + std::string("cast_info_uniform.csv"), 20000);
-    const auto rightRelation = load<TitleRelation>(DATA_DIRECTORY + std::string("title_info_uniform.csv"), 20000);
-    auto sink = performThreadedSortJoin(leftRelation, rightRelation); // So Cache is hot?
-
-    for(int i = 1; i <= std::thread::hardware_concurrency(); ++i) {
-        for(int j = 0; j < 10; ++j) {
-            Timer timer("Parallelized Join Execute");
-            timer.start();
-            auto resultTuples = performCHJ_MAP(leftRelation, rightRelation, i);
-            timer.pause();
-            std::cout << "Run " << j << " with " << i <<" Threads: " << timer << std::endl;
-        }
-        std::cout << '\n';
-    }
-}
- */
-
 /**
- * Tests if the join algorithmus returns the correct amount of Tuples, and that the individual tuples are part of a correct
- * join algorithm, using uniform data!
+ * Sweeps the join engines over 1..hardware_concurrency threads, without and with compact pinning, and writes speedup, parallel efficiency and the
+ * Karp-Flatt serial fraction to thread_scaling.csv and thread_scaling.json in the working directory.
  */
-TEST(ParallelizationTest, TestAmoutUniform) {
-    std::cout   << "##########################################################################################\n"
-                << "# Testing if join algorithm contains wrong or duplicate records when using uniform data! #\n"
-                << "##########################################################################################\n";
-    const auto leftRelation = load<CastRelation>(DATA_DIRECTORY + std::string("cast_info_uniform.csv"), 20000);
-    const auto rightRelation = load<TitleRelation>(DATA_DIRECTORY + std::string("title_info_uniform.csv"), 20000);
-
-    size_t correctRecords = 0;
-    size_t duplicateRecords = 0;
-    size_t wrongRecords = 0;
-
-    std::vector<uint32_t> duplicateCastInfoIds;
-    std::vector<uint32_t> wrongCastInfoIds;
-
-    auto correctResults = performNestedLoopJoin(leftRelation, rightRelation);
-    std::unordered_map<uint32_t, const ResultRelation*> mapCorrect;
-    std::unordered_map<uint32_t, const ResultRelation*> found; // Used to make sure no record is duplicated
-    for(const auto& record : correctResults) {
-        mapCorrect[record.castInfoId] = &record;
-    }
-    auto sample = performJoin(leftRelation, rightRelation, 8);
-
-    for(const auto& record: sample) {
-        if(!mapCorrect.contains(record.castInfoId)) {
-            std::cout << "Found a record that should not be in results!\n" << resultRelationToString(record) << '\n' << std::endl;
-            wrongRecords += 1;
-            wrongCastInfoIds.emplace_back(record.castInfoId);
-            if(found.contains(record.castInfoId)) {
-                std::cout << "Found a duplicate record!\n" << resultRelationToString(record) << '\n' << std::endl;
-                duplicateRecords += 1;
-            } else {
-                found[record.castInfoId] = &record;
-            }
+TEST(ParallelizationTest, TestThreadScaling) {
+    std::vector<TitleRelation> rightRelation(20000);
+    for(int32_t i = 0; i < static_cast<int32_t>(rightRelation.size()); ++i) {
+        rightRelation[i].titleId = i * 3; // sparse, so performJoin does not switch to the dense join
+    }
+    std::vector<CastRelation> leftRelation(100000);
+    for(int32_t i = 0; i < static_cast<int32_t>(leftRelation.size()); ++i) {
+        leftRelation[i].castInfoId = i;
+        leftRelation[i].movieId = (i * 7919) % 60000;
+    }
+
+    // at least two thread counts, so speedup and serial fraction are exercised on single cpu machines as well
+    const auto maxThreads = std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+    std::vector<int> threadCounts;
+    for(int threads = 1; threads <= maxThreads; ++threads) {
+        threadCounts.emplace_back(threads);
+    }
+    ScalingHarness harness({.threadCounts = threadCounts, .policies = {AffinityPolicy::NONE, AffinityPolicy::COMPACT}, .warmups = 1, .repetitions = 3});
+    std::size_t expectedResults = 0;
+    const auto checkSize = [&expectedResults](const std::vector<ResultRelation>& results) {
+        if(expectedResults == 0) {
+            expectedResults = results.size();
         }
-        else {
-            if(found.contains(record.castInfoId)) {
-                std::cout << "Found a duplicate record!\n" << resultRelationToString(record) << '\n' << std::endl;
-                duplicateRecords += 1;
-            } else {
-                found[record.castInfoId] = &record;
-            }
-            correctRecords += 1;
+        ASSERT_EQ(results.size(), expectedResults);
+    };
+    harness.run("CHJ_MAP", [&](int threads) {checkSize(performCHJ_MAP(leftRelation, rightRelation, threads));});
+    harness.run("CacheSizedHJ", [&](int threads) {checkSize(performCacheSizedThreadedHashJoin(leftRelation, rightRelation, threads));});
+    harness.run("ThreadedSortJoin", [&](int threads) {checkSize(performThreadedSortJoin(leftRelation, rightRelation, threads));});
+    harness.run("Join", [&](int threads) {checkSize(performJoin(leftRelation, rightRelation, threads));});
+    harness.print();
+
+    ASSERT_EQ(harness.results().size(), 4 * 2 * threadCounts.size());
+    for(const auto& point: harness.results()) {
+        ASSERT_EQ(point.runtimesMs.size(), 3u);
+        ASSERT_GT(point.medianMs, 0);
+        ASSERT_NEAR(point.efficiency, point.speedup / point.threads, 1e-9);
+        if(point.threads == 1) {
+            ASSERT_DOUBLE_EQ(point.speedup, 1.0);
+            ASSERT_DOUBLE_EQ(point.karpFlatt, 0.0);
+        } else { // the Karp-Flatt fraction reproduces the measured speedup under Amdahl's law
+            ASSERT_NEAR(1 / (point.karpFlatt + (1 - point.karpFlatt) / point.threads), point.speedup, 1e-9);
         }
-    }
-    std::cout << '\n';
-    std::cout << "Found " << correctRecords << " correct records!\n";
-    std::cout << "Found " << duplicateRecords << " duplicate records with the following CastInfoIds:\n";
-    for(const auto& id: duplicateCastInfoIds) {
-        std::cout << id << '\n';
-    }
-    std::cout << "Found " << wrongRecords << " wrong records with teh following CastInfoIds:\n";
-    for(const auto& id: wrongCastInfoIds) {
-        std::cout << id << '\n';
-    }
-    std::cout << std::flush;
-}
-
-
-/**
- * Tests if the join algorithmus returns the correct amount of Tuples, and that the individual tuples are part of a correct
- * join algorithm, using a dataset where each title record matches to one cast record!
- */
-TEST(ParallelizationTest, TestAmoutOnlyMatches1to1) {
-    std::cout   << "##########################################################################################\n"
-                << "# Testing if join algorithm contains wrong or duplicate records when using uniform data! #\n"
-                << "##########################################################################################\n";
-    const auto leftRelation = load<CastRelation>(DATA_DIRECTORY + std::string("cast_info_matching.csv"), 20000);
-    const auto rightRelation = load<TitleRelation>(DATA_DIRECTORY + std::string("title_info_matching.csv"), 20000);
-
-    size_t correctRecords = 0;
-    size_t duplicateRecords = 0;
-    size_t wrongRecords = 0;
-
-    std::vector<uint32_t> duplicateCastInfoIds;
-    std::vector<uint32_t> wrongCastInfoIds;
-
-    auto correctResults = performNestedLoopJoin(leftRelation, rightRelation);
-    std::unordered_map<uint32_t, const ResultRelation*> mapCorrect;
-    std::unordered_map<uint32_t, const ResultRelation*> found; // Used to make sure no record is duplicated
-    for(const auto& record : correctResults) {
-        mapCorrect[record.castInfoId] = &record;
-    }
-    auto sample = performJoin(leftRelation, rightRelation, 8);
-
-    for(const auto& record: sample) {
-        if(!mapCorrect.contains(record.castInfoId)) {
-            std::cout << "Found a record that should not be in results!\n" << resultRelationToString(record) << '\n' << std::endl;
-            wrongRecords += 1;
-            wrongCastInfoIds.emplace_back(record.castInfoId);
-            if(found.contains(record.castInfoId)) {
-                std::cout << "Found a duplicate record!\n" << resultRelationToString(record) << '\n' << std::endl;
-                duplicateRecords += 1;
-            } else {
-                found[record.castInfoId] = &record;
-            }
-        }
-        else {
-            if(found.contains(record.castInfoId)) {
-                std::cout << "Found a duplicate record!\n" << resultRelationToString(record) << '\n' << std::endl;
-                duplicateRecords += 1;
-            } else {
-                found[record.castInfoId] = &record;
+        ASSERT_EQ(point.pinned, point.policy != AffinityPolicy::NONE);
+    }
+    ASSERT_TRUE(harness.writeCsv("thread_scaling.csv"));
+    ASSERT_TRUE(harness.writeJson("thread_scaling.json"));
+
+    // the policy reaches the threads of the OpenMP pool, not only the calling thread
+    ScalingHarness placement({.threadCounts = {maxThreads}, .policies = {AffinityPolicy::COMPACT}, .warmups = 0, .repetitions = 1});
+    int misplaced = 0;
+    placement.run("Placement", [&misplaced](int threads) {
+        const auto cpus = Topology::get().cpuOrder(AffinityPolicy::COMPACT, static_cast<std::size_t>(threads));
+        #pragma omp parallel num_threads(threads) reduction(+:misplaced)
+        {
+            cpu_set_t mask;
+            CPU_ZERO(&mask);
+            sched_getaffinity(0, sizeof(mask), &mask);
+            for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                misplaced += CPU_ISSET(cpu, &mask) && std::find(cpus.begin(), cpus.end(), cpu) == cpus.end();
             }
-            correctRecords += 1;
         }
-    }
-    std::cout << '\n';
-    std::cout << "Found " << correctRecords << " correct records!\n";
-    std::cout << "Found " << duplicateRecords << " duplicate records with the following CastInfoIds:\n";
-    for(const auto& id: duplicateCastInfoIds) {
-        std::cout << id << '\n';
-    }
-    std::cout << "Found " << wrongRecords << " wrong records with teh following CastInfoIds:\n";
-    for(const auto& id: wrongCastInfoIds) {
-        std::cout << id << '\n';
-    }
-    std::cout << std::flush;
+    });
+    ASSERT_TRUE(placement.results()[0].pinned);
+    ASSERT_EQ(misplaced, 0);
 }
 
 /**
- * Tests if the join algorithmus returns the correct amount of Tuples, and that the individual tuples are part of a correct
- * join algorithm!
+ * Runs every join engine of this stage on the same generated relations and checks its results against a reference join
+ * as multisets, which also catches lost and duplicated rows of one to many matches.
  */
-TEST(ParallelizationTest, TestAmoutOnlyMatches1toMany) {
-    std::cout   << "##########################################################################################\n"
-                << "# Testing if join algorithm contains wrong or duplicate records when using uniform data! #\n"
-                << "##########################################################################################\n";
-    const auto leftRelation = load<CastRelation>(DATA_DIRECTORY + std::string("cast_info_one_to_many.csv"), 20000);
-    const auto rightRelation = load<TitleRelation>(DATA_DIRECTORY + std::string("title_info_one_to_many.csv"), 20000);
-
-    size_t correctRecords = 0;
-    size_t duplicateRecords = 0;
-    size_t wrongRecords = 0;
-
-    std::vector<uint32_t> duplicateCastInfoIds;
-    std::vector<uint32_t> wrongCastInfoIds;
-
-    auto correctResults = performNestedLoopJoin(leftRelation, rightRelation);
-    std::unordered_map<uint32_t, const ResultRelation*> mapCorrect;
-    std::unordered_map<uint32_t, const ResultRelation*> found; // Used to make sure no record is duplicated
-    for(const auto& record : correctResults) {
-        mapCorrect[record.castInfoId] = &record;
-    }
-    auto sample = performJoin(leftRelation, rightRelation, 8);
+TEST(DifferentialTest, TestEnginesMatchReference) {
+    DifferentialHarness<CastRelation, TitleRelation, ResultRelation> harness(4);
+    harness.add("SHJ_MAP", [](const auto& cast, const auto& title, int) {return performSHJ_MAP(cast, title);});
+    harness.add("SHJ_UNORDERED_MAP", [](const auto& cast, const auto& title, int) {return performSHJ_UNORDERED_MAP(cast, title);});
+    harness.add("CHJ_MAP", [](const auto& cast, const auto& title, int threads) {return performCHJ_MAP(cast, title, threads);});
+    harness.add("CacheSizedHJ", [](const auto& cast, const auto& title, int threads) {return performCacheSizedThreadedHashJoin(cast, title, threads);});
+    harness.add("ThreadedSortJoin", [](const auto& cast, const auto& title, int threads) {return performThreadedSortJoin(cast, title, threads);});
+    harness.add("DenseJoin", [](const auto& cast, const auto& title, int threads) {return performDenseJoin(cast, title, minMaxTitle(title), threads);});
+    harness.add("Join", [](const auto& cast, const auto& title, int threads) {return performJoin(cast, title, threads);});
+
+    for(const auto& outcome: runStandardDatasets(harness)) {
+        EXPECT_TRUE(outcome.correct) << outcome;
+    }
+    harness.print();
+}
 
-    for(const auto& record: sample) {
-        if(!mapCorrect.contains(record.castInfoId)) {
-            std::cout << "Found a record that should not be in results!\n" << resultRelationToString(record) << '\n' << std::endl;
-            wrongRecords += 1;
-            wrongCastInfoIds.emplace_back(record.castInfoId);
-            if(found.contains(record.castInfoId)) {
-                std::cout << "Found a duplicate record!\n" << resultRelationToString(record) << '\n' << std::endl;
-                duplicateRecords += 1;
-            } else {
-                found[record.castInfoId] = &record;
-            }
+TEST(DenseJoinTest, TestMatchesReferenceJoin) {
+    std::vector<TitleRelation> titleRelation(5000);
+    for(int32_t i = 0; i < static_cast<int32_t>(titleRelation.size()); ++i) {
+        titleRelation[i].titleId = i * 2 - 3000; // every other id of a domain starting below zero
+        titleRelation[i].kindId = i;
+    }
+    titleRelation[17].titleId = titleRelation[4].titleId; // duplicate key
+    std::vector<CastRelation> castRelation(20000);
+    for(int32_t i = 0; i < static_cast<int32_t>(castRelation.size()); ++i) {
+        castRelation[i].castInfoId = i;
+        castRelation[i].movieId = (i * 7919) % 12000 - 3500; // includes ids outside the title domain
+    }
+    const auto titleRange = minMaxTitle(titleRelation);
+    ASSERT_EQ(titleRange, std::make_pair(-3000, 6998));
+    ASSERT_TRUE(isDenseDomain(titleRange, titleRelation.size()));
+    ASSERT_FALSE(isDenseDomain({0, 1 << 30}, titleRelation.size()));
+
+    std::unordered_multimap<int32_t, int32_t> kindsByTitle;
+    for(const auto& title: titleRelation) {
+        kindsByTitle.emplace(title.titleId, title.kindId);
+    }
+    std::vector<std::pair<int32_t, int32_t>> expected;
+    for(const auto& cast: castRelation) {
+        const auto [begin, end] = kindsByTitle.equal_range(cast.movieId);
+        for(auto it = begin; it != end; ++it) {
+            expected.emplace_back(cast.castInfoId, it->second);
         }
-        else {
-            if(found.contains(record.castInfoId)) {
-                std::cout << "Found a duplicate record!\n" << resultRelationToString(record) << '\n' << std::endl;
-                duplicateRecords += 1;
-            } else {
-                found[record.castInfoId] = &record;
-            }
-            correctRecords += 1;
-        }
-    }
-    std::cout << '\n';
-    std::cout << "Found " << correctRecords << " correct records!\n";
-    std::cout << "Found " << duplicateRecords << " duplicate records with the following CastInfoIds:\n";
-    for(const auto& id: duplicateCastInfoIds) {
-        std::cout << id << '\n';
     }
-    std::cout << "Found " << wrongRecords << " wrong records with teh following CastInfoIds:\n";
-    for(const auto& id: wrongCastInfoIds) {
-        std::cout << id << '\n';
+    std::sort(expected.begin(), expected.end());
+    for(const int numThreads: {1, 4}) {
+        std::vector<std::pair<int32_t, int32_t>> joined;
+        for(const auto& record: performJoin(castRelation, titleRelation, numThreads)) {
+            joined.emplace_back(record.castInfoId, record.kindId);
+        }
+        std::sort(joined.begin(), joined.end());
+        ASSERT_EQ(joined, expected);
     }
-    std::cout << std::flush;
 }
-
-
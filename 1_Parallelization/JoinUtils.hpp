@@ -19,7 +19,11 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <utility>
 #include <vector>
+#include <omp.h>
+
+#include "HardwareInfo.h"
 
 //==--------------------------------------------------------------------==//
 //==------------------ RELATION & RELATION UTILITY----------------------==//
@@ -354,11 +358,11 @@ inline bool compareCastRelations(const CastRelation& a, const CastRelation& b) {
     return a.movieId < b.movieId;
 }
 
-constexpr const std::size_t L1_CACHE_SIZE = 256 * 1024 / 8;
-constexpr const std::size_t L2_CACHE_SIZE = 8 * 1024 * 1024 / 8;
-constexpr const std::size_t L3_CACHE_SIZE = 16 * 1024 * 1024;
+static const std::size_t L1_CACHE_SIZE = HardwareInfo::get().l1CacheSize(); ///< per physical core
+static const std::size_t L2_CACHE_SIZE = HardwareInfo::get().l2CacheSize(); ///< per physical core
+static const std::size_t L3_CACHE_SIZE = HardwareInfo::get().l3CacheSize(); ///< shared
 
-constexpr const std::size_t MAX_HASH_MAP_SIZE = L2_CACHE_SIZE / (sizeof(CastRelation*) + sizeof(int32_t));
+static const std::size_t MAX_HASH_MAP_SIZE = HardwareInfo::get().hashMapEntries(sizeof(CastRelation*) + sizeof(int32_t));
 
 
 void inline printCacheSizes() {
@@ -367,7 +371,31 @@ void inline printCacheSizes() {
     std::cout << "L3 cache size: " << L3_CACHE_SIZE << std::endl;
 }
 
-
-
+/**
+ * @brief writes the matches every thread of the enclosing parallel region collected in localResults[thread] into
+ * results, which is sized exactly once; each thread fills its own range behind the matches of the threads before it,
+ * so no counter is shared. All threads of the region have to call it once they are done matching.
+ */
+inline void materializeLocalResults(const std::vector<std::vector<std::pair<const CastRelation*, const TitleRelation*>>>& localResults,
+                                    std::vector<ResultRelation>& results) {
+    #pragma omp barrier
+    #pragma omp single
+    {
+        std::size_t size = 0;
+        for(const auto& matches: localResults) {
+            size += matches.size();
+        }
+        results.resize(size);
+    } // implicit barrier, results is sized for every thread
+    const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+    std::size_t offset = 0;
+    for(std::size_t i = 0; i < thread; ++i) {
+        offset += localResults[i].size();
+    }
+    auto output = results.begin() + static_cast<std::ptrdiff_t>(offset);
+    for(const auto& [castTuple, titleTuple] : localResults[thread]) {
+        *output++ = createResultTuple(*castTuple, *titleTuple);
+    }
+}
 
 #endif //JOINUTIL_HPP
@@ -0,0 +1,71 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        https://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+ * Micro-benchmarks of merge_sort on its own, without loading or joining. Sorts cast tuples with uniform movieIds by
+ * movieId, like the sort merge joins do, over working sets from L1 to DRAM (see MicroBenchmark.h):
+ *
+ *   ./ParallelismMicroBenchmark --benchmark_filter='merge_sort' --benchmark_out=sort.json --benchmark_out_format=json
+ */
+
+#include "JoinUtils.hpp"
+#include "MergeSort.h"
+#include "MicroBenchmark.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+static void mergeSortCast(benchmark::State& state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto numThreads = static_cast<std::size_t>(state.range(1));
+    const auto keys = uniformKeys(n, static_cast<int32_t>(n));
+    std::vector<CastRelation> input(n);
+    for(std::size_t i = 0; i < n; ++i) {
+        input[i].castInfoId = static_cast<int32_t>(i);
+        input[i].movieId = keys[i];
+    }
+    ThreadPool pool(numThreads);
+    std::vector<CastRelation> relation;
+    for(auto _ : state) {
+        state.PauseTiming();
+        relation = input;
+        state.ResumeTiming();
+        merge_sort(pool, relation.begin(), relation.end(), [](const CastRelation& a, const CastRelation& b) {return a.movieId < b.movieId;}, numThreads);
+        benchmark::ClobberMemory();
+    }
+    if(!std::is_sorted(relation.begin(), relation.end(), [](const CastRelation& a, const CastRelation& b) {return a.movieId < b.movieId;})) {
+        state.SkipWithError("merge_sort did not sort");
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * n * sizeof(CastRelation)));
+    setWorkingSet(state, 2 * n * sizeof(CastRelation)); // merge copies every level into a temporary
+}
+
+int main(int argc, char** argv) {
+    const auto hardwareThreads = static_cast<int64_t>(std::max(1u, std::jthread::hardware_concurrency()));
+    benchmark::RegisterBenchmark("merge_sort/cast", mergeSortCast)
+        ->ArgsProduct({workingSetElements(2 * sizeof(CastRelation), 3 * sizeof(CastRelation)), hardwareThreads > 1 ? std::vector<int64_t>{1, hardwareThreads} : std::vector<int64_t>{1}})
+        ->ArgNames({"tuples", "threads"})
+        ->UseRealTime()
+        ->Unit(benchmark::kMicrosecond);
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    addCacheContext();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
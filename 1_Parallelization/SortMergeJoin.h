@@ -13,7 +13,6 @@
 #include <thread>
 #include <ranges>
 #include <algorithm>
-#include <execution>
 #include <iterator>
 #include <iostream>
 #include <vector>
@@ -0,0 +1,48 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        https://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+ * Benchmarks every join engine of this stage on synthetic relations, see JoinBenchmark.h:
+ *
+ *   ./2_Memory_Hierarchy_BENCHMARK --benchmark_filter='PHJ/zipf' --benchmark_out=results.json --benchmark_out_format=json
+ *
+ * The pipelined join streams csv files of the same relations from the temp directory, so its runtime includes parsing.
+ */
+
+#include "JoinUtils.hpp"
+#include "HashJoin.h"
+#include "SortMergeJoin.h"
+#include "PipelinedJoin.h"
+#include "TitleIndex.h"
+#include "JoinBenchmark.h"
+
+#include <vector>
+
+using Relations = BenchmarkRelations<CastRelation, TitleRelation>;
+
+int main(int argc, char** argv) {
+    const std::vector<JoinBenchmarkEngine<CastRelation, TitleRelation, ResultRelation>> engines = {
+        {"SHJ_MAP", [](const Relations& r, int) {return performSHJ_MAP(r.cast, r.title);}, false},
+        {"SHJ_UNORDERED_MAP", [](const Relations& r, int) {return performSHJ_UNORDERED_MAP(r.cast, r.title);}, false},
+        {"CHJ_MAP", [](const Relations& r, int threads) {return performCHJ_MAP(r.cast, r.title, threads);}, true},
+        {"CacheSizedHJ", [](const Relations& r, int threads) {return performCacheSizedThreadedHashJoin(r.cast, r.title, threads);}, true},
+        {"PHJ", [](const Relations& r, int threads) {return performPrefetchHashJoin(r.cast, r.title, threads);}, true},
+        {"NOP", [](const Relations& r, int threads) {return performNoPartitionHashJoin(r.cast, r.title, threads);}, true},
+        {"TitleIndex", [](const Relations& r, int threads) {return TitleIndex::build(r.title, threads).probe(r.cast, threads);}, true},
+        {"SMJ_presorted", [](const Relations& r, int) {return performSortMergeJoin(r.sortedCast, r.sortedTitle);}, false, true},
+        {"TSMJ_presorted", [](const Relations& r, int threads) {return performThreadedSortJoin(r.sortedCast, r.sortedTitle, threads);}, true, true},
+        {"PipelinedJoin", [](const Relations& r, int threads) {return performPipelinedJoin(r.castPath, r.titlePath, threads);}, true, false, true},
+    };
+    return runJoinBenchmarks(argc, argv, engines);
+}
@@ -5,8 +5,74 @@
 #ifndef PPDS_2_MEMORY_HIERARCHY_CUSTOMALLOCATOR_H
 #define PPDS_2_MEMORY_HIERARCHY_CUSTOMALLOCATOR_H
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdlib>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include <sys/mman.h>
+#include <omp.h>
+
+static constexpr const std::size_t PAGE_SIZE = 4096;
+static constexpr const std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/**
+ * @brief allocations of at least this many bytes are backed by huge pages, smaller ones are not worth a 2 MiB page
+ */
+static constexpr const std::size_t HUGE_PAGE_THRESHOLD = HUGE_PAGE_SIZE;
+
+[[noreturn]] inline void throwBadAlloc() {
+#if defined(__cpp_exceptions)
+    throw std::bad_alloc();
+#else
+    std::cerr << "Error: Out of memory" << std::endl;
+    std::abort();
+#endif
+}
+
+inline std::size_t roundUpToHugePages(const std::size_t bytes) {
+    return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+/**
+ * @brief maps bytes rounded up to 2 MiB. Tries explicit huge pages first (MAP_HUGETLB, needs reserved pages in
+ * /proc/sys/vm/nr_hugepages) and falls back to normal pages with a transparent huge page hint.
+ * The pages are not touched, so they are placed on the NUMA node of the thread that writes them first.
+ */
+inline void* allocateHugePages(const std::size_t bytes) {
+    const auto size = roundUpToHugePages(bytes);
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(p != MAP_FAILED) {
+        return p;
+    }
+    p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(p == MAP_FAILED) {
+        return nullptr;
+    }
+    madvise(p, size, MADV_HUGEPAGE);
+    return p;
+}
+
+inline void freeHugePages(void* p, const std::size_t bytes) {
+    munmap(p, roundUpToHugePages(bytes));
+}
+
+/**
+ * @brief writes one byte per page with a static OpenMP schedule, so that every page lands on the NUMA node of the
+ * thread that later processes the same part of the buffer with a static schedule
+ */
+inline void firstTouch(void* p, const std::size_t bytes, const int numThreads = omp_get_max_threads()) {
+    auto* bytesPtr = static_cast<volatile char*>(p);
+    const auto numPages = static_cast<int64_t>((bytes + PAGE_SIZE - 1) / PAGE_SIZE);
+    #pragma omp parallel for schedule(static) num_threads(numThreads)
+    for(int64_t page = 0; page < numPages; ++page) {
+        bytesPtr[page * PAGE_SIZE] = 0;
+    }
+}
 
 template<typename T>
 class MallocAllocator {
@@ -21,11 +87,11 @@ public:
         if(n==0) {
             return nullptr;
         } if (n > static_cast<std::size_t>(-1) / sizeof(T)) {
-            throw std::bad_alloc();
+            throwBadAlloc();
         }
         void* p = malloc(n * sizeof(T));
         if (!p) {
-            throw std::bad_alloc();
+            throwBadAlloc();
         }
         return static_cast<T*>(p);
     }
@@ -35,8 +101,7 @@ public:
 
     template<typename U, typename... Args>
     void construct(U* p, Args&&... args) {
-        std::cout << "Constructing with Args" << std::endl;
-        //::new ((void*)p) U();
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
     }
     template <typename U>
     void destroy(U* p) {
@@ -50,4 +115,169 @@ bool operator==(const MallocAllocator<T>&, const MallocAllocator<U>&) { return t
 template <typename T, typename U>
 bool operator!=(const MallocAllocator<T>&, const MallocAllocator<U>&) { return false; }
 
+/**
+ * @brief allocator for the large relation, result and partition buffers. Buffers of at least HUGE_PAGE_THRESHOLD bytes
+ * are mapped on 2 MiB pages, which cuts TLB misses of random probes, and are first-touched in parallel so their pages
+ * are spread over the NUMA nodes the same way a static schedule spreads the work.
+ */
+template<typename T>
+class HugePageAllocator {
+public:
+    using value_type = T;
+    HugePageAllocator() = default;
+
+    template<typename U>
+    HugePageAllocator(const HugePageAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if(n == 0) {
+            return nullptr;
+        } if(n > static_cast<std::size_t>(-1) / sizeof(T)) {
+            throwBadAlloc();
+        }
+        const auto bytes = n * sizeof(T);
+        void* p;
+        if(bytes >= HUGE_PAGE_THRESHOLD) {
+            p = allocateHugePages(bytes);
+            if(p) {
+                firstTouch(p, bytes);
+            }
+        } else {
+            p = malloc(bytes);
+        }
+        if(!p) {
+            throwBadAlloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if(!p) {
+            return;
+        }
+        const auto bytes = n * sizeof(T);
+        if(bytes >= HUGE_PAGE_THRESHOLD) {
+            freeHugePages(p, bytes);
+        } else {
+            free(p);
+        }
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return true; }
+
+template <typename T, typename U>
+bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return false; }
+
+/**
+ * @brief bump pointer arena on huge page backed blocks. Allocating is a pointer increment, single allocations are
+ * never freed, instead reset() releases everything at once and keeps the blocks for the next round.
+ * An arena is not thread safe, use one per thread.
+ */
+class Arena {
+public:
+    explicit Arena(const std::size_t blockSize = HUGE_PAGE_SIZE) : blockSize(roundUpToHugePages(blockSize)) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() {
+        for(const auto& block: blocks) {
+            freeHugePages(block.data, block.size);
+        }
+    }
+
+    void* allocate(const std::size_t bytes, const std::size_t alignment = alignof(std::max_align_t)) {
+        while(true) {
+            if(current < blocks.size()) {
+                auto& block = blocks[current];
+                const auto start = (offset + alignment - 1) & ~(alignment - 1);
+                if(start + bytes <= block.size) {
+                    offset = start + bytes;
+                    return static_cast<char*>(block.data) + start;
+                }
+                if(current + 1 < blocks.size()) { // reuse a block kept by reset
+                    ++current;
+                    offset = 0;
+                    continue;
+                }
+            }
+            const auto size = std::max(blockSize, roundUpToHugePages(bytes + alignment));
+            void* data = allocateHugePages(size);
+            if(!data) {
+                throwBadAlloc();
+            }
+            blocks.emplace_back(data, size);
+            current = blocks.size() - 1;
+            offset = 0;
+        }
+    }
+
+    /**
+     * @brief invalidates all allocations, the blocks stay mapped
+     */
+    void reset() {
+        current = 0;
+        offset = 0;
+    }
+
+    [[nodiscard]] std::size_t capacity() const {
+        std::size_t capacity = 0;
+        for(const auto& block: blocks) {
+            capacity += block.size;
+        }
+        return capacity;
+    }
+
+private:
+    struct Block {
+        void* data;
+        std::size_t size;
+    };
+
+    const std::size_t blockSize;
+    std::vector<Block> blocks;
+    std::size_t current = 0;
+    std::size_t offset = 0;
+};
+
+/**
+ * @brief standard allocator interface on top of an Arena, deallocate is a no-op and memory comes back with Arena::reset
+ */
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(Arena& arena) noexcept : arena(&arena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(std::size_t n) {
+        if(n > static_cast<std::size_t>(-1) / sizeof(T)) {
+            throwBadAlloc();
+        }
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) noexcept {}
+
+    template<typename U>
+    friend class ArenaAllocator;
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena == other.arena; }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena != other.arena; }
+
+private:
+    Arena* arena;
+};
+
+template<typename T>
+using HugePageVector = std::vector<T, HugePageAllocator<T>>;
+
 #endif //PPDS_2_MEMORY_HIERARCHY_CUSTOMALLOCATOR_H
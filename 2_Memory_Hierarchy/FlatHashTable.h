@@ -0,0 +1,119 @@
+#ifndef PPDS_2_MEMORY_HIERARCHY_FLATHASHTABLE_H
+#define PPDS_2_MEMORY_HIERARCHY_FLATHASHTABLE_H
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+#include <omp.h>
+
+#include "JoinUtils.hpp"
+#include "CustomAllocator.h"
+
+/**
+ * @brief open addressing hash table on titleId with linear probing, for build sides far larger than the caches.
+ * A slot is 8 bytes (key and row index into the title relation), so one cache line holds eight slots and a probe
+ * usually costs a single miss, which the prefetching probe loops hide. Duplicate keys get their own slots, a lookup
+ * walks the cluster until the first empty slot. The table is at most half full.
+ */
+class FlatTitleTable {
+public:
+    static constexpr uint32_t EMPTY = std::numeric_limits<uint32_t>::max();
+
+    struct Slot {
+        int32_t key;
+        uint32_t row; ///< index into the title relation, EMPTY if the slot is free
+    };
+
+    /**
+     * @param numThreads threads that build the table, with more than one all of them insert into the shared table
+     */
+    explicit FlatTitleTable(const std::span<const TitleRelation> titleRelation, const int numThreads = 1)
+        : titles(titleRelation),
+          bits(std::countr_zero(std::bit_ceil(std::max<std::size_t>(16, titleRelation.size() * 2)))),
+          mask((std::size_t(1) << bits) - 1),
+          slots(std::size_t(1) << bits, Slot{0, EMPTY}) {
+        if(numThreads <= 1) {
+            for(std::size_t row = 0; row < titles.size(); ++row) {
+                insert(titles[row].titleId, static_cast<uint32_t>(row));
+            }
+            return;
+        }
+        #pragma omp parallel for schedule(static) num_threads(numThreads)
+        for(std::size_t row = 0; row < titles.size(); ++row) {
+            insertConcurrent(titles[row].titleId, static_cast<uint32_t>(row));
+        }
+    }
+
+    void insert(const int32_t key, const uint32_t row) {
+        auto slot = slotOf(key);
+        while(slots[slot].row != EMPTY) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = Slot{key, row};
+    }
+
+    /**
+     * @brief insert that may run concurrently with other inserts, but not with lookups. A slot is claimed with a CAS
+     * on its row, a thread that loses the race moves on to the next slot like on any other collision. The key is a
+     * plain store, the barrier at the end of the build publishes it to the probing threads.
+     */
+    void insertConcurrent(const int32_t key, const uint32_t row) {
+        auto slot = slotOf(key);
+        while(true) {
+            std::atomic_ref<uint32_t> slotRow(slots[slot].row);
+            uint32_t expected = EMPTY;
+            if(slotRow.load(std::memory_order_relaxed) == EMPTY && slotRow.compare_exchange_strong(expected, row, std::memory_order_relaxed)) {
+                slots[slot].key = key;
+                return;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    /**
+     * @brief home slot of key, the address to prefetch before calling forEachMatch
+     */
+    [[nodiscard]] std::size_t slotOf(const int32_t key) const {
+        return homeSlot(key, bits);
+    }
+
+    /**
+     * @brief home slot of key in a table of 2^bits slots
+     */
+    [[nodiscard]] static std::size_t homeSlot(const int32_t key, const std::size_t bits) {
+        // fibonacci hashing, the high bits of the product are well mixed even for dense keys
+        return static_cast<std::size_t>((static_cast<uint64_t>(static_cast<uint32_t>(key)) * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+    }
+
+    void prefetch(const std::size_t slot) const {
+        __builtin_prefetch(&slots[slot], 0, 1);
+    }
+
+    /**
+     * @brief calls f(title) for every title with the given key, starting at its home slot
+     */
+    template<typename F>
+    void forEachMatch(std::size_t slot, const int32_t key, F&& f) const {
+        while(slots[slot].row != EMPTY) {
+            if(slots[slot].key == key) {
+                f(titles[slots[slot].row]);
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    [[nodiscard]] std::size_t capacity() const { return slots.size(); }
+
+    [[nodiscard]] std::span<const Slot> data() const { return slots; }
+
+private:
+    std::span<const TitleRelation> titles;
+    std::size_t bits;
+    std::size_t mask;
+    HugePageVector<Slot> slots;
+};
+
+#endif //PPDS_2_MEMORY_HIERARCHY_FLATHASHTABLE_H
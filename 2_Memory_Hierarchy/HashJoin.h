@@ -6,17 +6,19 @@
 #define PPDS_PARALLELISM_HASHJOIN_H
 
 
+#include <array>
+#include <bit>
 #include <map>
 #include <unordered_map>
 #include <span>
 #include <thread>
 #include <algorithm>
-#include <condition_variable>
 #include <mutex>
-#include <queue>
+#include <omp.h>
 
 #include "JoinUtils.hpp"
-#include "generated_variables.h"
+#include "FlatHashTable.h"
+#include "CustomAllocator.h"
 
 /**
  * Enum Class to select which type of hash-join to execute
@@ -26,8 +28,18 @@ enum class HashJoinType : uint8_t {
     SHJ_MAP = 1, ///< single-threaded-hash-join on a std::map
     SHJ_UNORDERED_MAP = 2, ///< single-threaded-hash-join on a std::unordered_map
     CHJ_MAP = 3, ///< multithreaded-hash-join where the dataset is divide into size / numthreads chunks for the threads
+    PHJ = 4, ///< multithreaded-hash-join on one flat table, probes are prefetched in groups
+    NOP = 5, ///< no partitioning hash-join, all threads build and probe one shared flat table
 };
 
+static constexpr const std::size_t PREFETCH_GROUP_SIZE = 16; ///< independent probes in flight per thread
+
+/**
+ * @brief the matches one thread of PHJ and NOP collects before they are materialized. Once a buffer outgrows
+ * HUGE_PAGE_THRESHOLD it moves to huge pages, first touched by the thread that fills it.
+ */
+using LocalMatches = std::vector<std::pair<const CastRelation*, const TitleRelation*>, HugePageAllocator<std::pair<const CastRelation*, const TitleRelation*>>>;
+
 
 
 std::vector<ResultRelation> performSHJ_MAP(const std::vector<CastRelation>& leftRelation, const std::vector<TitleRelation>& rightRelation) {
@@ -99,91 +111,195 @@ std::vector<ResultRelation> performCHJ_MAP(const std::vector<CastRelation>& left
     return results;
 
 }
-static const size_t HASHMAP_SIZE = L2_CACHE_SIZE / (sizeof(CastRelation*) + sizeof(int32_t));
-
-struct ThreadArgs {
-    int threadId;
-    std::queue<std::span<const TitleRelation>>& chunks;
-    std::mutex& m_chunks;
-    std::condition_variable& cv_queue;
-    std::vector<ResultRelation>& results;
-    std::mutex& m_results;
-    const std::vector<CastRelation>& leftRelation;
-    std::atomic_bool& stop;
-};
+static const size_t HASHMAP_SIZE = HardwareInfo::get().hashMapEntries(sizeof(CastRelation*) + sizeof(int32_t));
 
-void workerThreadChunk(std::unique_ptr<ThreadArgs> args) {
-    while(!args.get()->stop || !args.get()->chunks.empty()) {
-        std::unique_lock l_chunks(args.get()->m_chunks);
-        args.get()->cv_queue.wait(l_chunks, [&args] {return args->stop || !args->chunks.empty();});
-        if(!args->chunks.empty()) {
-            auto chunk = args.get()->chunks.front();
-            args->chunks.pop();
-            l_chunks.unlock();
-            // Build HashMap
-            std::unordered_map<int32_t, const TitleRelation*> map;
-            map.reserve(chunk.size());
-            std::ranges::for_each(chunk, [&map](const TitleRelation& record) {map[record.titleId] = &record;});
-            // Probe HashMap
-            std::ranges::for_each(args->leftRelation, [&map, &args](const CastRelation& record) {
-                if(map.contains(record.movieId)) {
-                    std::lock_guard l_results(args->m_results);
-                    args->results.emplace_back(createResultTuple(record, *map[record.movieId]));
+/**
+ * @brief chunk a key is routed to, build and probe side use the same function so matching tuples meet in one chunk
+ */
+inline std::size_t chunkOf(const int32_t key, const std::size_t bits) {
+    return bits == 0 ? 0 : static_cast<std::size_t>((static_cast<uint32_t>(key) * 0x9E3779B1U) >> (32 - bits));
+}
+
+/**
+ * @brief pointers to all records of relation grouped by chunkOf(key), chunk i is [offsets[i], offsets[i + 1]).
+ * One histogram pass and one scatter pass, both parallel with the same static schedule, so each thread writes its
+ * records into its own precomputed range of every chunk and the order within a chunk follows the relation.
+ */
+template<typename Relation, typename KeyOf>
+void routeToChunks(const std::vector<Relation>& relation, KeyOf keyOf, const std::size_t bits, const int numThreads,
+                   std::vector<const Relation*>& routed, std::vector<std::size_t>& offsets) {
+    const std::size_t numChunks = std::size_t(1) << bits;
+    std::vector<std::size_t> histograms(numThreads * numChunks, 0);
+    routed.resize(relation.size());
+    offsets.assign(numChunks + 1, 0);
+    #pragma omp parallel num_threads(numThreads)
+    {
+        const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+        auto* histogram = histograms.data() + thread * numChunks;
+        #pragma omp for schedule(static)
+        for(std::size_t i = 0; i < relation.size(); ++i) {
+            ++histogram[chunkOf(keyOf(relation[i]), bits)];
+        }
+        // implicit barrier of omp for, all histograms are complete here
+        #pragma omp single
+        {
+            std::size_t position = 0;
+            for(std::size_t chunk = 0; chunk < numChunks; ++chunk) {
+                offsets[chunk] = position;
+                for(std::size_t t = 0; t < static_cast<std::size_t>(numThreads); ++t) {
+                    const auto count = histograms[t * numChunks + chunk];
+                    histograms[t * numChunks + chunk] = position;
+                    position += count;
                 }
-            });
+            }
+            offsets[numChunks] = position;
+        }
+        #pragma omp for schedule(static)
+        for(std::size_t i = 0; i < relation.size(); ++i) {
+            routed[histogram[chunkOf(keyOf(relation[i]), bits)]++] = &relation[i];
         }
     }
 }
 
+/**
+ * @brief builds the hash map of one chunk, it holds at most HASHMAP_SIZE entries on average and stays in L2, and probes
+ * it with the cast records routed to the same chunk only
+ */
+inline void probeChunk(const std::size_t chunk, std::unordered_multimap<int32_t, const TitleRelation*>& map, LocalMatches& localResults,
+                       const std::vector<const CastRelation*>& castChunks, const std::vector<std::size_t>& castOffsets,
+                       const std::vector<const TitleRelation*>& titleChunks, const std::vector<std::size_t>& titleOffsets) {
+    map.clear();
+    map.reserve(titleOffsets[chunk + 1] - titleOffsets[chunk]);
+    for(auto i = titleOffsets[chunk]; i < titleOffsets[chunk + 1]; ++i) {
+        map.emplace(titleChunks[i]->titleId, titleChunks[i]);
+    }
+    for(auto i = castOffsets[chunk]; i < castOffsets[chunk + 1]; ++i) {
+        const CastRelation* record = castChunks[i];
+        const auto [begin, end] = map.equal_range(record->movieId);
+        for(auto it = begin; it != end; ++it) {
+            localResults.emplace_back(record, it->second);
+        }
+    }
+}
+
+/**
+ * @brief cache conscious hash join: both relations are routed into as many chunks as are needed for every chunk's
+ * hash map to fit into L2 (and at least one per thread). Each thread builds the map of a chunk and probes it only
+ * with the cast records of the same chunk, so every cast record is read once instead of once per chunk.
+ */
 std::vector<ResultRelation> performCacheSizedThreadedHashJoin(const std::vector<CastRelation>& leftRelation, const std::vector<TitleRelation>& rightRelation, const int numThreads = std::jthread::hardware_concurrency()) {
-    if(HASHMAP_SIZE > rightRelation.size() / numThreads) {
-        // Cache Size is too large to split into more than hashmapSize * numThreads
-        std::cout << "Performing CHJ as it is not possible to create <= numThread cache sized HashMaps!" << std::endl;
-        return performCHJ_MAP(leftRelation, rightRelation, numThreads);
+    const std::size_t minChunks = std::max<std::size_t>(numThreads, (rightRelation.size() + HASHMAP_SIZE - 1) / HASHMAP_SIZE);
+    const std::size_t bits = std::bit_width(minChunks - 1);
+    const std::size_t numChunks = std::size_t(1) << bits;
+
+    std::vector<const CastRelation*> castChunks;
+    std::vector<std::size_t> castOffsets;
+    std::vector<const TitleRelation*> titleChunks;
+    std::vector<std::size_t> titleOffsets;
+    routeToChunks(leftRelation, [](const CastRelation& record) {return record.movieId;}, bits, numThreads, castChunks, castOffsets);
+    routeToChunks(rightRelation, [](const TitleRelation& record) {return record.titleId;}, bits, numThreads, titleChunks, titleOffsets);
+
+    std::vector<std::size_t> chunks;
+    for(std::size_t chunk = 0; chunk < numChunks; ++chunk) {
+        if(titleOffsets[chunk] != titleOffsets[chunk + 1] && castOffsets[chunk] != castOffsets[chunk + 1]) {
+            chunks.push_back(chunk);
+        }
     }
-    std::vector<ResultRelation> results;
-    std::mutex m_results;
-    std::vector<std::jthread> threads;
-    std::atomic_bool stop = false;
-    std::queue<std::span<const TitleRelation>> chunks;
-    std::mutex m_chunks;
-    std::condition_variable cv_queue;
-    results.reserve(leftRelation.size());
-    size_t numChunks = 0;
 
-    threads.reserve(numThreads);
-    for(int i = 0; i < numThreads; ++i) {
-        threads.emplace_back(workerThreadChunk, std::make_unique<ThreadArgs>(i, std::ref(chunks), std::ref(m_chunks),
-                                                                                          std::ref(cv_queue), std::ref(results),
-                                                                                          std::ref(m_results), std::ref(leftRelation),
-                                                                                          std::ref(stop)));
-    };
+    std::vector<LocalMatches> localResults(numThreads);
+    std::vector<ResultRelation> results;
+    #pragma omp parallel num_threads(numThreads)
+    {
+        std::unordered_multimap<int32_t, const TitleRelation*> map;
+        auto& matches = localResults[static_cast<std::size_t>(omp_get_thread_num())];
+        #pragma omp for schedule(dynamic, 1)
+        for(std::size_t i = 0; i < chunks.size(); ++i) {
+            probeChunk(chunks[i], map, matches, castChunks, castOffsets, titleChunks, titleOffsets);
+        }
+        materializeLocalResults(localResults, results);
+    }
+    std::cout << "Created " << numChunks << " Chunks" << std::endl;
+    return results;
+}
 
-    auto chunkStart = rightRelation.begin();
-    auto chunkEnd = rightRelation.begin();
-    while(chunkEnd != rightRelation.end()) {
-        if((unsigned long)std::distance(chunkEnd, rightRelation.end()) > HASHMAP_SIZE) {
-            chunkEnd = std::next(chunkEnd, HASHMAP_SIZE);
-        } else {
-            chunkEnd = rightRelation.end();
+/**
+ * @brief probes table with every record of leftRelation using group prefetching: the home slots of a whole group are
+ * hashed and prefetched first, then the group is looked up. The misses of a group overlap instead of each probe
+ * waiting for DRAM on its own.
+ */
+inline void probeGroupPrefetch(const FlatTitleTable& table, const std::span<const CastRelation> leftRelation, LocalMatches& localResults) {
+    std::array<std::size_t, PREFETCH_GROUP_SIZE> slots{};
+    for(std::size_t base = 0; base < leftRelation.size(); base += PREFETCH_GROUP_SIZE) {
+        const auto groupSize = std::min(PREFETCH_GROUP_SIZE, leftRelation.size() - base);
+        for(std::size_t i = 0; i < groupSize; ++i) {
+            slots[i] = table.slotOf(leftRelation[base + i].movieId);
+            table.prefetch(slots[i]);
         }
-        const std::span<const TitleRelation> chunkSpan(std::to_address(chunkStart), std::to_address(chunkEnd));
-        {
-            std::scoped_lock l_chunks(m_chunks);
-            chunks.emplace(chunkSpan);
-            cv_queue.notify_one();
+        for(std::size_t i = 0; i < groupSize; ++i) {
+            const CastRelation& record = leftRelation[base + i];
+            table.forEachMatch(slots[i], record.movieId, [&localResults, &record](const TitleRelation& title) {
+                localResults.emplace_back(&record, &title);
+            });
         }
-        ++numChunks;
-        chunkStart = chunkEnd;
     }
+}
+
+/**
+ * @brief unpartitioned hash join for build sides that do not fit into the caches: one flat table over the whole
+ * rightRelation, probed in parallel with group prefetching, so the probe is bound by memory bandwidth rather than latency
+ * @param allocator of the returned vector, e.g. a HugePageAllocator or an ArenaAllocator that is reset between joins
+ */
+template<typename ResultAllocator = std::allocator<ResultRelation>>
+std::vector<ResultRelation, ResultAllocator> performPrefetchHashJoin(const std::span<const CastRelation> leftRelation, const std::span<const TitleRelation> rightRelation,
+                                                                     const int numThreads = std::jthread::hardware_concurrency(),
+                                                                     const ResultAllocator& allocator = ResultAllocator()) {
+    const FlatTitleTable table(rightRelation);
+
+    std::vector<LocalMatches> localResults(numThreads);
+    std::vector<ResultRelation, ResultAllocator> results(allocator);
+    const auto numGroups = (leftRelation.size() + PREFETCH_GROUP_SIZE - 1) / PREFETCH_GROUP_SIZE;
+    #pragma omp parallel num_threads(numThreads)
+    {
+        const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+        auto& matches = localResults[thread];
+        #pragma omp for schedule(dynamic, 256)
+        for(std::size_t group = 0; group < numGroups; ++group) {
+            const auto begin = group * PREFETCH_GROUP_SIZE;
+            const auto size = std::min(PREFETCH_GROUP_SIZE, leftRelation.size() - begin);
+            probeGroupPrefetch(table, leftRelation.subspan(begin, size), matches);
+        }
+        materializeLocalResults(localResults, results);
+    }
+    return results;
+}
 
+/**
+ * @brief no partitioning hash join: all threads insert rightRelation into one shared, pre-sized open addressing table
+ * with CAS inserts, then all threads probe the same table. Neither partitioning passes nor repeated probe scans, the
+ * baseline the partitioned and cache sized joins are measured against.
+ * @param allocator of the returned vector, see performPrefetchHashJoin
+ */
+template<typename ResultAllocator = std::allocator<ResultRelation>>
+std::vector<ResultRelation, ResultAllocator> performNoPartitionHashJoin(const std::span<const CastRelation> leftRelation, const std::span<const TitleRelation> rightRelation,
+                                                                        const int numThreads = std::jthread::hardware_concurrency(),
+                                                                        const ResultAllocator& allocator = ResultAllocator()) {
+    const FlatTitleTable table(rightRelation, numThreads);
 
-    stop.store(true);
-    cv_queue.notify_all();
-    for(auto& thread: threads) {
-        thread.join();
+    std::vector<LocalMatches> localResults(numThreads);
+    std::vector<ResultRelation, ResultAllocator> results(allocator);
+    #pragma omp parallel num_threads(numThreads)
+    {
+        const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+        auto& matches = localResults[thread];
+        #pragma omp for schedule(static)
+        for(std::size_t i = 0; i < leftRelation.size(); ++i) {
+            const CastRelation& record = leftRelation[i];
+            table.forEachMatch(table.slotOf(record.movieId), record.movieId, [&matches, &record](const TitleRelation& title) {
+                matches.emplace_back(&record, &title);
+            });
+        }
+        materializeLocalResults(localResults, results);
     }
-    std::cout << "Created " << numChunks << " Chunks" << std::endl;
     return results;
 }
 
@@ -208,6 +324,12 @@ std::vector<ResultRelation> performHashJoin(enum HashJoinType joinType, const st
         case CHJ_MAP:{
             return performCHJ_MAP(leftRelation, rightRelation, numThreads);
         }
+        case PHJ: {
+            return performPrefetchHashJoin(leftRelation, rightRelation, numThreads);
+        }
+        case NOP: {
+            return performNoPartitionHashJoin(leftRelation, rightRelation, numThreads);
+        }
     }
     return {};
 }
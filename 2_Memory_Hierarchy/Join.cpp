@@ -22,8 +22,14 @@
 #include "NestedLoopJoin.h"
 #include "SortMergeJoin.h"
 #include "ThreadedLoad.h"
-#include "generated_variables.h"
 #include "CustomAllocator.h"
+#include "RingBuffer.h"
+#include "PipelinedJoin.h"
+#include "TitleIndex.h"
+#include "DataGenerator.h"
+#include "DifferentialHarness.h"
+#include <filesystem>
+#include <numeric>
 
 class MemoryHierarchyTest : public ::testing::Test {
 protected:
@@ -33,11 +39,14 @@ protected:
     const std::vector<TitleRelation> rightRelationSorted;
 
     void SetUp() override {
-        auto l_v = loadCastRelation(DATA_DIRECTORY + std::string("cast_info_no_matches.csv"));
+        RelationSpec spec; // half of the cast tuples find a title, so the joins have rows to get right
+        spec.numCasts = 1 << 16;
+        spec.numTitles = 1 << 14;
+        spec.matchRate = 0.5;
+        auto [l_v, r_v] = generateRelations<CastRelation, TitleRelation>(spec);
         const_cast<std::vector<CastRelation>&>(leftRelation) = l_v;
         sortCastRelations(l_v);
         const_cast<std::vector<CastRelation>&>(leftRelationSorted) = l_v;
-        auto r_v = loadTitleRelation(DATA_DIRECTORY + std::string("title_info_uniform.csv"));
         const_cast<std::vector<TitleRelation>&>(rightRelation) = r_v;
         sortTitleRelations(r_v);
         const_cast<std::vector<TitleRelation>&>(rightRelationSorted) = r_v;
@@ -61,6 +70,19 @@ TEST_F(MemoryHierarchyTest, TestJoiningTuples) {
 
     timer.pause();
     std::cout << "Result size: " << results.size() << std::endl;
+    const auto expected = performSHJ_UNORDERED_MAP(leftRelation, rightRelation);
+    ASSERT_GT(expected.size(), 0u);
+    ASSERT_LT(expected.size(), leftRelation.size());
+    ASSERT_EQ(results.size(), expected.size());
+    auto ids = [](const std::vector<ResultRelation>& relation) {
+        std::vector<std::pair<int32_t, int32_t>> pairs;
+        for(const auto& record: relation) {
+            pairs.emplace_back(record.castInfoId, record.titleId);
+        }
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    };
+    ASSERT_EQ(ids(results), ids(expected));
     /*
     for(int i = results.size(); i > results.size() - 1999; --i) {
         std::cout << resultRelationToString(results[i]) << '\n';
@@ -71,204 +93,673 @@ TEST_F(MemoryHierarchyTest, TestJoiningTuples) {
 }
 
 /**
- * Tests if the join algorithmus returns the correct amount of Tuples, and that the individual tuples are part of a correct
- * join algorithm, using uniform data!
+ * Runs every join engine of this stage on the same generated relations and checks its results against a reference join
+ * as multisets, which also catches lost and duplicated rows of one to many matches.
  */
-TEST_F(MemoryHierarchyTest, TestAmoutUniform) {
-    std::cout   << "##########################################################################################\n"
-                << "# Testing if join algorithm contains wrong or duplicate records when using uniform data! #\n"
-                << "##########################################################################################\n";
-    const auto leftRelation = load<CastRelation>(DATA_DIRECTORY + std::string("cast_info_uniform.csv"), 20000);
-    const auto rightRelation = load<TitleRelation>(DATA_DIRECTORY + std::string("title_info_uniform.csv"), 20000);
-
-    size_t correctRecords = 0;
-    size_t duplicateRecords = 0;
-    size_t wrongRecords = 0;
-
-    std::vector<uint32_t> duplicateCastInfoIds;
-    std::vector<uint32_t> wrongCastInfoIds;
-
-    auto correctResults = performNestedLoopJoin(leftRelation, rightRelation);
-    std::unordered_map<uint32_t, const ResultRelation*> mapCorrect;
-    std::unordered_map<uint32_t, const ResultRelation*> found; // Used to make sure no record is duplicated
-    for(const auto& record : correctResults) {
-        mapCorrect[record.castInfoId] = &record;
-    }
-    auto sample = performJoin(leftRelation, rightRelation, 8);
-
-    for(const auto& record: sample) {
-        if(!mapCorrect.contains(record.castInfoId)) {
-            std::cout << "Found a record that should not be in results!\n" << resultRelationToString(record) << '\n' << std::endl;
-            wrongRecords += 1;
-            wrongCastInfoIds.emplace_back(record.castInfoId);
-            if(found.contains(record.castInfoId)) {
-                std::cout << "Found a duplicate record!\n" << resultRelationToString(record) << '\n' << std::endl;
-                duplicateRecords += 1;
-            } else {
-                found[record.castInfoId] = &record;
-            }
+TEST(DifferentialTest, TestEnginesMatchReference) {
+    DifferentialHarness<CastRelation, TitleRelation, ResultRelation> harness(4);
+    harness.add("SHJ_MAP", [](const auto& cast, const auto& title, int) {return performSHJ_MAP(cast, title);});
+    harness.add("SHJ_UNORDERED_MAP", [](const auto& cast, const auto& title, int) {return performSHJ_UNORDERED_MAP(cast, title);});
+    harness.add("CHJ_MAP", [](const auto& cast, const auto& title, int threads) {return performCHJ_MAP(cast, title, threads);});
+    harness.add("CacheSizedHJ", [](const auto& cast, const auto& title, int threads) {return performCacheSizedThreadedHashJoin(cast, title, threads);});
+    harness.add("PHJ", [](const auto& cast, const auto& title, int threads) {return performPrefetchHashJoin(cast, title, threads);});
+    harness.add("NOP", [](const auto& cast, const auto& title, int threads) {return performNoPartitionHashJoin(cast, title, threads);});
+    harness.add("TitleIndex", [](const auto& cast, const auto& title, int threads) {return TitleIndex::build(title, threads).probe(cast, threads);});
+    harness.add("SMJ", [](const auto& cast, const auto& title, int) {return performSortMergeJoin(cast, title);}, true);
+    harness.add("TSMJ", [](const auto& cast, const auto& title, int threads) {return performThreadedSortJoin(cast, title, threads);}, true);
+
+    for(const auto& outcome: runStandardDatasets(harness)) {
+        EXPECT_TRUE(outcome.correct) << outcome;
+    }
+    harness.print();
+
+    // SHJ_MAP, SHJ_UNORDERED_MAP and CHJ_MAP keep one title per titleId, the other engines join duplicate titleIds
+    DifferentialHarness<CastRelation, TitleRelation, ResultRelation> duplicates(4);
+    duplicates.add("CacheSizedHJ", [](const auto& cast, const auto& title, int threads) {return performCacheSizedThreadedHashJoin(cast, title, threads);});
+    duplicates.add("PHJ", [](const auto& cast, const auto& title, int threads) {return performPrefetchHashJoin(cast, title, threads);});
+    duplicates.add("NOP", [](const auto& cast, const auto& title, int threads) {return performNoPartitionHashJoin(cast, title, threads);});
+    duplicates.add("TitleIndex", [](const auto& cast, const auto& title, int threads) {return TitleIndex::build(title, threads).probe(cast, threads);});
+    duplicates.add("SMJ", [](const auto& cast, const auto& title, int) {return performSortMergeJoin(cast, title);}, true);
+    duplicates.add("TSMJ", [](const auto& cast, const auto& title, int threads) {return performThreadedSortJoin(cast, title, threads);}, true);
+    const auto relations = differentialDataset<CastRelation, TitleRelation>(KeyDistribution::UNIFORM, 1.0, 4);
+    for(const auto& outcome: duplicates.run("duplicatetitles", relations.cast, relations.title)) {
+        EXPECT_TRUE(outcome.correct) << outcome;
+    }
+    duplicates.print();
+}
+
+TEST(DifferentialTest, TestDetectsWrongResults) {
+    RelationSpec spec;
+    spec.numCasts = 1000;
+    spec.numTitles = 250;
+    const auto relations = generateRelations<CastRelation, TitleRelation>(spec);
+    DifferentialHarness<CastRelation, TitleRelation, ResultRelation> harness(2);
+    harness.add("DropsRow", [](const auto& cast, const auto& title, int) {
+        auto results = performSHJ_UNORDERED_MAP(cast, title);
+        results.pop_back();
+        return results;
+    });
+    harness.add("DuplicatesRow", [](const auto& cast, const auto& title, int) {
+        auto results = performSHJ_UNORDERED_MAP(cast, title);
+        results.emplace_back(results.front());
+        return results;
+    });
+    harness.add("CorruptsRow", [](const auto& cast, const auto& title, int) {
+        auto results = performSHJ_UNORDERED_MAP(cast, title);
+        results[results.size() / 2].note[0] ^= 1;
+        return results;
+    });
+    harness.add("Reversed", [](const auto& cast, const auto& title, int) {
+        auto results = performSHJ_UNORDERED_MAP(cast, title);
+        std::reverse(results.begin(), results.end());
+        return results;
+    });
+    const auto outcomes = harness.run("uniform", relations.cast, relations.title);
+    ASSERT_EQ(outcomes.size(), 4u);
+    ASSERT_FALSE(outcomes[0].correct);
+    ASSERT_EQ(outcomes[0].missingRows, 1u);
+    ASSERT_FALSE(outcomes[1].correct);
+    ASSERT_EQ(outcomes[1].unexpectedRows, 1u);
+    ASSERT_FALSE(outcomes[2].correct);
+    ASSERT_EQ(outcomes[2].missingRows, 1u);
+    ASSERT_EQ(outcomes[2].unexpectedRows, 1u);
+    ASSERT_TRUE(outcomes[3].correct); // order does not matter
+    ASSERT_EQ(outcomes[3].actualRows, spec.numCasts);
+}
+
+TEST(DifferentialTest, TestSortedInputWithEmptyCast) {
+    const auto relations = differentialDataset<CastRelation, TitleRelation>(KeyDistribution::UNIFORM, 1.0, 1, 0, 1000);
+    std::size_t titles = 0;
+    bool sorted = false;
+    DifferentialHarness<CastRelation, TitleRelation, ResultRelation> harness(2);
+    harness.add("SMJ", [&titles, &sorted](const auto& cast, const auto& title, int) {
+        titles = title.size();
+        sorted = std::is_sorted(title.begin(), title.end(), [](const TitleRelation& a, const TitleRelation& b) {return a.titleId < b.titleId;});
+        return performSortMergeJoin(cast, title);
+    }, true);
+    const auto outcomes = harness.run("emptycast", relations.cast, relations.title);
+    ASSERT_TRUE(outcomes[0].correct);
+    ASSERT_EQ(titles, relations.title.size());
+    ASSERT_TRUE(sorted);
+}
+
+TEST_F(MemoryHierarchyTest, TestChunkSize) {
+    for(size_t chunkSize = 2; chunkSize < (size_t)-1; chunkSize *= 2) {
+        std::cout << "Testing for chunkSize: " << chunkSize << std::endl;
+        for(int i = 0; i < 10; ++i) {
+            Timer timer("Run");
+            timer.start();
+            const auto results = performThreadedSortJoin(leftRelationSorted, rightRelationSorted);
+            timer.pause();
+            std::cout << "Run " << i << " with chunkSize: " << chunkSize << " took " << printString(timer) << std::endl;
         }
-        else {
-            if(found.contains(record.castInfoId)) {
-                std::cout << "Found a duplicate record!\n" << resultRelationToString(record) << '\n' << std::endl;
-                duplicateRecords += 1;
-            } else {
-                found[record.castInfoId] = &record;
+    }
+}
+
+
+
+
+
+
+TEST(RingBufferTest, TestSPSCOrder) {
+    SPSCRingBuffer<size_t, 64> buffer;
+    constexpr size_t NUM_ITEMS = 200000;
+    std::jthread producer([&buffer] {
+        for(size_t i = 0; i < NUM_ITEMS; ++i) {
+            buffer.push(i);
+        }
+        buffer.close();
+    });
+    size_t expected = 0;
+    size_t value;
+    while(buffer.pop(value)) {
+        ASSERT_EQ(value, expected++);
+    }
+    ASSERT_EQ(expected, NUM_ITEMS);
+}
+
+TEST(RingBufferTest, TestSPSCBatch) {
+    SPSCRingBuffer<size_t, 16> buffer;
+    constexpr size_t NUM_ITEMS = 100000;
+    std::jthread producer([&buffer] {
+        std::vector<size_t> batch(37);
+        for(size_t i = 0; i < NUM_ITEMS; i += batch.size()) {
+            batch.resize(std::min<size_t>(37, NUM_ITEMS - i));
+            std::iota(batch.begin(), batch.end(), i);
+            ASSERT_EQ(buffer.pushBatch(batch), batch.size());
+        }
+        buffer.close();
+    });
+    std::vector<size_t> batch(10);
+    size_t expected = 0;
+    while(const auto count = buffer.popBatch(batch)) {
+        for(size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(batch[i], expected++);
+        }
+    }
+    ASSERT_EQ(expected, NUM_ITEMS);
+}
+
+TEST(RingBufferTest, TestMPMC) {
+    RingBuffer<size_t> buffer;
+    constexpr size_t NUM_PRODUCERS = 4;
+    constexpr size_t NUM_CONSUMERS = 4;
+    constexpr size_t ITEMS_PER_PRODUCER = 50000;
+    std::vector<std::vector<size_t>> consumed(NUM_CONSUMERS);
+    {
+        std::vector<std::jthread> consumers;
+        for(size_t c = 0; c < NUM_CONSUMERS; ++c) {
+            consumers.emplace_back([&buffer, &consumed, c] {
+                size_t value;
+                while(buffer.pop(value)) {
+                    consumed[c].push_back(value);
+                }
+            });
+        }
+        {
+            std::vector<std::jthread> producers;
+            for(size_t p = 0; p < NUM_PRODUCERS; ++p) {
+                producers.emplace_back([&buffer, p] {
+                    for(size_t i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+                        buffer.push(p * ITEMS_PER_PRODUCER + i);
+                    }
+                });
             }
-            correctRecords += 1;
         }
+        buffer.close();
     }
-    std::cout << '\n';
-    std::cout << "Found " << correctRecords << " correct records!\n";
-    std::cout << "Found " << duplicateRecords << " duplicate records with the following CastInfoIds:\n";
-    for(const auto& id: duplicateCastInfoIds) {
-        std::cout << id << '\n';
+    std::vector<size_t> all;
+    for(const auto& values : consumed) {
+        // every producer's items arrive in order at each consumer
+        std::vector<size_t> last(NUM_PRODUCERS, 0);
+        for(const auto value : values) {
+            ASSERT_GE(value + 1, last[value / ITEMS_PER_PRODUCER]);
+            last[value / ITEMS_PER_PRODUCER] = value + 1;
+        }
+        all.insert(all.end(), values.begin(), values.end());
     }
-    std::cout << "Found " << wrongRecords << " wrong records with teh following CastInfoIds:\n";
-    for(const auto& id: wrongCastInfoIds) {
-        std::cout << id << '\n';
+    std::sort(all.begin(), all.end());
+    ASSERT_EQ(all.size(), NUM_PRODUCERS * ITEMS_PER_PRODUCER);
+    for(size_t i = 0; i < all.size(); ++i) {
+        ASSERT_EQ(all[i], i);
     }
-    std::cout << std::flush;
 }
 
+TEST(RingBufferTest, TestCloseWakesWaiters) {
+    RingBuffer<int> buffer;
+    std::atomic_int finished = 0;
+    {
+        std::vector<std::jthread> consumers;
+        for(int i = 0; i < 4; ++i) {
+            consumers.emplace_back([&buffer, &finished] {
+                int value;
+                while(buffer.pop(value)) {}
+                ++finished;
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        buffer.close();
+    }
+    ASSERT_EQ(finished, 4);
+    int value = 1;
+    ASSERT_FALSE(buffer.push(value));
+}
 
-/**
- * Tests if the join algorithmus returns the correct amount of Tuples, and that the individual tuples are part of a correct
- * join algorithm, using a dataset where each title record matches to one cast record!
- */
-TEST_F(MemoryHierarchyTest, TestAmoutOnlyMatches1to1) {
-    std::cout   << "##########################################################################################\n"
-                << "# Testing if join algorithm contains wrong or duplicate records when using uniform data! #\n"
-                << "##########################################################################################\n";
-    const auto leftRelation = load<CastRelation>(DATA_DIRECTORY + std::string("cast_info_matching.csv"), 20000);
-    const auto rightRelation = load<TitleRelation>(DATA_DIRECTORY + std::string("title_info_matching.csv"), 20000);
-
-    size_t correctRecords = 0;
-    size_t duplicateRecords = 0;
-    size_t wrongRecords = 0;
-
-    std::vector<uint32_t> duplicateCastInfoIds;
-    std::vector<uint32_t> wrongCastInfoIds;
-
-    auto correctResults = performNestedLoopJoin(leftRelation, rightRelation);
-    std::unordered_map<uint32_t, const ResultRelation*> mapCorrect;
-    std::unordered_map<uint32_t, const ResultRelation*> found; // Used to make sure no record is duplicated
-    for(const auto& record : correctResults) {
-        mapCorrect[record.castInfoId] = &record;
-    }
-    auto sample = performJoin(leftRelation, rightRelation, 8);
-
-    for(const auto& record: sample) {
-        if(!mapCorrect.contains(record.castInfoId)) {
-            std::cout << "Found a record that should not be in results!\n" << resultRelationToString(record) << '\n' << std::endl;
-            wrongRecords += 1;
-            wrongCastInfoIds.emplace_back(record.castInfoId);
-            if(found.contains(record.castInfoId)) {
-                std::cout << "Found a duplicate record!\n" << resultRelationToString(record) << '\n' << std::endl;
-                duplicateRecords += 1;
-            } else {
-                found[record.castInfoId] = &record;
+TEST(RingBufferTest, TestThreadedLoad) {
+    const auto path = std::filesystem::temp_directory_path() / "ppds_ringbuffer_cast_info.csv";
+    std::vector<CastRelation> expected;
+    {
+        std::ofstream file(path);
+        file << "castInfoId,personId,movieId,personRoleId,note,nrOrder,roleId\n";
+        for(int32_t i = 0; i < 50000; ++i) {
+            CastRelation record{};
+            record.castInfoId = i;
+            record.personId = i % 97;
+            record.movieId = i % 1013;
+            record.personRoleId = i % 7;
+            const auto note = "note " + std::to_string(i);
+            std::memcpy(record.note, note.c_str(), note.size() + 1);
+            record.nrOrder = i % 5;
+            record.roleId = i % 3;
+            expected.emplace_back(record);
+            file << castRelationToString(record) << (i + 1 < 50000 ? "\n" : "");
+        }
+    }
+    auto loaded = threadedLoadCastRelation(path, 4096);
+    std::filesystem::remove(path);
+    ASSERT_EQ(loaded.size(), expected.size());
+    std::sort(loaded.begin(), loaded.end(), [](const CastRelation& a, const CastRelation& b) {return a.castInfoId < b.castInfoId;});
+    for(size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(loaded[i].castInfoId, expected[i].castInfoId);
+        ASSERT_EQ(loaded[i].movieId, expected[i].movieId);
+        ASSERT_STREQ(loaded[i].note, expected[i].note);
+    }
+}
+
+TEST(RingBufferTest, TestThreadedSortJoin) {
+    std::vector<CastRelation> castRelation(40000);
+    std::vector<TitleRelation> titleRelation(2000);
+    for(int32_t i = 0; i < static_cast<int32_t>(castRelation.size()); ++i) {
+        castRelation[i].castInfoId = i;
+        castRelation[i].movieId = (i * 7919) % 2500;
+    }
+    for(int32_t i = 0; i < static_cast<int32_t>(titleRelation.size()); ++i) {
+        titleRelation[i].titleId = i;
+    }
+    sortCastRelations(castRelation);
+    auto expected = performNestedLoopJoin(castRelation, titleRelation);
+    auto results = performThreadedSortJoin(castRelation, titleRelation, 8);
+    std::sort(expected.begin(), expected.end());
+    std::sort(results.begin(), results.end());
+    ASSERT_EQ(results, expected);
+}
+
+TEST(PipelinedJoinTest, TestPipelinedJoin) {
+    const auto castPath = std::filesystem::temp_directory_path() / "ppds_pipelined_cast_info.csv";
+    const auto titlePath = std::filesystem::temp_directory_path() / "ppds_pipelined_title_info.csv";
+    std::vector<std::pair<int32_t, int32_t>> expected;
+    {
+        std::ofstream file(titlePath);
+        file << "titleId,title,imdbIndex,kindId,productionYear,imdbId,phoneticCode,episodeOfId,seasonNr,episodeNr,seriesYears,md5sum\n";
+        for(int32_t i = 0; i < 3000; i += 2) {
+            TitleRelation record{};
+            record.titleId = i;
+            const auto title = "title " + std::to_string(i);
+            std::memcpy(record.title, title.c_str(), title.size() + 1);
+            std::memcpy(record.imdbIndex, "I", 2);
+            record.kindId = i % 7;
+            std::memcpy(record.phoneticCode, "P", 2);
+            std::memcpy(record.seriesYears, "2000", 5);
+            std::memcpy(record.md5sum, "md5", 4);
+            file << titleRelationToString(record) << '\n';
+            if(i % 6 == 0) { // every third title exists twice
+                file << titleRelationToString(record) << '\n';
             }
         }
-        else {
-            if(found.contains(record.castInfoId)) {
-                std::cout << "Found a duplicate record!\n" << resultRelationToString(record) << '\n' << std::endl;
-                duplicateRecords += 1;
-            } else {
-                found[record.castInfoId] = &record;
+    }
+    {
+        std::ofstream file(castPath);
+        file << "castInfoId,personId,movieId,personRoleId,note,nrOrder,roleId\n";
+        for(int32_t i = 0; i < 100000; ++i) {
+            CastRelation record{};
+            record.castInfoId = i;
+            record.movieId = (i * 7919) % 4000;
+            std::memcpy(record.note, "note", 5);
+            if(record.movieId < 3000 && record.movieId % 2 == 0) {
+                expected.emplace_back(i, record.movieId);
+                if(record.movieId % 6 == 0) {
+                    expected.emplace_back(i, record.movieId);
+                }
             }
-            correctRecords += 1;
+            file << castRelationToString(record) << '\n';
         }
     }
-    std::cout << '\n';
-    std::cout << "Found " << correctRecords << " correct records!\n";
-    std::cout << "Found " << duplicateRecords << " duplicate records with the following CastInfoIds:\n";
-    for(const auto& id: duplicateCastInfoIds) {
-        std::cout << id << '\n';
+    const auto results = performPipelinedJoin(castPath, titlePath, 4);
+    const auto missingPath = std::filesystem::temp_directory_path() / "ppds_pipelined_missing.csv";
+    ASSERT_THROW(performPipelinedJoin(castPath, missingPath, 4), std::runtime_error);
+    ASSERT_THROW(performPipelinedJoin(missingPath, titlePath, 4), std::runtime_error);
+    ASSERT_THROW(threadedLoadCastRelation(missingPath, 4096), std::runtime_error);
+    std::filesystem::remove(castPath);
+    std::filesystem::remove(titlePath);
+
+    std::vector<std::pair<int32_t, int32_t>> joined;
+    for(const auto& record: results) {
+        ASSERT_EQ(std::string(record.title), "title " + std::to_string(record.titleId));
+        joined.emplace_back(record.castInfoId, record.titleId);
+    }
+    std::sort(joined.begin(), joined.end());
+    ASSERT_EQ(joined, expected);
+}
+
+TEST(AllocatorTest, TestMallocAllocatorConstructs) {
+    std::vector<std::string, MallocAllocator<std::string>> values;
+    for(int i = 0; i < 1000; ++i) {
+        values.emplace_back(std::to_string(i));
     }
-    std::cout << "Found " << wrongRecords << " wrong records with teh following CastInfoIds:\n";
-    for(const auto& id: wrongCastInfoIds) {
-        std::cout << id << '\n';
+    for(int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(values[i], std::to_string(i));
     }
-    std::cout << std::flush;
 }
 
-/**
- * Tests if the join algorithmus returns the correct amount of Tuples, and that the individual tuples are part of a correct
- * join algorithm!
- */
-TEST_F(MemoryHierarchyTest, TestAmoutOnlyMatches1toMany) {
-    std::cout   << "##########################################################################################\n"
-                << "# Testing if join algorithm contains wrong or duplicate records when using uniform data! #\n"
-                << "##########################################################################################\n";
-    const auto leftRelation = load<CastRelation>(DATA_DIRECTORY + std::string("cast_info_one_to_many.csv"), 20000);
-    const auto rightRelation = load<TitleRelation>(DATA_DIRECTORY + std::string("title_info_one_to_many.csv"), 20000);
-
-    size_t correctRecords = 0;
-    size_t duplicateRecords = 0;
-    size_t wrongRecords = 0;
-
-    std::vector<uint32_t> duplicateCastInfoIds;
-    std::vector<uint32_t> wrongCastInfoIds;
-
-    auto correctResults = performNestedLoopJoin(leftRelation, rightRelation);
-    std::unordered_map<uint32_t, const ResultRelation*> mapCorrect;
-    std::unordered_map<uint32_t, const ResultRelation*> found; // Used to make sure no record is duplicated
-    for(const auto& record : correctResults) {
-        mapCorrect[record.castInfoId] = &record;
-    }
-    auto sample = performJoin(leftRelation, rightRelation, 8);
-
-    for(const auto& record: sample) {
-        if(!mapCorrect.contains(record.castInfoId)) {
-            std::cout << "Found a record that should not be in results!\n" << resultRelationToString(record) << '\n' << std::endl;
-            wrongRecords += 1;
-            wrongCastInfoIds.emplace_back(record.castInfoId);
-            if(found.contains(record.castInfoId)) {
-                std::cout << "Found a duplicate record!\n" << resultRelationToString(record) << '\n' << std::endl;
-                duplicateRecords += 1;
-            } else {
-                found[record.castInfoId] = &record;
-            }
+TEST(AllocatorTest, TestHugePageVector) {
+    HugePageVector<CastRelation> relation(50000);
+    for(int32_t i = 0; i < static_cast<int32_t>(relation.size()); ++i) {
+        relation[i].movieId = i;
+    }
+    relation.resize(100000);
+    for(int32_t i = 0; i < 50000; ++i) {
+        ASSERT_EQ(relation[i].movieId, i);
+    }
+    ASSERT_EQ(relation[99999].movieId, 0);
+    HugePageVector<int> small(10, 7);
+    ASSERT_EQ(std::accumulate(small.begin(), small.end(), 0), 70);
+}
+
+TEST(AllocatorTest, TestArena) {
+    Arena arena;
+    {
+        std::vector<ResultRelation, ArenaAllocator<ResultRelation>> results{ArenaAllocator<ResultRelation>(arena)};
+        for(int32_t i = 0; i < 20000; ++i) {
+            ResultRelation record{};
+            record.titleId = i;
+            results.push_back(record);
         }
-        else {
-            if(found.contains(record.castInfoId)) {
-                std::cout << "Found a duplicate record!\n" << resultRelationToString(record) << '\n' << std::endl;
-                duplicateRecords += 1;
-            } else {
-                found[record.castInfoId] = &record;
-            }
-            correctRecords += 1;
+        for(int32_t i = 0; i < 20000; ++i) {
+            ASSERT_EQ(results[i].titleId, i);
         }
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(results.data()) % alignof(ResultRelation), 0u);
     }
-    std::cout << '\n';
-    std::cout << "Found " << correctRecords << " correct records!\n";
-    std::cout << "Found " << duplicateRecords << " duplicate records with the following CastInfoIds:\n";
-    for(const auto& id: duplicateCastInfoIds) {
-        std::cout << id << '\n';
+    const auto capacity = arena.capacity();
+    ASSERT_GT(capacity, 0u);
+    arena.reset();
+    {
+        std::vector<ResultRelation, ArenaAllocator<ResultRelation>> results{ArenaAllocator<ResultRelation>(arena)};
+        results.resize(20000);
     }
-    std::cout << "Found " << wrongRecords << " wrong records with teh following CastInfoIds:\n";
-    for(const auto& id: wrongCastInfoIds) {
-        std::cout << id << '\n';
+    ASSERT_EQ(arena.capacity(), capacity);
+    auto* a = static_cast<char*>(arena.allocate(10, 1));
+    auto* b = static_cast<char*>(arena.allocate(8, 64));
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(b) % 64, 0u);
+    ASSERT_NE(a, b);
+}
+
+TEST(HardwareInfoTest, TestDetectedValuesArePlausible) {
+    const auto& info = HardwareInfo::get();
+    info.print();
+    ASSERT_GT(L1_CACHE_SIZE, 0u);
+    ASSERT_GE(L2_CACHE_SIZE, L1_CACHE_SIZE);
+    ASSERT_GE(L3_CACHE_SIZE, L2_CACHE_SIZE);
+    ASSERT_LT(L3_CACHE_SIZE, size_t(1) << 40); // no underflowed -1
+    ASSERT_TRUE(std::has_single_bit(info.cacheLineSize()));
+    ASSERT_GT(info.dtlbEntries(), 0u);
+    ASSERT_EQ(HASHMAP_SIZE, info.hashMapEntries(sizeof(CastRelation*) + sizeof(int32_t)));
+}
+
+TEST(HardwareInfoTest, TestPartitionBits) {
+    const auto& info = HardwareInfo::get();
+    const auto entries = info.hashMapEntries(16);
+    ASSERT_GE(info.partitionBits(100, 16, 8), 3u);
+    ASSERT_GE(info.partitionBits(entries * 64, 16, 1), std::min<size_t>(6, std::bit_width(info.dtlbEntries()) - 1));
+    ASSERT_LE(size_t(1) << info.partitionBits(size_t(1) << 40, 16, 1), std::max<size_t>(2, info.dtlbEntries()));
+}
+
+/**
+ * @brief the sorted (castInfoId, kindId) pairs of a result, which identify a joined pair of the hand-made test relations
+ */
+template<typename Allocator>
+static std::vector<std::pair<int32_t, int32_t>> toPairs(const std::vector<ResultRelation, Allocator>& results) {
+    std::vector<std::pair<int32_t, int32_t>> pairs;
+    for(const auto& record: results) {
+        pairs.emplace_back(record.castInfoId, record.kindId);
     }
-    std::cout << std::flush;
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
 }
 
+TEST(PrefetchHashJoinTest, TestMatchesNestedLoopJoin) {
+    std::vector<CastRelation> castRelation(30000);
+    std::vector<TitleRelation> titleRelation(3000);
+    for(int32_t i = 0; i < static_cast<int32_t>(castRelation.size()); ++i) {
+        castRelation[i].castInfoId = i;
+        castRelation[i].movieId = (i * 7919) % 5000 - 100;
+    }
+    for(int32_t i = 0; i < static_cast<int32_t>(titleRelation.size()); ++i) {
+        titleRelation[i].titleId = i % 2500; // some titles share their key
+        titleRelation[i].kindId = i;
+    }
+    const auto expected = toPairs(performNestedLoopJoin(castRelation, titleRelation));
+    ASSERT_FALSE(expected.empty());
+    for(const int numThreads: {1, 4}) {
+        ASSERT_EQ(toPairs(performHashJoin(HashJoinType::PHJ, castRelation, titleRelation, numThreads)), expected);
+    }
+    ASSERT_TRUE(performPrefetchHashJoin(castRelation, {}, 2).empty());
+}
 
-TEST_F(MemoryHierarchyTest, TestChunkSize) {
-    for(size_t chunkSize = 2; chunkSize < (size_t)-1; chunkSize *= 2) {
-        std::cout << "Testing for chunkSize: " << chunkSize << std::endl;
-        for(int i = 0; i < 10; ++i) {
-            Timer timer("Run");
-            timer.start();
-            const auto results = performThreadedSortJoin(leftRelationSorted, rightRelationSorted);
-            timer.pause();
-            std::cout << "Run " << i << " with chunkSize: " << chunkSize << " took " << printString(timer) << std::endl;
+TEST(AllocatorTest, TestJoinsWithCustomAllocators) {
+    std::vector<CastRelation> castRelation(30000);
+    std::vector<TitleRelation> titleRelation(3000);
+    for(int32_t i = 0; i < static_cast<int32_t>(castRelation.size()); ++i) {
+        castRelation[i].castInfoId = i;
+        castRelation[i].movieId = (i * 7919) % 2000;
+    }
+    for(int32_t i = 0; i < static_cast<int32_t>(titleRelation.size()); ++i) {
+        titleRelation[i].titleId = i % 1500;
+        titleRelation[i].kindId = i;
+    }
+    const auto expected = toPairs(performNestedLoopJoin(castRelation, titleRelation));
+    ASSERT_FALSE(expected.empty());
+    const HugePageVector<CastRelation> hugeCast(castRelation.begin(), castRelation.end());
+    const HugePageVector<TitleRelation> hugeTitle(titleRelation.begin(), titleRelation.end());
+    ASSERT_EQ(toPairs(performPrefetchHashJoin(hugeCast, hugeTitle, 4, HugePageAllocator<ResultRelation>())), expected);
+
+    Arena arena;
+    ASSERT_EQ(toPairs(performNoPartitionHashJoin(hugeCast, hugeTitle, 4, ArenaAllocator<ResultRelation>(arena))), expected);
+    const auto capacity = arena.capacity();
+    arena.reset(); // the next join writes its results into the blocks of the previous one
+    ASSERT_EQ(toPairs(performNoPartitionHashJoin(hugeCast, hugeTitle, 4, ArenaAllocator<ResultRelation>(arena))), expected);
+    ASSERT_EQ(arena.capacity(), capacity);
+    arena.reset();
+    sortCastRelations(castRelation);
+    sortTitleRelations(titleRelation);
+    ASSERT_EQ(toPairs(performSortMergeJoin(castRelation, titleRelation, ArenaAllocator<ResultRelation>(arena))), expected);
+}
+
+TEST(CacheSizedHashJoinTest, TestMatchesReferenceJoin) {
+    std::vector<CastRelation> castRelation(30000);
+    std::vector<TitleRelation> titleRelation(2 * HASHMAP_SIZE + 123);
+    for(int32_t i = 0; i < static_cast<int32_t>(castRelation.size()); ++i) {
+        castRelation[i].castInfoId = i;
+        castRelation[i].movieId = static_cast<int32_t>((int64_t(i) * 7919) % (titleRelation.size() + 500)) - 100;
+    }
+    for(int32_t i = 0; i < static_cast<int32_t>(titleRelation.size()); ++i) {
+        titleRelation[i].titleId = i;
+        titleRelation[i].kindId = i;
+    }
+    titleRelation.back().titleId = 7; // duplicate key
+    std::unordered_multimap<int32_t, int32_t> kindsByTitle;
+    for(const auto& title: titleRelation) {
+        kindsByTitle.emplace(title.titleId, title.kindId);
+    }
+    std::vector<std::pair<int32_t, int32_t>> expected;
+    for(const auto& cast: castRelation) {
+        const auto [begin, end] = kindsByTitle.equal_range(cast.movieId);
+        for(auto it = begin; it != end; ++it) {
+            expected.emplace_back(cast.castInfoId, it->second);
         }
     }
+    std::sort(expected.begin(), expected.end());
+    for(const int numThreads: {1, 4}) {
+        std::vector<std::pair<int32_t, int32_t>> joined;
+        for(const auto& record: performCacheSizedThreadedHashJoin(castRelation, titleRelation, numThreads)) {
+            joined.emplace_back(record.castInfoId, record.kindId);
+        }
+        std::sort(joined.begin(), joined.end());
+        ASSERT_EQ(joined, expected);
+    }
 }
 
+TEST(NoPartitionHashJoinTest, TestMatchesNestedLoopJoin) {
+    std::vector<CastRelation> castRelation(30000);
+    std::vector<TitleRelation> titleRelation(3000);
+    for(int32_t i = 0; i < static_cast<int32_t>(castRelation.size()); ++i) {
+        castRelation[i].castInfoId = i;
+        castRelation[i].movieId = (i * 7919) % 5000 - 100;
+    }
+    for(int32_t i = 0; i < static_cast<int32_t>(titleRelation.size()); ++i) {
+        titleRelation[i].titleId = i % 1000; // three titles per key, concurrent inserts collide
+        titleRelation[i].kindId = i;
+    }
+    const auto expected = toPairs(performNestedLoopJoin(castRelation, titleRelation));
+    ASSERT_FALSE(expected.empty());
+    for(const int numThreads: {1, 4}) {
+        ASSERT_EQ(toPairs(performHashJoin(HashJoinType::NOP, castRelation, titleRelation, numThreads)), expected);
+    }
+    ASSERT_TRUE(performNoPartitionHashJoin(castRelation, {}, 2).empty());
+}
 
+TEST(TitleIndexTest, TestConcurrentProbesAndMappedIndex) {
+    std::vector<TitleRelation> titleRelation(3000);
+    for(int32_t i = 0; i < static_cast<int32_t>(titleRelation.size()); ++i) {
+        titleRelation[i].titleId = i % 2500;
+        titleRelation[i].kindId = i;
+    }
+    std::vector<std::vector<CastRelation>> batches(3, std::vector<CastRelation>(10000));
+    for(std::size_t batch = 0; batch < batches.size(); ++batch) {
+        for(int32_t i = 0; i < static_cast<int32_t>(batches[batch].size()); ++i) {
+            batches[batch][i].castInfoId = i;
+            batches[batch][i].movieId = (i * 7919 + static_cast<int32_t>(batch) * 31) % 5000 - 100;
+        }
+    }
+    std::vector<std::vector<std::pair<int32_t, int32_t>>> expected;
+    for(const auto& batch: batches) {
+        expected.emplace_back(toPairs(performNestedLoopJoin(batch, titleRelation)));
+    }
 
+    const auto index = TitleIndex::build(titleRelation, 4);
+    ASSERT_EQ(index.relation().size(), titleRelation.size());
+    std::vector<std::vector<std::pair<int32_t, int32_t>>> joined(batches.size());
+    {
+        std::vector<std::jthread> callers;
+        for(std::size_t batch = 0; batch < batches.size(); ++batch) {
+            callers.emplace_back([&, batch] {joined[batch] = toPairs(index.probe(batches[batch], 2));});
+        }
+    }
+    ASSERT_EQ(joined, expected);
+
+    const auto path = std::filesystem::temp_directory_path() / "ppds_title_index.bin";
+    ASSERT_TRUE(index.save(path));
+    const auto mapped = TitleIndex::open(path);
+    ASSERT_TRUE(mapped.has_value());
+    for(std::size_t batch = 0; batch < batches.size(); ++batch) {
+        ASSERT_EQ(toPairs(mapped->probe(batches[batch], 2)), expected[batch]);
+    }
+    std::filesystem::resize_file(path, 100);
+    ASSERT_FALSE(TitleIndex::open(path).has_value());
+    std::filesystem::remove(path);
+    ASSERT_FALSE(TitleIndex::open(path).has_value());
+}
+
+TEST(PerfCountersTest, TestTimerPhasesCarryCounts) {
+    Timer timer("Join", true);
+    timer.start();
+    std::vector<int64_t> values(1 << 20);
+    std::iota(values.begin(), values.end(), 0);
+    timer.snapshot("build");
+    int64_t sum = 0;
+    std::jthread worker([&values, &sum] {sum = std::accumulate(values.begin(), values.end(), int64_t(0));});
+    worker.join();
+    timer.snapshot("probe");
+    timer.pause();
+    ASSERT_EQ(sum, (int64_t(1 << 20) - 1) * (1 << 20) / 2);
+    ASSERT_EQ(timer.getSnapshots().size(), 2u);
+    const auto output = printString(timer);
+    ASSERT_NE(output.find("Join_build"), std::string::npos);
+    ASSERT_NE(output.find("Join_probe"), std::string::npos);
+    if(PerfCounters().available()) {
+        ASSERT_TRUE(timer.getCounts().any());
+        ASSERT_NE(output.find("cycles="), std::string::npos);
+    } else {
+        ASSERT_FALSE(timer.getCounts().any()); // no counters, time only
+    }
+    PerfCounts workerCounts;
+    workerCounts.valid[static_cast<std::size_t>(PerfEvent::INSTRUCTIONS)] = true;
+    workerCounts.values[static_cast<std::size_t>(PerfEvent::INSTRUCTIONS)] = 10;
+    const auto before = timer.getCounts()[PerfEvent::INSTRUCTIONS];
+    timer.mergeCounts(workerCounts);
+    ASSERT_EQ(timer.getCounts()[PerfEvent::INSTRUCTIONS], before + 10);
+
+    setenv("PPDS_PERF_COUNTERS", "0", 1);
+    ASSERT_FALSE(PerfCounters().available());
+    unsetenv("PPDS_PERF_COUNTERS");
+}
 
+TEST(DataGeneratorTest, TestDeterministicRoundTrips) {
+    GeneratorOptions options;
+    options.numRecords = 3 * GENERATOR_CHUNK_SIZE + 17;
+    options.distribution = KeyDistribution::MATCH_RATE;
+    options.matchRate = 0.25;
+    options.numThreads = 1;
+    const auto castRelation = generateRelation<CastRelation>(options);
+    options.numThreads = 4;
+    const auto sameCast = generateRelation<CastRelation>(options);
+    ASSERT_EQ(castRelation.size(), options.numRecords);
+    for(std::size_t i = 0; i < castRelation.size(); ++i) { // independent of the number of threads
+        ASSERT_EQ(castRelation[i].castInfoId, static_cast<int32_t>(i + 1));
+        ASSERT_EQ(castRelation[i].movieId, sameCast[i].movieId);
+        ASSERT_EQ(std::strcmp(castRelation[i].note, sameCast[i].note), 0);
+    }
+    const auto matches = std::count_if(castRelation.begin(), castRelation.end(), [&options](const CastRelation& cast) {
+        return cast.movieId >= options.minValue && cast.movieId < options.maxValue;
+    });
+    ASSERT_NEAR(static_cast<double>(matches) / static_cast<double>(castRelation.size()), options.matchRate, 0.02);
+
+    const auto csvPath = (std::filesystem::temp_directory_path() / "ppds_generated_cast.csv").string();
+    ASSERT_TRUE(writeRelation<CastRelation>(csvPath, options, OutputFormat::CSV));
+    const auto loadedCast = load<CastRelation>(csvPath);
+    ASSERT_EQ(loadedCast.size(), castRelation.size());
+    for(std::size_t i = 0; i < castRelation.size(); ++i) {
+        ASSERT_EQ(castRelationToString(loadedCast[i]), castRelationToString(castRelation[i]));
+    }
+    std::filesystem::remove(csvPath);
+
+    GeneratorOptions titleOptions;
+    titleOptions.numRecords = 1000;
+    titleOptions.distribution = KeyDistribution::SEQUENTIAL;
+    titleOptions.stringKeys = true;
+    const auto titleRelation = generateRelation<TitleRelation>(titleOptions);
+    ASSERT_EQ(titleRelation[999].titleId, 1000);
+    ASSERT_STREQ(titleRelation[999].title, "100000000000000000000000000000000000000000000000000000000999");
+    const auto binaryPath = (std::filesystem::temp_directory_path() / "ppds_generated_title.bin").string();
+    ASSERT_TRUE(writeRelation<TitleRelation>(binaryPath, titleOptions, OutputFormat::BINARY));
+    const auto loadedTitle = loadBinary<TitleRelation>(binaryPath);
+    ASSERT_TRUE(loadedTitle.has_value());
+    ASSERT_EQ(loadedTitle->size(), titleRelation.size());
+    ASSERT_EQ(std::memcmp(loadedTitle->data(), titleRelation.data(), titleRelation.size() * sizeof(TitleRelation)), 0);
+    ASSERT_FALSE(loadBinary<CastRelation>(binaryPath).has_value()); // other record layout
+    std::filesystem::remove(binaryPath);
+
+    RelationSpec spec;
+    spec.numCasts = 50000;
+    spec.numTitles = 4000;
+    spec.distribution = KeyDistribution::ZIPFIAN;
+    spec.matchRate = 0.5;
+    spec.duplicatesPerKey = 4;
+    spec.stringLength = 20;
+    const auto relations = generateRelations<CastRelation, TitleRelation>(spec);
+    ASSERT_EQ(relations.cast.size(), spec.numCasts);
+    ASSERT_EQ(relations.title.size(), spec.numTitles);
+    ASSERT_EQ(relations.title.back().titleId, 1000);
+    ASSERT_EQ(std::strlen(relations.cast[0].note), 20u);
+    ASSERT_EQ(std::strlen(relations.title[0].title), 20u);
+    std::vector<std::size_t> hits(1001, 0);
+    std::size_t misses = 0;
+    for(const auto& cast: relations.cast) {
+        if(cast.movieId >= 1 && cast.movieId <= 1000) {
+            ++hits[cast.movieId];
+        } else {
+            ++misses;
+        }
+    }
+    ASSERT_NEAR(static_cast<double>(misses) / static_cast<double>(spec.numCasts), 1 - spec.matchRate, 0.02);
+    ASSERT_GT(hits[1], 20 * hits[500]); // skewed towards the small keys
+
+    spec.matchingStrings = true;
+    const auto strings = generateRelations<CastRelation, TitleRelation>(spec);
+    ASSERT_STREQ(strings.cast[123].note, strings.title[123].title);
+    ASSERT_STREQ(strings.cast[123].note, "10000000000000000123");
+
+    GeneratorOptions zipfOptions;
+    zipfOptions.distribution = KeyDistribution::ZIPFIAN;
+    zipfOptions.minValue = 1;
+    zipfOptions.maxValue = 5;
+    KeySampler zipf(zipfOptions);
+    std::mt19937_64 rng(7);
+    for(int i = 0; i < 10000; ++i) {
+        const auto key = zipf(static_cast<std::size_t>(i), rng);
+        ASSERT_TRUE(key >= 1 && key < 5); // half-open like UNIFORM
+    }
 
+    options.distribution = KeyDistribution::SORTED;
+    const auto sortedCast = generateRelation<CastRelation>(options);
+    ASSERT_TRUE(std::is_sorted(sortedCast.begin(), sortedCast.end(), [](const CastRelation& a, const CastRelation& b) {return a.movieId < b.movieId;}));
+}
@@ -15,13 +15,16 @@
 #ifndef JOINUTIL_HPP
 #define JOINUTIL_HPP
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <utility>
 #include <vector>
+#include <omp.h>
 
-#include "generated_variables.h"
+#include "HardwareInfo.h"
 
 
 /*
@@ -46,6 +49,10 @@ constexpr const size_t L2_CACHE_SIZE = 16777216;    ///< 512KiB per Core
 constexpr const size_t L3_CACHE_SIZE = 83886000;  ///< ~80 MiB per Core
 */
 
+static const size_t L1_CACHE_SIZE = HardwareInfo::get().l1CacheSize(); ///< per physical core
+static const size_t L2_CACHE_SIZE = HardwareInfo::get().l2CacheSize(); ///< per physical core
+static const size_t L3_CACHE_SIZE = HardwareInfo::get().l3CacheSize(); ///< shared
+static const std::string CPU_NAME = HardwareInfo::get().cpuName();
 
 inline void printCacheSizes() {
     std::cout << "L1 cache size: " << L1_CACHE_SIZE << '\n'
@@ -290,9 +297,9 @@ static constexpr size_t NUM_FIELD_CAST_RELATION = 7;
       return true;
     }
 
-    template <typename Relation>
-    std::vector<Relation> load(const std::string& filename, const size_t numberOfTuples = SIZE_MAX) {
-      std::vector<Relation> data;
+    template <typename Relation, typename Allocator = std::allocator<Relation>>
+    std::vector<Relation, Allocator> load(const std::string& filename, const size_t numberOfTuples = SIZE_MAX, const Allocator& allocator = Allocator()) {
+      std::vector<Relation, Allocator> data(allocator);
       std::ifstream file(filename);
       if (!file.is_open()) {
         std::cerr << "Error: Failed to open file " << filename << std::endl;
@@ -371,8 +378,33 @@ inline bool compareCastRelations(const CastRelation& a, const CastRelation& b) {
 inline void sortTitleRelations(std::vector<TitleRelation>& vector) {std::sort(vector.begin(), vector.end(), compareTitleRelations);}
 inline void sortCastRelations(std::vector<CastRelation>& vector) {std::sort(vector.begin(), vector.end(), compareCastRelations);}
 
-
-
-
+/**
+ * @brief writes the matches every thread of the enclosing parallel region collected in localResults[thread] into
+ * results, which is sized exactly once; each thread fills its own range behind the matches of the threads before it,
+ * so no counter is shared. All threads of the region have to call it once they are done matching.
+ * @tparam Matches vector of (cast, title) pointer pairs with any allocator
+ * @tparam Results vector of ResultRelation with any allocator
+ */
+template<typename Matches, typename Results>
+inline void materializeLocalResults(const std::vector<Matches>& localResults, Results& results) {
+    #pragma omp barrier
+    #pragma omp single
+    {
+        std::size_t size = 0;
+        for(const auto& matches: localResults) {
+            size += matches.size();
+        }
+        results.resize(size);
+    } // implicit barrier, results is sized for every thread
+    const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+    std::size_t offset = 0;
+    for(std::size_t i = 0; i < thread; ++i) {
+        offset += localResults[i].size();
+    }
+    auto output = results.begin() + static_cast<std::ptrdiff_t>(offset);
+    for(const auto& [castTuple, titleTuple] : localResults[thread]) {
+        *output++ = createResultTuple(*castTuple, *titleTuple);
+    }
+}
 
 #endif //JOINUTIL_HPP
@@ -0,0 +1,182 @@
+#ifndef PPDS_2_MEMORY_HIERARCHY_PIPELINEDJOIN_H
+#define PPDS_2_MEMORY_HIERARCHY_PIPELINEDJOIN_H
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "JoinUtils.hpp"
+#include "RingBuffer.h"
+#include "ThreadedLoad.h"
+
+static constexpr const std::size_t PIPELINE_BLOCK_SIZE = 16 * 1024; ///< at most RINGBUFFER_SIZE blocks per queue are in flight
+static constexpr const std::size_t PIPELINE_PARTITIONS = 64; ///< power of two, partitions of the build side hash table
+
+/**
+ * @brief hash table on the title relation that several parser threads fill at the same time.
+ * The table is split into partitions by titleId, each with its own lock, and the records live in one deque per
+ * builder so their addresses stay valid while other builders keep inserting. Like the other hash joins it keeps every
+ * record of a titleId that occurs more than once.
+ */
+class PartitionedTitleTable {
+public:
+    explicit PartitionedTitleTable(const unsigned int numBuilders) : records(numBuilders) {}
+
+    /**
+     * @brief takes ownership of the parsed records of one chunk and inserts them, locking each partition once
+     * @param builder index of the calling thread, every builder has to use its own index
+     */
+    void insert(const unsigned int builder, std::vector<TitleRelation>& chunk) {
+        auto& storage = records[builder];
+        std::array<std::vector<const TitleRelation*>, PIPELINE_PARTITIONS> byPartition;
+        for(const auto& record: chunk) {
+            storage.emplace_back(record);
+            byPartition[partitionOf(record.titleId)].emplace_back(&storage.back());
+        }
+        chunk.clear();
+        for(std::size_t p = 0; p < PIPELINE_PARTITIONS; ++p) {
+            if(byPartition[p].empty()) {
+                continue;
+            }
+            std::lock_guard l_partition(partitions[p].m_map);
+            for(const TitleRelation* record: byPartition[p]) {
+                partitions[p].map.emplace(record->titleId, record);
+            }
+        }
+    }
+
+    /**
+     * @brief calls f with every record of titleId, only safe once all builders are done
+     */
+    template<typename F>
+    void forEachMatch(const int32_t titleId, F&& f) const {
+        const auto [begin, end] = partitions[partitionOf(titleId)].map.equal_range(titleId);
+        for(auto it = begin; it != end; ++it) {
+            f(*it->second);
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        std::size_t size = 0;
+        for(const auto& partition: partitions) {
+            size += partition.map.size();
+        }
+        return size;
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Partition {
+        std::mutex m_map;
+        std::unordered_multimap<int32_t, const TitleRelation*> map;
+    };
+
+    static std::size_t partitionOf(const int32_t titleId) {
+        // the low bits of sequential ids are already well distributed
+        return static_cast<uint32_t>(titleId) & (PIPELINE_PARTITIONS - 1);
+    }
+
+    std::array<Partition, PIPELINE_PARTITIONS> partitions;
+    std::vector<std::deque<TitleRelation>> records;
+};
+
+/**
+ * @brief streams both files through the join: the title file is read, parsed and inserted into the hash table by
+ * numThreads threads, then the cast file is read, parsed and probed by numThreads threads. A separate reader thread per
+ * file keeps the bounded chunk queues filled, so I/O overlaps with parsing, and the cast reader already fills its queue
+ * while the hash table is still being built. Only the title relation is ever fully in memory.
+ *
+ * @param consume called with the results of one cast chunk, calls are serialized
+ * @return number of joined tuples
+ * @throws std::runtime_error if either file could not be opened or read
+ */
+inline std::size_t streamPipelinedJoin(const std::string& castPath, const std::string& titlePath, const unsigned int numThreads,
+                                       const std::function<void(std::span<const ResultRelation>)>& consume,
+                                       const std::size_t bufferSize = PIPELINE_BLOCK_SIZE) {
+    std::mutex m_cout;
+    RingBuffer<std::string> titleChunks;
+    RingBuffer<std::string> castChunks;
+    PartitionedTitleTable table(numThreads);
+
+    bool titleRead = false;
+    bool castRead = false;
+    std::jthread titleReader([&titleRead, &titlePath, &titleChunks, bufferSize] {titleRead = readChunks(titlePath, titleChunks, bufferSize);});
+    std::jthread castReader([&castRead, &castPath, &castChunks, bufferSize] {castRead = readChunks(castPath, castChunks, bufferSize);});
+
+    // Build
+    {
+        std::vector<std::jthread> builders;
+        builders.reserve(numThreads);
+        for(unsigned int i = 0; i < numThreads; ++i) {
+            builders.emplace_back([i, &titleChunks, &table, &m_cout] {
+                std::string chunk;
+                std::vector<TitleRelation> records;
+                while(titleChunks.pop(chunk)) {
+                    parseChunk<TitleRelation>(chunk, records, m_cout);
+                    table.insert(i, records);
+                }
+            });
+        }
+    }
+    titleReader.join();
+    if(!titleRead) {
+        castChunks.close(); // the cast reader may wait for space that no prober frees
+        castReader.join();
+        throw std::runtime_error("streamPipelinedJoin: could not read " + titlePath);
+    }
+
+    // Probe
+    std::mutex m_consume;
+    std::size_t numResults = 0;
+    {
+        std::vector<std::jthread> probers;
+        probers.reserve(numThreads);
+        for(unsigned int i = 0; i < numThreads; ++i) {
+            probers.emplace_back([&castChunks, &table, &m_cout, &m_consume, &numResults, &consume] {
+                std::string chunk;
+                std::vector<CastRelation> records;
+                std::vector<ResultRelation> results;
+                while(castChunks.pop(chunk)) {
+                    parseChunk<CastRelation>(chunk, records, m_cout);
+                    for(const auto& record: records) {
+                        table.forEachMatch(record.movieId, [&results, &record](const TitleRelation& title) {
+                            results.emplace_back(createResultTuple(record, title));
+                        });
+                    }
+                    records.clear();
+                    if(!results.empty()) {
+                        std::lock_guard l_consume(m_consume);
+                        numResults += results.size();
+                        consume(results);
+                    }
+                    results.clear();
+                }
+            });
+        }
+    }
+    castReader.join();
+    if(!castRead) {
+        throw std::runtime_error("streamPipelinedJoin: could not read " + castPath);
+    }
+    return numResults;
+}
+
+/**
+ * @brief joins the relations stored at castPath and titlePath without loading the cast relation first
+ */
+inline std::vector<ResultRelation> performPipelinedJoin(const std::string& castPath, const std::string& titlePath,
+                                                        const unsigned int numThreads = std::jthread::hardware_concurrency()) {
+    std::vector<ResultRelation> results;
+    streamPipelinedJoin(castPath, titlePath, numThreads, [&results](std::span<const ResultRelation> chunk) {
+        results.insert(results.end(), chunk.begin(), chunk.end());
+    });
+    return results;
+}
+
+#endif //PPDS_2_MEMORY_HIERARCHY_PIPELINEDJOIN_H
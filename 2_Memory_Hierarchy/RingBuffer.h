@@ -6,35 +6,412 @@
 #define PPDS_2_MEMORY_HIERARCHY_RINGBUFFER_H
 
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
 
-template<typename T>
-class RingBuffer {
+static constexpr const std::size_t CACHE_LINE_SIZE = 64;
+static constexpr const std::size_t RINGBUFFER_SIZE = 256;
+
+/**
+ * @brief lets threads sleep until a ring buffer changed, without a mutex.
+ * A waiter registers itself, re-checks its condition and then sleeps on the epoch. A notifier only touches the epoch
+ * if somebody is registered, so an uncontended push or pop costs a fence and one load.
+ */
+class EventCount {
 public:
     /**
-     * waits until an item is available to read. If multiple threads are waiting, only one is notified
+     * @brief registers the calling thread as waiter, the condition has to be checked again before calling wait
+     * @return key to pass to wait or cancelWait
      */
-    void waitRead() {
+    uint32_t prepareWait() {
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        return epoch.load(std::memory_order_seq_cst);
+    }
 
+    void cancelWait() {
+        waiters.fetch_sub(1, std::memory_order_relaxed);
     }
 
     /**
-     * waits until a space is free to write. If multiple threads are waiting, only one is notified
+     * @brief sleeps until notify was called after prepareWait returned key
+     */
+    void wait(const uint32_t key) {
+        epoch.wait(key, std::memory_order_seq_cst);
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(waiters.load(std::memory_order_relaxed) > 0) {
+            epoch.fetch_add(1, std::memory_order_seq_cst);
+            epoch.notify_all();
+        }
+    }
+
+private:
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> epoch{0};
+    std::atomic<uint32_t> waiters{0};
+};
+
+/**
+ * @brief blocking operations shared by both ring buffers, Derived provides tryPush and tryPop
+ */
+template<typename Derived, typename T>
+class BlockingRingBuffer {
+public:
+    /**
+     * @brief waits until a space is free to write. Returns false if the buffer was closed
+     */
+    bool push(T value) {
+        if(closed.load(std::memory_order_acquire)) {
+            return false;
+        }
+        while(true) {
+            if(derived().tryPush(value)) {
+                return true;
+            }
+            const auto key = writable.prepareWait();
+            if(derived().tryPush(value)) {
+                writable.cancelWait();
+                return true;
+            }
+            if(closed.load(std::memory_order_acquire)) {
+                writable.cancelWait();
+                return false;
+            }
+            writable.wait(key);
+        }
+    }
+
+    /**
+     * @brief waits until an item is available and moves it into value
+     * @return false once the buffer is closed and all items pushed before were read
+     */
+    bool pop(T& value) {
+        while(true) {
+            if(derived().tryPop(value)) {
+                return true;
+            }
+            const auto key = readable.prepareWait();
+            if(derived().tryPop(value)) {
+                readable.cancelWait();
+                return true;
+            }
+            if(closed.load(std::memory_order_acquire)) {
+                readable.cancelWait();
+                return derived().tryPop(value);
+            }
+            readable.wait(key);
+        }
+    }
+
+    /**
+     * @brief returns the oldest item, or nothing once the buffer is closed and drained
+     */
+    std::optional<T> read() {
+        T value;
+        if(pop(value)) {
+            return value;
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief pushes all values, waiting for free space where necessary
+     * @return number of pushed values, less than values.size() only if the buffer was closed
+     */
+    std::size_t pushBatch(std::span<T> values) {
+        if(closed.load(std::memory_order_acquire)) {
+            return 0;
+        }
+        std::size_t pushed = derived().tryPushBatch(values);
+        while(pushed < values.size()) {
+            if(!push(std::move(values[pushed]))) {
+                break;
+            }
+            ++pushed;
+            pushed += derived().tryPushBatch(values.subspan(pushed));
+        }
+        return pushed;
+    }
+
+    /**
+     * @brief waits until at least one item is available and then takes up to values.size() items
+     * @return number of items read, 0 once the buffer is closed and drained
+     */
+    std::size_t popBatch(std::span<T> values) {
+        if(values.empty() || !pop(values[0])) {
+            return 0;
+        }
+        return 1 + derived().tryPopBatch(values.subspan(1));
+    }
+
+    /**
+     * @brief waits until an item is available to read or the buffer is closed
+     */
+    void waitRead() {
+        while(!derived().hasItems() && !closed.load(std::memory_order_acquire)) {
+            const auto key = readable.prepareWait();
+            if(derived().hasItems() || closed.load(std::memory_order_acquire)) {
+                readable.cancelWait();
+                return;
+            }
+            readable.wait(key);
+        }
+    }
+
+    /**
+     * @brief waits until a space is free to write or the buffer is closed
      */
     void waitWrite() {
+        while(!derived().hasSpace() && !closed.load(std::memory_order_acquire)) {
+            const auto key = writable.prepareWait();
+            if(derived().hasSpace() || closed.load(std::memory_order_acquire)) {
+                writable.cancelWait();
+                return;
+            }
+            writable.wait(key);
+        }
+    }
+
+    /**
+     * @brief marks the end of the stream: pop returns false after the remaining items were read, push fails
+     */
+    void close() {
+        closed.store(true, std::memory_order_release);
+        readable.notify();
+        writable.notify();
+    }
+
+    [[nodiscard]] bool isClosed() const {
+        return closed.load(std::memory_order_acquire);
+    }
+
+protected:
+    EventCount readable;
+    EventCount writable;
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> closed{false};
+
+private:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+};
+
+/**
+ * @brief bounded queue for exactly one producer and one consumer thread.
+ * Head and tail live on their own cache lines, and each side keeps a cached copy of the other side's index so it only
+ * reads the shared index when the buffer looks full or empty.
+ */
+template<typename T, std::size_t Capacity = RINGBUFFER_SIZE>
+class SPSCRingBuffer : public BlockingRingBuffer<SPSCRingBuffer<T, Capacity>, T> {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+    friend class BlockingRingBuffer<SPSCRingBuffer<T, Capacity>, T>;
+public:
+    bool tryPush(T& value) {
+        const auto tail = writePos.load(std::memory_order_relaxed);
+        if(tail - cachedReadPos == Capacity) {
+            cachedReadPos = readPos.load(std::memory_order_acquire);
+            if(tail - cachedReadPos == Capacity) {
+                return false;
+            }
+        }
+        buffer[tail & MASK] = std::move(value);
+        writePos.store(tail + 1, std::memory_order_release);
+        this->readable.notify();
+        return true;
+    }
 
+    bool tryPop(T& value) {
+        const auto head = readPos.load(std::memory_order_relaxed);
+        if(head == cachedWritePos) {
+            cachedWritePos = writePos.load(std::memory_order_acquire);
+            if(head == cachedWritePos) {
+                return false;
+            }
+        }
+        value = std::move(buffer[head & MASK]);
+        readPos.store(head + 1, std::memory_order_release);
+        this->writable.notify();
+        return true;
     }
+
     /**
-     * @param T data returned
-     * returns a copy of the oldest data in the ring buffer
+     * @brief pushes as many values as fit without waiting, publishing them with a single store
      */
-    T read() {
+    std::size_t tryPushBatch(std::span<T> values) {
+        const auto tail = writePos.load(std::memory_order_relaxed);
+        cachedReadPos = readPos.load(std::memory_order_acquire);
+        const auto count = std::min(values.size(), Capacity - (tail - cachedReadPos));
+        for(std::size_t i = 0; i < count; ++i) {
+            buffer[(tail + i) & MASK] = std::move(values[i]);
+        }
+        if(count > 0) {
+            writePos.store(tail + count, std::memory_order_release);
+            this->readable.notify();
+        }
+        return count;
+    }
 
+    /**
+     * @brief takes as many items as available without waiting, releasing their slots with a single store
+     */
+    std::size_t tryPopBatch(std::span<T> values) {
+        const auto head = readPos.load(std::memory_order_relaxed);
+        cachedWritePos = writePos.load(std::memory_order_acquire);
+        const auto count = std::min(values.size(), cachedWritePos - head);
+        for(std::size_t i = 0; i < count; ++i) {
+            values[i] = std::move(buffer[(head + i) & MASK]);
+        }
+        if(count > 0) {
+            readPos.store(head + count, std::memory_order_release);
+            this->writable.notify();
+        }
+        return count;
     }
+
 private:
-    static constexpr const std::size_t RINGBUFFER_SIZE = 256;
-    std::array<T, RINGBUFFER_SIZE> buffer;
-    std::size_t readPos;
-    std::size_t writePos;
+    static constexpr std::size_t MASK = Capacity - 1;
+
+    bool hasItems() const { return readPos.load(std::memory_order_relaxed) != writePos.load(std::memory_order_acquire); }
+    bool hasSpace() const { return writePos.load(std::memory_order_relaxed) - readPos.load(std::memory_order_acquire) < Capacity; }
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> writePos{0};
+    std::size_t cachedReadPos = 0; ///< only used by the producer
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> readPos{0};
+    std::size_t cachedWritePos = 0; ///< only used by the consumer
+    alignas(CACHE_LINE_SIZE) std::array<T, Capacity> buffer{};
 };
 
+/**
+ * @brief bounded queue for any number of producers and consumers (Vyukov's bounded MPMC queue).
+ * Every cell carries a sequence number that tells producers and consumers whether it is free or filled for the current
+ * lap, so the only contended operations are the CAS on the positions.
+ */
+template<typename T, std::size_t Capacity = RINGBUFFER_SIZE>
+class MPMCRingBuffer : public BlockingRingBuffer<MPMCRingBuffer<T, Capacity>, T> {
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+    friend class BlockingRingBuffer<MPMCRingBuffer<T, Capacity>, T>;
+public:
+    MPMCRingBuffer() : cells(std::make_unique<Cell[]>(Capacity)) {
+        for(std::size_t i = 0; i < Capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPush(T& value) {
+        if(!tryPushSilently(value)) {
+            return false;
+        }
+        this->readable.notify();
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        if(!tryPopSilently(value)) {
+            return false;
+        }
+        this->writable.notify();
+        return true;
+    }
+
+    /**
+     * @brief pushes as many values as fit without waiting, waking consumers once
+     */
+    std::size_t tryPushBatch(std::span<T> values) {
+        std::size_t count = 0;
+        while(count < values.size() && tryPushSilently(values[count])) {
+            ++count;
+        }
+        if(count > 0) {
+            this->readable.notify();
+        }
+        return count;
+    }
+
+    /**
+     * @brief takes as many items as available without waiting, waking producers once
+     */
+    std::size_t tryPopBatch(std::span<T> values) {
+        std::size_t count = 0;
+        while(count < values.size() && tryPopSilently(values[count])) {
+            ++count;
+        }
+        if(count > 0) {
+            this->writable.notify();
+        }
+        return count;
+    }
+
+private:
+    static constexpr std::size_t MASK = Capacity - 1;
+
+    struct alignas(CACHE_LINE_SIZE) Cell {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    bool tryPushSilently(T& value) {
+        auto position = writePos.load(std::memory_order_relaxed);
+        while(true) {
+            Cell& cell = cells[position & MASK];
+            const auto sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+            if(difference == 0) {
+                if(writePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.data = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if(difference < 0) {
+                return false; // the cell still holds an item of the previous lap
+            } else {
+                position = writePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPopSilently(T& value) {
+        auto position = readPos.load(std::memory_order_relaxed);
+        while(true) {
+            Cell& cell = cells[position & MASK];
+            const auto sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+            if(difference == 0) {
+                if(readPos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.data);
+                    cell.sequence.store(position + Capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if(difference < 0) {
+                return false; // no producer has filled the cell for this lap yet
+            } else {
+                position = readPos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool hasItems() const {
+        const auto position = readPos.load(std::memory_order_relaxed);
+        return cells[position & MASK].sequence.load(std::memory_order_acquire) == position + 1;
+    }
+
+    bool hasSpace() const {
+        const auto position = writePos.load(std::memory_order_relaxed);
+        return cells[position & MASK].sequence.load(std::memory_order_acquire) == position;
+    }
+
+    std::unique_ptr<Cell[]> cells;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> writePos{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> readPos{0};
+};
+
+/**
+ * @brief default queue for handing work between threads
+ */
+template<typename T>
+using RingBuffer = MPMCRingBuffer<T, RINGBUFFER_SIZE>;
+
 #endif //PPDS_2_MEMORY_HIERARCHY_RINGBUFFER_H
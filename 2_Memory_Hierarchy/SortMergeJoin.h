@@ -7,20 +7,19 @@
 
 #include "JoinUtils.hpp"
 #include "HashJoin.h"
-#include "generated_variables.h"
 #include "CustomAllocator.h"
+#include "RingBuffer.h"
+#include "Topology.h"
 
 #include <span>
 #include <thread>
 #include <ranges>
 #include <algorithm>
-#include <execution>
 #include <iterator>
 #include <iostream>
 #include <vector>
 #include <thread>
 #include <mutex>
-#include <condition_variable>
 #include <omp.h>
 #include <atomic>
 #include <list>
@@ -37,10 +36,13 @@ enum class SortMergeJoinType : uint8_t {
  *
  * @param castRelation a sorted span of cast records
  * @param titleRelation a sorted span of title records
+ * @param allocator of the returned vector
  * @return a std::vector<ResultRelation> of joined tuples
  */
-std::vector<ResultRelation> performSortMergeJoin(const std::vector<CastRelation>& castRelation, const std::vector<TitleRelation>& titleRelation) {
-    std::vector<ResultRelation> results;
+template<typename ResultAllocator = std::allocator<ResultRelation>>
+std::vector<ResultRelation, ResultAllocator> performSortMergeJoin(const std::span<const CastRelation> castRelation, const std::span<const TitleRelation> titleRelation,
+                                                                  const ResultAllocator& allocator = ResultAllocator()) {
+    std::vector<ResultRelation, ResultAllocator> results(allocator);
     results.reserve(castRelation.size());
 
     int32_t currentId = 0;
@@ -75,14 +77,16 @@ std::vector<ResultRelation> performSortMergeJoin(const std::vector<CastRelation>
     return results;
 }
 
+static constexpr const AffinityPolicy SORT_JOIN_AFFINITY = AffinityPolicy::SCATTER; ///< spreads the workers over all memory controllers
+
 struct ChunkCastRelation {
-    const std::vector<CastRelation>::const_iterator start;
-    const std::vector<CastRelation>::const_iterator end;
+    std::vector<CastRelation>::const_iterator start;
+    std::vector<CastRelation>::const_iterator end;
 };
 
 struct ChunkTitleRelation {
-    const std::vector<TitleRelation>::const_iterator start;
-    const std::vector<TitleRelation>::const_iterator end;
+    std::vector<TitleRelation>::const_iterator start;
+    std::vector<TitleRelation>::const_iterator end;
 };
 
 void inline processChunk(const ChunkCastRelation& chunkCastRelation, const ChunkTitleRelation& chunkTitleRelation, std::vector<ResultRelation>& results,
@@ -140,29 +144,19 @@ void inline processChunk(const ChunkCastRelation& chunkCastRelation, const Chunk
 }
 
 struct WorkerThreadArgs {
-    std::vector<ChunkCastRelation>& chunks;
-    std::mutex& m_chunks;
+    RingBuffer<ChunkCastRelation>& chunks;
     const ChunkTitleRelation titleRelation;
     std::vector<ResultRelation>& results;
     std::mutex& m_results;
-    std::condition_variable& cv;
-    std::atomic_bool& stop;
     std::atomic_size_t& r_index;
 
 };
 
 void workerThread(const WorkerThreadArgs& args) {
-    while(!args.stop.load(std::memory_order_relaxed) || !args.chunks.empty()) {
-        std::unique_lock l_chunks(args.m_chunks);
-        args.cv.wait(l_chunks, [&args] {return args.stop.load(std::memory_order_relaxed) || !args.chunks.empty();});
-        if(!args.chunks.empty()) {
-            auto chunkCastRelation = std::move(args.chunks.back());
-            args.chunks.pop_back();
-            l_chunks.unlock();
-            processChunk(chunkCastRelation, args.titleRelation,args.results, args.r_index, args.m_results);
-        }
+    ChunkCastRelation chunkCastRelation;
+    while(args.chunks.pop(chunkCastRelation)) {
+        processChunk(chunkCastRelation, args.titleRelation,args.results, args.r_index, args.m_results);
     }
-    //std::cout << "Stopping thread\n";
 }
 
 
@@ -188,30 +182,25 @@ std::vector<ResultRelation> performThreadedSortJoin(const std::vector<CastRelati
     //results.reserve(leftRelation.size() > rightRelation.size() ? leftRelation.size() : rightRelation.size());
     std::mutex m_results;
     std::atomic_size_t r_index(0);
-    std::atomic_bool stop(false);
-    std::vector<ChunkCastRelation> chunks;
-    //chunks.reserve(100);
-    //chunks.reserve(200);
-    std::mutex m_chunks;
-    std::condition_variable cv_queue;
+    RingBuffer<ChunkCastRelation> chunks;
     //std::size_t chunkNum = 0;
-    std::size_t maxChunksInQueue = 0;
 
     const WorkerThreadArgs args(
             std::ref(chunks),
-            std::ref(m_chunks),
             ChunkTitleRelation(rightRelation.begin(), rightRelation.end()),
             std::ref(results),
             std::ref(m_results),
-            std::ref(cv_queue),
-            std::ref(stop),
             std::ref(r_index)
             );
 
     std::vector<std::jthread> threads;
     threads.reserve(numThreads);
+    const auto cpus = Topology::get().cpuOrder(SORT_JOIN_AFFINITY, numThreads);
     for(unsigned int i = 0; i < numThreads; ++i) {
         threads.emplace_back(workerThread, std::ref(args));
+        if(!cpus.empty()) {
+            pinThread(threads.back().native_handle(), cpus[i]);
+        }
     }
 
     auto chunkStart = leftRelation.begin();
@@ -222,19 +211,11 @@ std::vector<ResultRelation> performThreadedSortJoin(const std::vector<CastRelati
         } else {
             chunkEnd = leftRelation.end();
         }
-        {
-            std::scoped_lock l_chunks(m_chunks);
-            chunks.emplace_back(chunkStart, chunkEnd);
-            //std::cout << "chunks.size()" << chunks.size() << std::endl;
-            //maxChunksInQueue = maxChunksInQueue < chunks.size() ? chunks.size() : maxChunksInQueue;
-        }
-        cv_queue.notify_one();
+        chunks.push(ChunkCastRelation(chunkStart, chunkEnd));
         chunkStart = chunkEnd;
         //chunkNum++;
     }
-    stop.store(true, std::memory_order_relaxed);
-    //std::cout << "All threads should stop now!\n";
-    cv_queue.notify_all();
+    chunks.close();
     for (auto &t: threads) {
         t.join();
     }
@@ -247,7 +228,6 @@ std::vector<ResultRelation> performThreadedSortJoin(const std::vector<CastRelati
     //std::cout << "results.size(): " << results.size() << std::endl;
     //std::cout << "Created " << chunkNum << " Chunks" << std::endl;
     //std::cout << "results.size(): " << results.size() << std::endl;
-    //std::cout << "Max chunks in Queue: " << maxChunksInQueue << std::endl;
     //std::cout << "r_index: " << r_index.load() << std::endl;
     //std::cout << resultRelationToString(results[0]) << std::endl;
     //std::cout << resultRelationToString(results[results.size()-1]) << std::endl;
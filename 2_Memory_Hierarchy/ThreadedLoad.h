@@ -6,24 +6,22 @@
 #define THREADEDLOAD_H
 
 #include <vector>
-#include <queue>
 #include <iostream>
 #include <cassert>
 #include <thread>
-#include <condition_variable>
 #include <mutex>
+#include <stdexcept>
 
 #include "JoinUtils.hpp"
+#include "RingBuffer.h"
 
 #ifndef BLOCK_SIZE
 #define BLOCK_SIZE 4096
 #endif
 
 template<typename Relation>
-void inline processLine(std::string& line, std::vector<Relation>& data, std::mutex& m_data,
-                        Relation& record, std::mutex& m_cout) {
+void inline processLine(std::string& line, std::vector<Relation>& data, Relation& record, std::mutex& m_cout) {
     if(parseLine(line, record)) {
-        std::lock_guard l_data(m_data);
         data.emplace_back(record);
     } else {
         std::lock_guard l_cout(m_cout);
@@ -31,78 +29,52 @@ void inline processLine(std::string& line, std::vector<Relation>& data, std::mut
     }
 }
 
+/**
+ * @brief parses every complete line of chunk and appends the records to data
+ */
 template<typename Relation>
-void workerThread(std::mutex& m_cout, const std::atomic<bool>& stop, std::queue<std::string>& chunks, std::mutex& m_queue,
-                  std::condition_variable& cv_queue, std::vector<Relation>& data, std::mutex& m_data) {
-    /*
-    {
-        std::lock_guard lock(m_cout);
-        std::cout << std::this_thread::get_id() << "::threadedLoad::workerThread: starting processing" << std::endl;
-    }
-     */
-    std::string chunk;
-    std::istringstream raw;
+void inline parseChunk(const std::string& chunk, std::vector<Relation>& data, std::mutex& m_cout) {
+    assert(!chunk.empty());
+    std::istringstream raw(chunk);
     std::string line;
     Relation record{};
-    while(!stop || !chunks.empty()) {
-        std::unique_lock l_queue(m_queue);
-        cv_queue.wait(l_queue, [&stop, &chunks] {return stop || chunks.empty(); });
-        if(!chunks.empty()) { // As lock is created when stop is set, chunks might be empty when thread awakes
-            chunk = chunks.front();
-            chunks.pop();
-            l_queue.unlock();
-            assert(!chunk.empty());
-            raw.str(chunk);
-            while(!std::getline(raw, line).eof()) {
-                processLine<Relation>(line, data, m_data, record, m_cout);
-            }
-            raw.clear();
-        }
+    while(!std::getline(raw, line).eof()) {
+        processLine<Relation>(line, data, record, m_cout);
     }
-    /*
-    std::lock_guard l_cout(m_cout);
-    std::cout << std::this_thread::get_id() << "::threadedLoad::workerThread: finished" << std::endl;
-     */
 }
 
-
-template<typename Relation>
-std::vector<Relation> threadedLoad(const std::string& filepath, const size_t& bufferSize = BLOCK_SIZE) {
-    std::cout << "Loading " << filepath << std::endl;
-    std::vector<Relation> data;
-    std::queue<std::string> chunks;
-    std::mutex m_data;
-    std::mutex m_queue;
-    std::mutex m_cout;
-    std::condition_variable cv_queue;
-    std::atomic<bool> stop(false);
-
-    std::vector<std::jthread> threads(4);
-    for (auto & i : threads) {
-        i = std::jthread(workerThread<Relation>, std::ref(m_cout), std::ref(stop), std::ref(chunks), std::ref(m_queue), std::ref(cv_queue), std::ref(data), std::ref(m_data));
+/**
+ * @brief parses chunks until the reader closes the buffer, the records of every chunk are appended to data at once
+ */
+template<typename Relation, typename Allocator>
+void workerThread(std::mutex& m_cout, RingBuffer<std::string>& chunks, std::vector<Relation, Allocator>& data, std::mutex& m_data) {
+    std::string chunk;
+    std::vector<Relation> localData;
+    while(chunks.pop(chunk)) {
+        parseChunk<Relation>(chunk, localData, m_cout);
+        std::lock_guard l_data(m_data);
+        data.insert(data.end(), localData.begin(), localData.end());
+        localData.clear();
     }
+}
 
-
+/**
+ * @brief reads filepath in blocks of bufferSize bytes, skipping the header line, and pushes every block cut at its
+ * last newline into chunks. Every pushed chunk ends with a newline. Closes chunks when done, stops early if the
+ * consumer closed chunks
+ * @return false if the file could not be opened or read
+ */
+inline bool readChunks(const std::string& filepath, RingBuffer<std::string>& chunks, const size_t bufferSize = BLOCK_SIZE) {
     std::ifstream file(filepath, std::ios::in);
     if(!file) {
-        /*
-        {
-            std::scoped_lock l_cout(m_cout);
-            std::cerr << std::this_thread::get_id() << "threadedLoad: Could not open " << filepath << std::endl;
-        }
-         */
-        stop = true;
-        cv_queue.notify_all();
-        for(auto& t : threads) {
-            t.join();
-        }
-        return data;
+        chunks.close();
+        return false;
     }
     file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     std::string readBuffer;
-    readBuffer.resize(bufferSize);
     std::string leftovers;
     while(file) {
+        readBuffer.resize(bufferSize);
         file.read(readBuffer.data(), readBuffer.size());
         readBuffer.resize(file.gcount());
         if(!leftovers.empty()) {
@@ -113,24 +85,48 @@ std::vector<Relation> threadedLoad(const std::string& filepath, const size_t& bu
             leftovers.assign(readBuffer.begin() + newline + 1, readBuffer.end());
             readBuffer.resize(newline + 1);
         }
-        {
-            std::scoped_lock lock(m_queue);
-            chunks.emplace(readBuffer);
-            cv_queue.notify_one();
+        if(!readBuffer.empty()) {
+            if(!chunks.push(std::move(readBuffer))) {
+                return true;
+            }
+            readBuffer = std::string();
         }
-
     }
-    /*
-    {
-        std::scoped_lock l_cout(m_cout);
-        std::cout << "MainThread::threadedLoad: finished reading the file into chunks" << std::endl;
+    const bool read = !file.bad();
+    if(read && !leftovers.empty()) { // last line without a trailing newline
+        leftovers.push_back('\n');
+        chunks.push(std::move(leftovers));
     }
-     */
-    stop.store(true);
-    cv_queue.notify_all();
+    chunks.close();
+    return read;
+}
+
+
+/**
+ * @brief loads filepath with one reader and four parser threads
+ * @throws std::runtime_error if the file could not be opened or read
+ */
+template<typename Relation, typename Allocator = std::allocator<Relation>>
+std::vector<Relation, Allocator> threadedLoad(const std::string& filepath, const size_t& bufferSize = BLOCK_SIZE, const Allocator& allocator = Allocator()) {
+    std::cout << "Loading " << filepath << std::endl;
+    std::vector<Relation, Allocator> data(allocator);
+    RingBuffer<std::string> chunks;
+    std::mutex m_data;
+    std::mutex m_cout;
+
+    std::vector<std::jthread> threads(4);
+    for (auto & i : threads) {
+        i = std::jthread(workerThread<Relation, Allocator>, std::ref(m_cout), std::ref(chunks), std::ref(data), std::ref(m_data));
+    }
+
+
+    const bool read = readChunks(filepath, chunks, bufferSize);
     for(auto& t: threads) {
         t.join();
     }
+    if(!read) {
+        throw std::runtime_error("threadedLoad: could not read " + filepath);
+    }
     std::cout << "Loaded " << data.size() << " tuples from file!" << std::endl;
     return data;
 }
@@ -15,16 +15,21 @@
 #ifndef TIMERUTIL_HPP
 #define TIMERUTIL_HPP
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <chrono>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "Instrumentation.h"
+#include "PerfCounters.h"
+
 /**
  * @brief Util class to measure the time of NES components and sub-components
- * using snapshots
+ * using snapshots. Optionally every snapshot also carries the hardware event counts (PerfCounters) of its phase.
  */
 template<typename TimeUnit = std::chrono::nanoseconds,
          typename PrintTimeUnit = std::milli,
@@ -34,8 +39,8 @@ class Timer {
   public:
     class Snapshot {
       public:
-        Snapshot(std::string name, TimeUnit runtime, std::vector<Snapshot> children)
-            : name(std::move(name)), runtime(runtime), children(children){};
+        Snapshot(std::string name, TimeUnit runtime, std::vector<Snapshot> children, PerfCounts counts = {})
+            : name(std::move(name)), runtime(runtime), children(children), counts(counts){};
         int64_t getRuntime() { return runtime.count(); }
         PrintTimePrecision getPrintTime() {
             return std::chrono::duration_cast<std::chrono::duration<PrintTimePrecision, PrintTimeUnit>>(runtime).count();
@@ -44,9 +49,18 @@ class Timer {
         std::string name;
         TimeUnit runtime;
         std::vector<Snapshot> children;
+        PerfCounts counts; ///< hardware events of this snapshot, empty if the timer does not count them
     };
 
-    explicit Timer(std::string componentName) : componentName(std::move(componentName)){};
+    /**
+     * @param countEvents also count hardware events of the calling thread and the threads it starts while the timer
+     * runs, see PerfCounters. Falls back to time only if the counters are not available
+     */
+    explicit Timer(std::string componentName, bool countEvents = false) : componentName(std::move(componentName)) {
+        if (countEvents) {
+            counters = std::make_shared<PerfCounters>();
+        }
+    };
 
     /**
      * @brief starts the timer or resumes it after a pause
@@ -56,6 +70,7 @@ class Timer {
             std::cout << "Timer: Trying to start an already running timer so will skip this operation\n";
         } else {
             running = true;
+            readCounters(startCounts);
             start_p = ClockType::now();
         }
     };
@@ -71,6 +86,10 @@ class Timer {
 
             pausedDuration += duration;
             runtime += duration;
+            PerfCounts now;
+            if (readCounters(now)) {
+                counts += now - startCounts;
+            }
         }
     };
 
@@ -98,7 +117,14 @@ class Timer {
             auto duration = std::chrono::duration_cast<TimeUnit>(stop_p - start_p);
 
             runtime += duration;
-            snapshots.emplace_back(Snapshot(createFullyQualifiedSnapShotName(snapshotName), duration, std::vector<Snapshot>()));
+            PerfCounts now;
+            PerfCounts phase;
+            if (readCounters(now)) {
+                phase = now - startCounts;
+                counts += phase;
+                startCounts = now;
+            }
+            snapshots.emplace_back(Snapshot(createFullyQualifiedSnapShotName(snapshotName), duration, std::vector<Snapshot>(), phase));
 
             start_p = ClockType::now();
         }
@@ -115,10 +141,46 @@ class Timer {
             std::cout << "Timer: Trying to merge while timer is running so will skip this operation\n";
         } else {
             this->runtime += timer.runtime;
-            snapshots.emplace_back(Snapshot(componentName + '_' + timer.getComponentName(), timer.runtime, timer.getSnapshots()));
+            this->counts += timer.counts;
+            snapshots.emplace_back(Snapshot(componentName + '_' + timer.getComponentName(), timer.runtime, timer.getSnapshots(), timer.counts));
+        }
+    };
+
+    /**
+     * @brief adds the phases of an instrumented run as snapshots with one child per thread. A phase's runtime is the
+     * one of its slowest thread, its counts the hardware events of all threads if the run counted them. The overall
+     * runtime does not change, the phases ran while this timer was running
+     */
+    void merge(const InstrumentationReport& report) {
+        const auto toRuntime = [](double nanoseconds) {
+            return std::chrono::duration_cast<TimeUnit>(std::chrono::duration<double, std::nano>(nanoseconds));
+        };
+        for (std::size_t i = 0; i < NUM_PHASES; ++i) {
+            const auto phase = static_cast<Phase>(i);
+            if (report.totalNanoseconds(phase) == 0) {
+                continue;
+            }
+            const auto phaseName = createFullyQualifiedSnapShotName(::phaseName(phase));
+            std::vector<Snapshot> threadSnapshots;
+            for (std::size_t thread = 0; thread < report.threads.size(); ++thread) {
+                threadSnapshots.emplace_back(Snapshot(phaseName + "_thread" + std::to_string(thread), toRuntime(report.threads[thread].nanoseconds[i]), {},
+                                                      report.threads[thread].events[i]));
+            }
+            snapshots.emplace_back(Snapshot(phaseName, toRuntime(report.maxNanoseconds(phase)), threadSnapshots, report.totalEvents(phase)));
         }
     };
 
+    /**
+     * @brief adds counts measured elsewhere, e.g. by a PerfCounters(false) of a pooled worker thread, which the
+     * timer's own counters do not see
+     */
+    void mergeCounts(const PerfCounts& workerCounts) { counts += workerCounts; };
+
+    /**
+     * @brief hardware events counted while the timer was running, including merged ones
+     */
+    [[nodiscard]] const PerfCounts& getCounts() const { return counts; };
+
     /**
      * @brief returns the currently saved snapshots
      * @return reference to the saved snapshots
@@ -163,7 +225,7 @@ class Timer {
      * @brief overwrites insert string operator
      */
     friend std::ostream& operator<<(std::ostream& str, const Timer& t) {
-        str << "overall runtime: " << t.getPrintTime() << getTimeUnitString();
+        str << "overall runtime: " << t.getPrintTime() << getTimeUnitString() << countsString(t.counts);
         for (auto& s : t.getSnapshots()) {
             str << Timer<TimeUnit, PrintTimeUnit, PrintTimePrecision>::printHelper(std::string(), s);
         }
@@ -175,7 +237,7 @@ class Timer {
      */
     friend std::string printString(Timer t) {
         std::stringstream string;
-        string << "overall runtime: " << t.getPrintTime() << getTimeUnitString();
+        string << "overall runtime: " << t.getPrintTime() << getTimeUnitString() << countsString(t.counts);
         for (auto& s : t.getSnapshots()) {
             string << Timer<TimeUnit, PrintTimeUnit, PrintTimePrecision>::printHelper(std::string(), s);
         }
@@ -198,7 +260,7 @@ class Timer {
      */
     static std::string printHelper(std::string str, Snapshot s) {
         std::ostringstream ostr;
-        ostr << str << '\n' << s.name + ":\t" << s.getPrintTime() << getTimeUnitString();
+        ostr << str << '\n' << s.name + ":\t" << s.getPrintTime() << getTimeUnitString() << countsString(s.counts);
 
         for (auto& c : s.children) {
             ostr << printHelper(str, c);
@@ -224,7 +286,22 @@ class Timer {
         }
     }
 
+    static std::string countsString(const PerfCounts& counts) {
+        return counts.any() ? "\t[" + counts.toString() + "]" : std::string();
+    }
+
   private:
+    /**
+     * @brief reads the counters into counts, returns false if the timer does not count events
+     */
+    bool readCounters(PerfCounts& current) const {
+        if (!counters || !counters->available()) {
+            return false;
+        }
+        current = counters->read();
+        return true;
+    }
+
     /**
      * @brief component name to measure
      */
@@ -255,6 +332,21 @@ class Timer {
       */
     std::chrono::time_point<ClockType> stop_p;
 
+    /**
+     * @brief hardware event counters, shared by copies of the timer, null if events are not counted
+     */
+    std::shared_ptr<PerfCounters> counters;
+
+    /**
+     * @brief counter values at the last start or snapshot
+     */
+    PerfCounts startCounts;
+
+    /**
+     * @brief overall counted hardware events
+     */
+    PerfCounts counts;
+
     /**
      * @brief helper parameters
      */
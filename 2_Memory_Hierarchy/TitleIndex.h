@@ -0,0 +1,234 @@
+#ifndef PPDS_2_MEMORY_HIERARCHY_TITLEINDEX_H
+#define PPDS_2_MEMORY_HIERARCHY_TITLEINDEX_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <omp.h>
+
+#include "JoinUtils.hpp"
+#include "CustomAllocator.h"
+#include "FlatHashTable.h"
+
+/**
+ * @brief hash index over a title relation that is built once and never changes afterwards, so any number of threads
+ * can probe it at the same time with their own cast batches and the build is off the per-request path.
+ * The index owns one contiguous buffer holding a header, a copy of the titles and the slots of a FlatTitleTable over
+ * them. save() writes that buffer as is and open() maps it back read only, so a saved index is usable right after
+ * startup without parsing or rebuilding.
+ */
+class TitleIndex {
+public:
+    using Slot = FlatTitleTable::Slot;
+
+    static constexpr const uint32_t VERSION = 1;
+
+    /**
+     * @brief builds the index over titleRelation with numThreads threads inserting into one shared table
+     */
+    static TitleIndex build(const std::span<const TitleRelation> titleRelation, const int numThreads = std::jthread::hardware_concurrency()) {
+        const FlatTitleTable table(titleRelation, numThreads);
+        const auto bytes = bytesFor(titleRelation.size(), table.capacity());
+        void* data = allocateHugePages(bytes);
+        if(!data) {
+            throwBadAlloc();
+        }
+        TitleIndex index(data, bytes, false);
+        auto* header = static_cast<Header*>(data);
+        std::memcpy(header->magic, MAGIC, sizeof(header->magic));
+        header->version = VERSION;
+        header->tupleSize = sizeof(TitleRelation);
+        header->numTitles = titleRelation.size();
+        header->bits = static_cast<uint64_t>(std::countr_zero(table.capacity()));
+        auto* titles = reinterpret_cast<TitleRelation*>(static_cast<char*>(data) + titlesOffset());
+        auto* slots = reinterpret_cast<Slot*>(static_cast<char*>(data) + slotsOffset(titleRelation.size()));
+        const auto tableSlots = table.data();
+        #pragma omp parallel num_threads(numThreads)
+        {
+            #pragma omp for schedule(static) nowait
+            for(std::size_t i = 0; i < titleRelation.size(); ++i) {
+                titles[i] = titleRelation[i];
+            }
+            #pragma omp for schedule(static)
+            for(std::size_t i = 0; i < tableSlots.size(); ++i) {
+                slots[i] = tableSlots[i];
+            }
+        }
+        index.attach();
+        return index;
+    }
+
+    /**
+     * @brief maps an index written by save(), std::nullopt if the file is missing or was not written by this build
+     */
+    static std::optional<TitleIndex> open(const std::string& filepath) {
+        const int fd = ::open(filepath.c_str(), O_RDONLY);
+        if(fd < 0) {
+            std::cerr << "Error: Could not open index " << filepath << std::endl;
+            return std::nullopt;
+        }
+        struct stat status{};
+        if(fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(Header)) {
+            std::cerr << "Error: " << filepath << " is not a title index" << std::endl;
+            ::close(fd);
+            return std::nullopt;
+        }
+        const auto bytes = static_cast<std::size_t>(status.st_size);
+        void* data = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        ::close(fd); // the mapping keeps the file alive
+        if(data == MAP_FAILED) {
+            std::cerr << "Error: Could not map index " << filepath << std::endl;
+            return std::nullopt;
+        }
+        TitleIndex index(data, bytes, true);
+        const auto* header = static_cast<const Header*>(data);
+        if(std::memcmp(header->magic, MAGIC, sizeof(header->magic)) != 0 || header->version != VERSION
+           || header->tupleSize != sizeof(TitleRelation) || header->bits >= 64
+           || bytes != bytesFor(header->numTitles, std::size_t(1) << header->bits)) {
+            std::cerr << "Error: " << filepath << " is not a title index of this version" << std::endl;
+            return std::nullopt;
+        }
+        index.attach();
+        return index;
+    }
+
+    /**
+     * @brief writes the index to filepath, returns false if the file could not be written
+     */
+    bool save(const std::string& filepath) const {
+        std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        return static_cast<bool>(file);
+    }
+
+    TitleIndex(TitleIndex&& other) noexcept
+        : data(std::exchange(other.data, nullptr)), bytes(std::exchange(other.bytes, 0)), mapped(other.mapped),
+          titles(other.titles), slots(other.slots), bits(other.bits), mask(other.mask) {}
+
+    TitleIndex& operator=(TitleIndex&& other) noexcept {
+        if(this != &other) {
+            release();
+            data = std::exchange(other.data, nullptr);
+            bytes = std::exchange(other.bytes, 0);
+            mapped = other.mapped;
+            titles = other.titles;
+            slots = other.slots;
+            bits = other.bits;
+            mask = other.mask;
+        }
+        return *this;
+    }
+
+    TitleIndex(const TitleIndex&) = delete;
+    TitleIndex& operator=(const TitleIndex&) = delete;
+
+    ~TitleIndex() {
+        release();
+    }
+
+    [[nodiscard]] std::span<const TitleRelation> relation() const { return titles; }
+
+    /**
+     * @brief calls f(title) for every title with the given key
+     */
+    template<typename F>
+    void forEachMatch(const int32_t key, F&& f) const {
+        for(auto slot = FlatTitleTable::homeSlot(key, bits); slots[slot].row != FlatTitleTable::EMPTY; slot = (slot + 1) & mask) {
+            if(slots[slot].key == key) {
+                f(titles[slots[slot].row]);
+            }
+        }
+    }
+
+    /**
+     * @brief joins castRelation with the indexed titles, safe to call from several threads at once
+     */
+    [[nodiscard]] std::vector<ResultRelation> probe(const std::span<const CastRelation> castRelation, const int numThreads = std::jthread::hardware_concurrency()) const {
+        std::vector<std::vector<std::pair<const CastRelation*, const TitleRelation*>>> localResults(numThreads);
+        std::vector<ResultRelation> results;
+        #pragma omp parallel num_threads(numThreads)
+        {
+            const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+            auto& matches = localResults[thread];
+            #pragma omp for schedule(static)
+            for(std::size_t i = 0; i < castRelation.size(); ++i) {
+                const CastRelation& record = castRelation[i];
+                forEachMatch(record.movieId, [&matches, &record](const TitleRelation& title) {
+                    matches.emplace_back(&record, &title);
+                });
+            }
+            materializeLocalResults(localResults, results);
+        }
+        return results;
+    }
+
+private:
+    static constexpr const char MAGIC[8] = {'P', 'P', 'D', 'S', 'T', 'I', 'D', 'X'};
+
+    struct alignas(64) Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t tupleSize; ///< sizeof(TitleRelation) of the build that wrote the file
+        uint64_t numTitles;
+        uint64_t bits; ///< the table has 2^bits slots
+    };
+
+    TitleIndex(void* data, const std::size_t bytes, const bool mapped) : data(data), bytes(bytes), mapped(mapped) {}
+
+    static constexpr std::size_t titlesOffset() { return sizeof(Header); }
+
+    static constexpr std::size_t slotsOffset(const std::size_t numTitles) {
+        return (titlesOffset() + numTitles * sizeof(TitleRelation) + 63) & ~std::size_t(63);
+    }
+
+    static constexpr std::size_t bytesFor(const std::size_t numTitles, const std::size_t numSlots) {
+        return slotsOffset(numTitles) + numSlots * sizeof(Slot);
+    }
+
+    /**
+     * @brief points titles and slots into the buffer, the header has to be valid
+     */
+    void attach() {
+        const auto* header = static_cast<const Header*>(data);
+        const auto* base = static_cast<const char*>(data);
+        titles = std::span<const TitleRelation>(reinterpret_cast<const TitleRelation*>(base + titlesOffset()), header->numTitles);
+        slots = reinterpret_cast<const Slot*>(base + slotsOffset(header->numTitles));
+        bits = header->bits;
+        mask = (std::size_t(1) << bits) - 1;
+    }
+
+    void release() {
+        if(!data) {
+            return;
+        }
+        if(mapped) {
+            munmap(data, bytes);
+        } else {
+            freeHugePages(data, bytes);
+        }
+        data = nullptr;
+    }
+
+    void* data = nullptr;
+    std::size_t bytes = 0;
+    bool mapped = false; ///< data is a file mapping rather than an anonymous huge page buffer
+    std::span<const TitleRelation> titles;
+    const Slot* slots = nullptr;
+    std::size_t bits = 0;
+    std::size_t mask = 0;
+};
+
+#endif //PPDS_2_MEMORY_HIERARCHY_TITLEINDEX_H
@@ -1,5 +0,0 @@
-#pragma once
-constexpr const size_t L1_CACHE_SIZE=16384;
-constexpr const size_t L2_CACHE_SIZE=2097152;
-constexpr const size_t L3_CACHE_SIZE=-1;
-constexpr const char* CPU_NAME="Apple M2 Pro";
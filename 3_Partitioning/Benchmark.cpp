@@ -0,0 +1,41 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        https://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+ * Benchmarks the join engines of this stage on synthetic relations, see JoinBenchmark.h:
+ *
+ *   ./3_Partitioning_BENCHMARK --benchmark_filter='PartitionJoin/zipf' --benchmark_out=results.json --benchmark_out_format=json
+ *
+ * The partition join partitions its input in place, every iteration gets a fresh copy of the relations.
+ */
+
+#include "JoinUtils.hpp"
+#include "Partitioning.h"
+#include "HashJoin.h"
+#include "SortMergeJoin.h"
+#include "JoinBenchmark.h"
+
+#include <vector>
+
+using Relations = BenchmarkRelations<CastRelation, TitleRelation>;
+
+int main(int argc, char** argv) {
+    const std::vector<JoinBenchmarkEngine<CastRelation, TitleRelation, ResultRelation>> engines = {
+        {"CHJ_MAP", [](const Relations& r, int threads) {return performCHJ_MAP(r.cast, r.title, threads);}, true},
+        {"CacheSizedHJ", [](const Relations& r, int threads) {return performCacheSizedThreadedHashJoin(r.cast, r.title, threads);}, true},
+        {"SMJ_presorted", [](const Relations& r, int) {return performSortMergeJoin(r.sortedCast, r.sortedTitle);}, false, true},
+        {"PartitionJoin", [](const Relations& r, int threads) {return performPartitionJoin(r.cast, r.title, threads);}, true, false, false, true},
+    };
+    return runJoinBenchmarks(argc, argv, engines);
+}
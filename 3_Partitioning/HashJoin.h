@@ -98,7 +98,7 @@ std::vector<ResultRelation> performCHJ_MAP(const std::vector<CastRelation>& left
     return results;
 
 }
-static const size_t HASHMAP_SIZE = L2_CACHE_SIZE / (sizeof(CastRelation*) + sizeof(int32_t));
+static const size_t HASHMAP_SIZE = HardwareInfo::get().hashMapEntries(sizeof(CastRelation*) + sizeof(int32_t));
 
 struct ThreadArgs {
     int threadId;
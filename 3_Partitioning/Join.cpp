@@ -17,12 +17,26 @@
 #include <unordered_map>
 #include <iostream>
 #include <gtest/gtest.h>
-#include "generated_variables.h"
 #include "Partitioning.h"
 #include <bitset>
 #include "HashJoin.h"
 #include "TimerUtil.hpp"
 #include "SortMergeJoin.h"
+#include "DataGenerator.h"
+#include "DifferentialHarness.h"
+#include "SamplingProfiler.h"
+
+/**
+ * @brief in memory stand-in for the csv files of DataGenerators/data, numCasts cast tuples over numTitles titles
+ */
+static GeneratedRelations<CastRelation, TitleRelation> generateTestRelations(const std::size_t numCasts, const std::size_t numTitles,
+                                                                              const KeyDistribution distribution = KeyDistribution::UNIFORM) {
+    RelationSpec spec;
+    spec.numCasts = numCasts;
+    spec.numTitles = numTitles;
+    spec.distribution = distribution;
+    return generateRelations<CastRelation, TitleRelation>(spec);
+}
 
 std::vector<ResultRelation> performJoin(const std::vector<CastRelation>& castRelation, const std::vector<TitleRelation>& titleRelation, int numThreads) {
     auto results = performPartitionJoin(castRelation, titleRelation, numThreads);
@@ -36,8 +50,7 @@ std::vector<ResultRelation> performJoin(const std::vector<CastRelation>& castRel
 
 
 TEST(PartioningTest, TestJoiningTuples) {
-    const auto leftRelation = loadCastRelation(DATA_DIRECTORY + std::string("cast_info_uniform.csv"));
-    const auto rightRelation = loadTitleRelation(DATA_DIRECTORY + std::string("title_info_uniform.csv"));
+    const auto [leftRelation, rightRelation] = generateTestRelations(20000, 20000);
 
     auto results = performJoin(leftRelation, rightRelation, 8);
 }
@@ -59,7 +72,7 @@ TEST(PartioningTest, TestCastRadixPartition) {
 }
 
 TEST(PartioningTest, castPartition) {
-    auto leftRelation = loadCastRelation(DATA_DIRECTORY + std::string("cast_info_uniform1gb.csv"));
+    auto leftRelation = generateTestRelations(1 << 20, 1).cast;
     setMaxBitsToCompare(leftRelation.size());
     ThreadPool threadPool(16);
     std::mutex m;
@@ -80,7 +93,7 @@ TEST(PartioningTest, castPartition) {
 }
 
 TEST(PartioningTest, titlePartition) {
-    auto rightRelation = loadTitleRelation(DATA_DIRECTORY + std::string("title_info_uniform1gb.csv"));
+    auto rightRelation = generateTestRelations(0, 1 << 20).title;
     setMaxBitsToCompare(rightRelation.size());
     ThreadPool threadPool(16);
     std::mutex m;
@@ -104,7 +117,7 @@ TEST(PartioningTest, titlePartition) {
 
 
 TEST(PartitioningTest, TestTitleRadixPartition) {
-    auto titleRelations = loadTitleRelation(DATA_DIRECTORY + std::string("title_info_uniform1mb.csv"));
+    auto titleRelations = generateTestRelations(0, 1 << 12).title;
 
     auto split = titleRadixPartition(titleRelations.begin(), titleRelations.end(), 0);
     for(auto it = titleRelations.begin(); it != split; ++it) {
@@ -116,7 +129,7 @@ TEST(PartitioningTest, TestTitleRadixPartition) {
 }
 
 TEST(PartitioningTest, TestCastRadixPartition) {
-    auto castRelations = loadCastRelation(DATA_DIRECTORY + std::string("cast_info_uniform1mb.csv"));
+    auto castRelations = generateTestRelations(1 << 13, 1 << 12).cast;
     auto split = castRadixPartition(castRelations.begin(), castRelations.end(), 0);
     for(auto it = castRelations.begin(); it != split; ++it) {
         std::cout << std::bitset<sizeof(int32_t)*8>(it->movieId) << std::endl;
@@ -133,8 +146,7 @@ TEST(PartitioningTest, TestBitMask) {
 
 
 TEST(PartitioningTest, TestMatchingBins) {
-    auto castRelations = loadCastRelation(DATA_DIRECTORY + std::string("cast_info_uniform1mb.csv"));
-    auto titleRelations = loadTitleRelation(DATA_DIRECTORY + std::string("title_info_uniform.csv"));
+    auto [castRelations, titleRelations] = generateTestRelations(1 << 13, 20000);
     std::vector<std::span<CastRelation>> castPartitions;
     std::vector<std::span<TitleRelation>> titlePartitions;
     ThreadPool threadPool(std::thread::hardware_concurrency());
@@ -158,8 +170,7 @@ TEST(PartitioningTest, TestMatchingBins) {
 
 
 TEST(PartitioningTest, TestPerformJoin) {
-    const auto castRelations = loadCastRelation(DATA_DIRECTORY + std::string("cast_info_zipfian1gb.csv"));
-    const auto titleRelations = loadTitleRelation(DATA_DIRECTORY + std::string("title_info_uniform1gb.csv"));
+    const auto [castRelations, titleRelations] = generateTestRelations(1 << 18, 1 << 16, KeyDistribution::ZIPFIAN);
 
     Timer timer("timer");
     timer.start();
@@ -181,8 +192,7 @@ TEST(PartitioningTest, TestBullshit) {
 
 
 TEST(PartitioningTest, TestSortMergeFaster) {
-    const auto castRelations = loadCastRelation(DATA_DIRECTORY + std::string("cast_info_uniform1gb.csv"), 20000);
-    const auto titleRelations = loadTitleRelation(DATA_DIRECTORY + std::string("title_info_uniform1gb.csv"), 20000);
+    auto [castRelations, titleRelations] = generateTestRelations(20000, 20000);
     Timer timer("timer");
     timer.start();
     auto& castRelation = const_cast<std::vector<CastRelation>&>(castRelations);
@@ -192,4 +202,260 @@ TEST(PartitioningTest, TestSortMergeFaster) {
     timer.pause();
     std::cout << "Timer: " << printString(timer) << '\n';
     std::cout << "results.size(): " << results.size() << '\n';
-}
\ No newline at end of file
+}
+
+/**
+ * Runs the partition join and the sort merge joins of this stage on the datasets of the other stages and checks their
+ * results against a reference join as multisets.
+ */
+TEST(DifferentialTest, TestEnginesMatchReference) {
+    DifferentialHarness<CastRelation, TitleRelation, ResultRelation> harness(4);
+    harness.add("PartitionJoin", [](const auto& cast, const auto& title, int threads) {return performPartitionJoin(cast, title, threads);});
+    harness.add("SMJ", [](const auto& cast, const auto& title, int) {return performSortMergeJoin(cast, title);}, true);
+    harness.add("TSMJ", [](const auto& cast, const auto& title, int threads) {return performThreadedSortJoin(cast, title, threads);}, true);
+    for(const auto& outcome: runStandardDatasets(harness)) {
+        EXPECT_TRUE(outcome.correct) << outcome;
+    }
+    harness.print();
+}
+TEST(TopologyTest, TestCpuOrder) {
+    const auto& topology = Topology::get();
+    ASSERT_FALSE(topology.cpus().empty());
+    ASSERT_GE(topology.numNodes(), 1);
+    ASSERT_TRUE(topology.cpuOrder(AffinityPolicy::NONE, 4).empty());
+    for(const auto policy: {AffinityPolicy::COMPACT, AffinityPolicy::SCATTER, AffinityPolicy::PHYSICAL_CORES}) {
+        const auto numCpus = topology.cpus().size();
+        const auto order = topology.cpuOrder(policy, 2 * numCpus);
+        ASSERT_EQ(order.size(), 2 * numCpus);
+        // every cpu is used once before any is used twice
+        std::vector<int> firstRound(order.begin(), order.begin() + numCpus);
+        std::sort(firstRound.begin(), firstRound.end());
+        ASSERT_EQ(std::adjacent_find(firstRound.begin(), firstRound.end()), firstRound.end());
+    }
+    // pins a scratch thread, so the test runner and the threads of later tests keep their cpus
+    bool pinned = false;
+    std::jthread([&pinned, cpu = topology.cpus()[0].cpu] {pinned = pinCurrentThread(cpu);}).join();
+    ASSERT_TRUE(pinned);
+}
+
+TEST(TopologyTest, TestNodeOfAddress) {
+    std::vector<int> touched(1 << 20, 1);
+    const auto node = nodeOfAddress(touched.data());
+    ASSERT_LT(node, Topology::get().numNodes());
+}
+
+TEST(TopologyTest, TestThreadPoolOnNode) {
+    std::vector<std::future<int>> futures;
+    {
+        ThreadPool threadPool(4, AffinityPolicy::SCATTER);
+        for(int i = 0; i < 100; ++i) {
+            futures.emplace_back(threadPool.enqueueOnNode(i % (threadPool.numNodes() + 1) - 1, [i] {return i * i;}));
+        }
+        threadPool.wait_for_empty_queue();
+    }
+    for(int i = 0; i < 100; ++i) {
+        ASSERT_EQ(futures[i].get(), i * i);
+    }
+}
+
+TEST(InstrumentationTest, TestPerThreadPhases) {
+    Instrumentation::get().reset();
+    {
+        std::vector<std::jthread> threads;
+        for(int i = 0; i < 3; ++i) {
+            threads.emplace_back([i] {
+                {
+                    const PhaseScope build(Phase::BUILD, 100);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2 * (i + 1)));
+                }
+                const PhaseScope probe(Phase::PROBE, 1000);
+            });
+        }
+    }
+    Instrumentation::get().recordPartition(10, 5);
+    Instrumentation::get().recordPartition(30, 15);
+    const auto report = Instrumentation::get().report();
+    ASSERT_EQ(report.threads.size(), 3u);
+    ASSERT_EQ(report.totalTuples(Phase::BUILD), 300u);
+    ASSERT_EQ(report.totalTuples(Phase::PROBE), 3000u);
+    ASSERT_EQ(report.totalTuples(Phase::PARTITION), 0u);
+    ASSERT_GE(report.maxNanoseconds(Phase::BUILD), 5e6); // the slowest thread slept 6 ms
+    ASSERT_GT(report.imbalance(Phase::BUILD), 1.0);
+    ASSERT_EQ(report.partitionSizes.size(), 2u);
+    ASSERT_NE(report.toString().find("partitions: 2"), std::string::npos);
+
+    Timer timer("join");
+    timer.merge(report);
+    ASSERT_EQ(timer.getSnapshots().size(), 2u); // build and probe
+    ASSERT_EQ(timer.getSnapshots()[0].name, "join_build");
+    ASSERT_EQ(timer.getSnapshots()[0].children.size(), 3u);
+    ASSERT_EQ(timer.getRuntime(), 0);
+
+    Instrumentation::get().reset();
+    ASSERT_TRUE(Instrumentation::get().report().threads.empty());
+}
+
+TEST(InstrumentationTest, TestPhaseEvents) {
+    Instrumentation::get().reset(true);
+    volatile int64_t sum = 0;
+    std::jthread([&sum] {
+        const PhaseScope probe(Phase::PROBE, 1 << 20);
+        for(int64_t i = 0; i < (1 << 20); ++i) {
+            sum = sum + i;
+        }
+    }).join();
+    const auto report = Instrumentation::get().report();
+    ASSERT_EQ(sum, (int64_t(1 << 20) - 1) * (1 << 20) / 2);
+    Timer timer("join");
+    timer.merge(report);
+    ASSERT_EQ(timer.getSnapshots().size(), 1u);
+    if(PerfCounters().available()) {
+        ASSERT_TRUE(report.totalEvents(Phase::PROBE).any());
+        ASSERT_GT(report.totalEvents(Phase::PROBE)[PerfEvent::INSTRUCTIONS], uint64_t(1 << 20));
+        ASSERT_NE(report.toString().find("instructions="), std::string::npos);
+        ASSERT_TRUE(timer.getSnapshots()[0].counts.any());
+    } else {
+        ASSERT_FALSE(report.totalEvents(Phase::PROBE).any()); // time only
+    }
+    ASSERT_FALSE(report.totalEvents(Phase::BUILD).any());
+
+    Instrumentation::get().reset();
+    std::jthread([] {const PhaseScope probe(Phase::PROBE, 1);}).join();
+    ASSERT_FALSE(Instrumentation::get().report().totalEvents(Phase::PROBE).any());
+}
+
+TEST(InstrumentationTest, TestMemoryAccounting) {
+    Instrumentation::get().reset();
+    {
+        const MemorySampler sampler(std::chrono::microseconds(200));
+        std::jthread worker([] {
+            const PhaseScope build(Phase::BUILD);
+            std::vector<int32_t, CountingAllocator<int32_t, MemoryCategory::LOCAL_RESULTS>> buffer;
+            buffer.reserve(1 << 20);
+            std::unordered_map<int32_t, int32_t, std::hash<int32_t>, std::equal_to<int32_t>,
+                               CountingAllocator<std::pair<const int32_t, int32_t>, MemoryCategory::HASH_TABLE>> map;
+            for(int32_t i = 0; i < 1000; ++i) {
+                map.emplace(i, i);
+            }
+            Instrumentation::get().recordHashTable(map);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        });
+    }
+    Instrumentation::get().recordResize(MemoryCategory::RESULTS, 0, 640);
+    const auto report = Instrumentation::get().report();
+    std::cout << report.toString();
+    const auto& localResults = report.memory[static_cast<std::size_t>(MemoryCategory::LOCAL_RESULTS)];
+    ASSERT_EQ(localResults.allocatedBytes, (1u << 20) * sizeof(int32_t));
+    ASSERT_EQ(localResults.allocations, 1u);
+    ASSERT_EQ(localResults.peakBytes, static_cast<int64_t>(localResults.allocatedBytes));
+    ASSERT_EQ(localResults.sampledPeakBytes, localResults.peakBytes); // the worker held it for 20 ms
+    ASSERT_EQ(localResults.liveBytes, 0);
+    const auto& hashTable = report.memory[static_cast<std::size_t>(MemoryCategory::HASH_TABLE)];
+    ASSERT_GE(hashTable.allocations, 1000u);
+    ASSERT_EQ(hashTable.liveBytes, 0);
+    ASSERT_EQ(report.memory[static_cast<std::size_t>(MemoryCategory::RESULTS)].liveBytes, 640);
+    ASSERT_GE(report.phaseAllocatedBytes[static_cast<std::size_t>(Phase::BUILD)], localResults.allocatedBytes + hashTable.allocatedBytes);
+    ASSERT_EQ(report.hashTables, 1u);
+    ASSERT_EQ(report.hashTableEntries, 1000u);
+    ASSERT_GT(report.hashTableLoadFactor(), 0.0);
+    ASSERT_LE(report.hashTableLoadFactor(), 1.0);
+    ASSERT_GT(report.hashTableBytesPerEntry(), static_cast<double>(sizeof(std::pair<const int32_t, int32_t>)));
+    if(report.resident.peakBytes > 0) { // /proc/self/status exists
+        ASSERT_GE(report.resident.peakBytes, report.resident.currentBytes);
+        ASSERT_GT(report.phasePeakResidentBytes[static_cast<std::size_t>(Phase::BUILD)], 0u);
+    }
+}
+
+#if PPDS_INSTRUMENTATION
+TEST(InstrumentationTest, TestPartitionJoinPhases) {
+    std::vector<CastRelation> castRelation(50000);
+    std::vector<TitleRelation> titleRelation(10000);
+    for(int32_t i = 0; i < static_cast<int32_t>(castRelation.size()); ++i) {
+        castRelation[i].castInfoId = i;
+        castRelation[i].movieId = (i * 7919) % 10000;
+    }
+    for(int32_t i = 0; i < static_cast<int32_t>(titleRelation.size()); ++i) {
+        titleRelation[i].titleId = i;
+    }
+    Instrumentation::get().reset();
+    const auto results = performPartitionJoin(castRelation, titleRelation, 4);
+    const auto report = Instrumentation::get().report();
+    std::cout << report.toString();
+    ASSERT_EQ(report.totalTuples(Phase::PARTITION), castRelation.size() + titleRelation.size()); // once, not once per bit
+    ASSERT_FALSE(report.partitionSizes.empty());
+    std::size_t probed = 0;
+    for(const auto& [cast, title]: report.partitionSizes) {
+        probed += title > 0 ? cast : 0;
+    }
+    ASSERT_EQ(report.totalTuples(Phase::PROBE), probed);
+    ASSERT_EQ(report.totalTuples(Phase::MATERIALIZE), results.size());
+    ASSERT_EQ(report.hashTables, report.partitionSizes.size() - std::count_if(report.partitionSizes.begin(), report.partitionSizes.end(),
+                                                                               [](const auto& sizes) {return sizes.first == 0 || sizes.second == 0;}));
+    ASSERT_EQ(report.hashTableEntries, titleRelation.size());
+    ASSERT_EQ(report.memory[static_cast<std::size_t>(MemoryCategory::HASH_TABLE)].liveBytes, 0);
+    ASSERT_EQ(report.memory[static_cast<std::size_t>(MemoryCategory::LOCAL_RESULTS)].liveBytes, 0);
+    ASSERT_EQ(report.memory[static_cast<std::size_t>(MemoryCategory::RESULTS)].liveBytes,
+              static_cast<int64_t>(results.capacity() * sizeof(ResultRelation)));
+}
+#endif
+
+/**
+ * @brief keeps the calling thread busy for the given cpu time
+ */
+static uint64_t spin(const std::chrono::milliseconds cpuTime) {
+    volatile uint64_t sum = 0;
+    const auto end = std::clock() + static_cast<std::clock_t>(cpuTime.count() * CLOCKS_PER_SEC / 1000);
+    while(std::clock() < end) {
+        for(uint64_t i = 0; i < 10000; ++i) {
+            sum = sum + i * i;
+        }
+    }
+    return sum;
+}
+
+TEST(ProfilerTest, TestSamplesCarryPhases) {
+    auto& profiler = SamplingProfiler::get();
+    ASSERT_TRUE(profiler.start({.frequency = 1000}));
+    ASSERT_FALSE(profiler.start()); // one session at a time
+    {
+        const PhaseScope probe(Phase::PROBE);
+        spin(std::chrono::milliseconds(300));
+    }
+    spin(std::chrono::milliseconds(100));
+    profiler.stop();
+    ASSERT_FALSE(profiler.isRunning());
+
+    const auto samples = profiler.samples();
+    ASSERT_GT(profiler.samples(Phase::PROBE), 20u); // the timer is only as fine as the scheduler tick
+    ASSERT_GT(samples, profiler.samples(Phase::PROBE));
+    ASSERT_EQ(profiler.samples(Phase::BUILD), 0u);
+
+    const auto folded = profiler.folded();
+    std::istringstream lines(folded);
+    std::size_t counted = 0;
+    bool probeStack = false;
+    for(std::string line; std::getline(lines, line);) {
+        const auto separator = line.rfind(' ');
+        ASSERT_NE(separator, std::string::npos);
+        ASSERT_EQ(line[0], '[');
+        counted += std::stoul(line.substr(separator + 1));
+        probeStack |= line.starts_with("[probe];");
+    }
+    ASSERT_EQ(counted, samples);
+    ASSERT_TRUE(probeStack);
+    ASSERT_EQ(profiler.samples(), samples); // stopped, nothing is added anymore
+}
+
+#if PPDS_PROFILER
+TEST(ProfilerTest, TestPartitionJoinProfile) {
+    const auto [castRelation, titleRelation] = generateTestRelations(1 << 20, 1 << 16);
+    ASSERT_TRUE(SamplingProfiler::get().start());
+    const auto results = performPartitionJoin(castRelation, titleRelation, 4);
+    SamplingProfiler::get().stop();
+    ASSERT_FALSE(results.empty());
+    ASSERT_GT(SamplingProfiler::get().samples(), 0u);
+    ASSERT_TRUE(SamplingProfiler::get().writeFolded("partition_join.folded"));
+    std::cout << SamplingProfiler::get().samples(Phase::PARTITION) << " partition, " << SamplingProfiler::get().samples(Phase::BUILD)
+              << " build, " << SamplingProfiler::get().samples(Phase::PROBE) << " probe samples written to partition_join.folded" << std::endl;
+}
+#endif
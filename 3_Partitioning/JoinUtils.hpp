@@ -21,6 +21,12 @@
 #include <iostream>
 #include <vector>
 
+#include "HardwareInfo.h"
+
+static const size_t L1_CACHE_SIZE = HardwareInfo::get().l1CacheSize(); ///< per physical core
+static const size_t L2_CACHE_SIZE = HardwareInfo::get().l2CacheSize(); ///< per physical core
+static const size_t L3_CACHE_SIZE = HardwareInfo::get().l3CacheSize(); ///< shared
+
 //==--------------------------------------------------------------------==//
 //==------------------ RELATION & RELATION UTILITY----------------------==//
 //==--------------------------------------------------------------------==//
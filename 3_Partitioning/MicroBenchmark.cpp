@@ -0,0 +1,147 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        https://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+ * Micro-benchmarks of the building blocks of the partition join on their own, without loading, thread pool or
+ * materialization:
+ *
+ *   buildMap/probeMap  hash tables of one partition, swept over table sizes from L1 to DRAM
+ *   castRadixPartition throughput over the fan-out (2^bits partitions) and the size of the input
+ *
+ *   ./3_Partitioning_MICROBENCHMARK --benchmark_filter='probeMap' --benchmark_out=probe.json --benchmark_out_format=json
+ *
+ * The working set counter is the hash table for buildMap/probeMap, the relations are only streamed through, and the
+ * cast tuples for the partitioning.
+ */
+
+#include "JoinUtils.hpp"
+#include "Partitioning.h"
+#include "MicroBenchmark.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <span>
+#include <vector>
+
+static constexpr const std::size_t PROBE_TUPLES = 1 << 16;
+/// bucket pointer, next pointer and the key value pair of one std::unordered_map node
+static constexpr const std::size_t TITLE_MAP_ENTRY_BYTES = 2 * sizeof(void*) + sizeof(TitleMap::value_type);
+static constexpr const int32_t PARTITION_KEYS = 1 << 16;
+
+static std::vector<TitleRelation> shuffledTitles(const std::size_t n) {
+    std::vector<int32_t> ids(n);
+    std::iota(ids.begin(), ids.end(), 0);
+    std::shuffle(ids.begin(), ids.end(), std::mt19937_64(42));
+    std::vector<TitleRelation> titles(n);
+    for(std::size_t i = 0; i < n; ++i) {
+        titles[i].titleId = ids[i];
+    }
+    return titles;
+}
+
+static void benchmarkBuildMap(benchmark::State& state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    auto titles = shuffledTitles(n);
+    for(auto _ : state) {
+        state.PauseTiming();
+        TitleMap map;
+        map.reserve(n);
+        state.ResumeTiming();
+        buildMap(std::span<TitleRelation>(titles), map);
+        benchmark::DoNotOptimize(map.size());
+        state.PauseTiming(); // freeing the nodes is not part of the build
+        map = TitleMap();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+    setWorkingSet(state, n * TITLE_MAP_ENTRY_BYTES);
+}
+
+static void benchmarkProbeMap(benchmark::State& state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    auto titles = shuffledTitles(n);
+    TitleMap map;
+    map.reserve(n);
+    buildMap(std::span<TitleRelation>(titles), map);
+    const auto keys = uniformKeys(PROBE_TUPLES, static_cast<int32_t>(n));
+    std::vector<CastRelation> casts(PROBE_TUPLES);
+    for(std::size_t i = 0; i < PROBE_TUPLES; ++i) {
+        casts[i].movieId = keys[i];
+    }
+    LocalResults localResults;
+    localResults.reserve(PROBE_TUPLES);
+    for(auto _ : state) {
+        localResults.clear();
+        probeMap(std::span<CastRelation>(casts), map, localResults);
+        benchmark::DoNotOptimize(localResults.data());
+    }
+    if(localResults.size() != PROBE_TUPLES) {
+        state.SkipWithError("every probe should have found its title");
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * PROBE_TUPLES));
+    setWorkingSet(state, n * TITLE_MAP_ENTRY_BYTES);
+}
+
+/**
+ * @brief splits [begin, end) into 2^bits partitions, one castRadixPartition per bit like castPartition does
+ */
+static void radixPartition(const CastIterator begin, const CastIterator end, const uint8_t position, const uint8_t bits) {
+    if(position >= bits || begin == end) {
+        return;
+    }
+    const auto split = castRadixPartition(begin, end, position);
+    radixPartition(begin, split, position + 1, bits);
+    radixPartition(split, end, position + 1, bits);
+}
+
+static void benchmarkCastRadixPartition(benchmark::State& state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto bits = static_cast<uint8_t>(state.range(1));
+    const auto keys = uniformKeys(n, PARTITION_KEYS);
+    std::vector<CastRelation> input(n);
+    for(std::size_t i = 0; i < n; ++i) {
+        input[i].movieId = keys[i];
+    }
+    std::vector<CastRelation> casts;
+    for(auto _ : state) {
+        state.PauseTiming();
+        casts = input;
+        state.ResumeTiming();
+        radixPartition(casts.begin(), casts.end(), 0, bits);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * n * sizeof(CastRelation)));
+    state.counters["partitions"] = static_cast<double>(1 << bits);
+    setWorkingSet(state, n * sizeof(CastRelation));
+}
+
+int main(int argc, char** argv) {
+    const auto tableSizes = workingSetElements(TITLE_MAP_ENTRY_BYTES, TITLE_MAP_ENTRY_BYTES + sizeof(TitleRelation));
+    benchmark::RegisterBenchmark("buildMap", benchmarkBuildMap)->ArgsProduct({tableSizes})->ArgNames({"entries"})->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark("probeMap", benchmarkProbeMap)->ArgsProduct({tableSizes})->ArgNames({"entries"})->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark("castRadixPartition", benchmarkCastRadixPartition)
+        ->ArgsProduct({workingSetElements(sizeof(CastRelation), 2 * sizeof(CastRelation)), {1, 2, 4, 6, 8}})
+        ->ArgNames({"tuples", "bits"})
+        ->Unit(benchmark::kMicrosecond);
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    addCacheContext();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
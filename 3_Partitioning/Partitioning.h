@@ -10,13 +10,14 @@
 #include <thread>
 #include <cmath>
 #include "JoinUtils.hpp"
-#include "generated_variables.h"
 #include <span>
 #include "ThreadPool.h"
 #include <map>
 #include <cassert>
 #include <functional>
 #include "MemoryLocker.h"
+#include "Topology.h"
+#include "Instrumentation.h"
 using CastIterator = std::vector<CastRelation>::iterator;
 using TitleIterator = std::vector<TitleRelation>::iterator;
 
@@ -28,7 +29,9 @@ static std::condition_variable cv_threads;
 static std::mutex m_threads;
 static std::atomic_size_t missingPartitions;
 
-constexpr const std::size_t MAX_HASHMAP_SIZE = L2_CACHE_SIZE / (sizeof(int32_t) + sizeof(CastRelation*));
+static constexpr const AffinityPolicy PARTITION_AFFINITY = AffinityPolicy::SCATTER; ///< spreads the workers over all memory controllers
+
+static const std::size_t MAX_HASHMAP_SIZE = HardwareInfo::get().hashMapEntries(sizeof(int32_t) + sizeof(CastRelation*));
 
 
 
@@ -50,6 +53,14 @@ inline size_t averagePartitionSize(const std::vector<std::span<TitleRelation>>&
 
 
 
+/**
+ * returns the NUMA node the first record of a partition lives on, so the partition is processed by a worker of that node
+ */
+template<typename Iterator>
+inline int nodeOfPartition(const Iterator begin, const Iterator end) {
+    return begin == end ? -1 : nodeOfAddress(std::to_address(begin));
+}
+
 /**
  * returns the bit in the number at pos
  */
@@ -70,6 +81,14 @@ inline void setMaxBitsToCompare(const std::size_t numThreads) {
     numPartitionsToExpect = static_cast<std::size_t>(std::pow(2, maxBitsToCompare));
 }
 
+/**
+ * sets the radix bits from the hardware: enough partitions for all threads whose hash maps fit into L2, bounded by the TLB
+ */
+inline void setMaxBitsToCompare(const std::size_t numThreads, const std::size_t buildTuples) {
+    maxBitsToCompare = HardwareInfo::get().partitionBits(buildTuples, sizeof(int32_t) + sizeof(CastRelation*), numThreads);
+    numPartitionsToExpect = static_cast<std::size_t>(1) << maxBitsToCompare;
+}
+
 inline uint32_t bitmask() {
     uint32_t mask = 0;
     for(int i = 0; i < maxBitsToCompare; ++i) {
@@ -78,20 +97,31 @@ inline uint32_t bitmask() {
     return mask;
 }
 
+/**
+ * hash table of one partition, accounted as MemoryCategory::HASH_TABLE in instrumented builds
+ */
+using TitleMap = std::unordered_map<int32_t, const TitleRelation*, std::hash<int32_t>, std::equal_to<int32_t>,
+                                    AccountedAllocator<std::pair<const int32_t, const TitleRelation*>, MemoryCategory::HASH_TABLE>>;
+/**
+ * matches of one partition before they are materialized, accounted as MemoryCategory::LOCAL_RESULTS
+ */
+using LocalResults = std::vector<std::pair<const CastRelation*, const TitleRelation*>,
+                                 AccountedAllocator<std::pair<const CastRelation*, const TitleRelation*>, MemoryCategory::LOCAL_RESULTS>>;
+
 struct PartitionPair {
     std::atomic_bool alreadyStored = false;
     std::span<CastRelation> castSpan;
     std::span<TitleRelation> titleSpan;
 };
 
-inline void buildMap(const std::span<TitleRelation>& rightRelation, std::unordered_map<int32_t, const TitleRelation*>& map) {
+inline void buildMap(const std::span<TitleRelation>& rightRelation, TitleMap& map) {
+    PPDS_PHASE(Phase::BUILD, rightRelation.size());
     for(const auto& record: rightRelation) {
         map.emplace(record.titleId, &record);
     }
 }
 
-inline void probeMap(const std::span<CastRelation>& leftRelation, const std::unordered_map<int32_t, const TitleRelation*>& map,
-                     std::vector<std::pair<const CastRelation*, const TitleRelation*>>& localResults) {
+inline void probeMap(const std::span<CastRelation>& leftRelation, const TitleMap& map, LocalResults& localResults) {
     const auto mapEnd = map.end();
     for(const auto& record: leftRelation) {
         auto it = map.find(record.movieId);
@@ -101,41 +131,44 @@ inline void probeMap(const std::span<CastRelation>& leftRelation, const std::uno
     }
 }
 
-inline void
-chunkProcessing(const std::span<CastRelation> &leftRelation, std::unordered_map<int32_t, const TitleRelation *> &map,
-                std::vector<std::pair<const CastRelation *, const TitleRelation *>> &localResults) {
-    auto chunkStart = leftRelation.begin();
-    auto chunkEnd = leftRelation.begin();
-    while(chunkStart != leftRelation.end()) {
-        if(std::distance(chunkEnd, leftRelation.end()) < MAX_HASHMAP_SIZE) {
-            chunkEnd = std::next(chunkEnd, MAX_HASHMAP_SIZE);
-        } else {
-            chunkEnd = leftRelation.end();
-        }
-        probeMap(leftRelation, map, localResults);
-        map.clear();
-        chunkStart = chunkEnd;
+/**
+ * @brief probes map with leftRelation in chunks of MAX_HASHMAP_SIZE cast tuples, the probe phase counts every tuple of
+ * the partition once
+ */
+inline void chunkProcessing(const std::span<CastRelation>& leftRelation, const TitleMap& map, LocalResults& localResults) {
+    PPDS_PHASE(Phase::PROBE, leftRelation.size());
+    for(std::size_t chunkStart = 0; chunkStart < leftRelation.size(); chunkStart += MAX_HASHMAP_SIZE) {
+        probeMap(leftRelation.subspan(chunkStart, std::min(MAX_HASHMAP_SIZE, leftRelation.size() - chunkStart)), map, localResults);
     }
 }
 
-inline void writeLocalResults(const std::vector<std::pair<const CastRelation*, const TitleRelation*>>& localResults,
+inline void writeLocalResults(const LocalResults& localResults,
                               std::vector<ResultRelation>& results, std::mutex& m_results) {
-    std::lock_guard lk(m_results);
+    std::unique_lock lk(m_results, std::defer_lock);
+    {
+        PPDS_PHASE(Phase::WAIT, 0);
+        lk.lock();
+    }
+    PPDS_PHASE(Phase::MATERIALIZE, localResults.size());
+    [[maybe_unused]] const auto capacity = results.capacity();
     for(const auto& [castPointer, titlePointer]: localResults) {
         results.emplace_back(createResultTuple(*castPointer, *titlePointer));
     }
+    PPDS_RESIZE(MemoryCategory::RESULTS, capacity * sizeof(ResultRelation), results.capacity() * sizeof(ResultRelation));
 }
 
 inline void hashJoinMap(std::span<CastRelation> leftRelation, std::span<TitleRelation> rightRelation, std::vector<ResultRelation>& results,
                         std::mutex& m_results) {
+    PPDS_PARTITION(leftRelation.size(), rightRelation.size());
     if (leftRelation.empty() || rightRelation.empty()) {
         return;
     }
-    std::vector<std::pair<const CastRelation*, const TitleRelation*>> localResults;
+    LocalResults localResults;
     localResults.reserve(leftRelation.size());
-    std::unordered_map<int32_t, const TitleRelation *> map;
+    TitleMap map;
     map.reserve(rightRelation.size());
     buildMap(rightRelation, map);
+    PPDS_HASH_TABLE(map);
     chunkProcessing(leftRelation, map, localResults);
     writeLocalResults(localResults, results, m_results);
 }
@@ -147,8 +180,10 @@ inline void hashJoinMap(std::span<CastRelation> leftRelation, std::span<TitleRel
  * @param position the bit position to compare
  * @return an iterator to the first element of the right partition
  *
+ * Every tuple passes once per bit, the partition phase counts it only in the pass over the first bit.
  */
 inline std::vector<CastRelation>::iterator castRadixPartition(const CastIterator& begin, const CastIterator& end, const uint8_t& position) {
+    PPDS_PHASE(Phase::PARTITION, position == 0 ? std::distance(begin, end) : 0);
     auto zeroBin = begin;
     auto oneBin = end;
     while(zeroBin != oneBin && zeroBin != end) {
@@ -167,8 +202,10 @@ inline std::vector<CastRelation>::iterator castRadixPartition(const CastIterator
  * @param position the bit position to compare
  * @return an iterator to the first element of the right partition
  *
+ * Counts its tuples in the partition phase only in the pass over the first bit, see castRadixPartition.
  */
 inline std::vector<TitleRelation>::iterator titleRadixPartition(const TitleIterator begin, const TitleIterator end, const uint8_t& position) {
+    PPDS_PHASE(Phase::PARTITION, position == 0 ? std::distance(begin, end) : 0);
     auto zeroBin = begin;
     auto oneBin = end;
     while(zeroBin != oneBin) {
@@ -208,7 +245,7 @@ void inline titlePartition(ThreadPool& threadPool, const TitleIterator begin, co
         return;
     }
     auto split = titleRadixPartition(begin, end, position);
-    threadPool.enqueue(titlePartition, std::ref(threadPool), begin, split, position + 1, std::ref(partitions), std::ref(results), std::ref(m_results));
+    threadPool.enqueueOnNode(nodeOfPartition(begin, split), titlePartition, std::ref(threadPool), begin, split, position + 1, std::ref(partitions), std::ref(results), std::ref(m_results));
     titlePartition(std::ref(threadPool), split, end,position + 1, std::ref(partitions), std::ref(results), std::ref(m_results));
 }
 
@@ -233,7 +270,7 @@ void inline castPartition(ThreadPool& threadPool, const CastIterator begin, cons
         return;
     }
     auto split = castRadixPartition(begin, end, position);
-    threadPool.enqueue(castPartition, std::ref(threadPool), begin, split, position + 1, std::ref(partitions), std::ref(results), std::ref(m_results));
+    threadPool.enqueueOnNode(nodeOfPartition(begin, split), castPartition, std::ref(threadPool), begin, split, position + 1, std::ref(partitions), std::ref(results), std::ref(m_results));
     castPartition(threadPool, split, end, position + 1, partitions, results, m_results);
 }
 
@@ -242,7 +279,7 @@ void inline castPartition(ThreadPool& threadPool, const CastIterator begin, cons
 void inline partition(ThreadPool& threadPool, std::vector<CastRelation>& leftRelation, std::vector<TitleRelation>& rightRelation,
                       std::vector<PartitionPair>& partitions, std::vector<ResultRelation>& results, std::mutex& m_results) {
     //castPartition(threadPool, leftRelation.begin(), leftRelation.end(), 0, partitions, results, m_results);
-    threadPool.enqueue(castPartition, std::ref(threadPool), leftRelation.begin(), leftRelation.end(), 0, std::ref(partitions), std::ref(results), std::ref(m_results));
+    threadPool.enqueueOnNode(nodeOfPartition(leftRelation.begin(), leftRelation.end()), castPartition, std::ref(threadPool), leftRelation.begin(), leftRelation.end(), 0, std::ref(partitions), std::ref(results), std::ref(m_results));
     titlePartition( std::ref(threadPool), rightRelation.begin(), rightRelation.end(), 0, std::ref(partitions), std::ref(results), std::ref(m_results));
 }
 
@@ -259,20 +296,26 @@ void unlockAllMemory() {
 }
 
 std::vector<ResultRelation> performPartitionJoin(const std::vector<CastRelation>& leftRelation, const std::vector<TitleRelation>& rightRelation, unsigned int numThreads = std::jthread::hardware_concurrency()) {
-    setMaxBitsToCompare(numThreads);
+    setMaxBitsToCompare(numThreads, rightRelation.size());
     missingPartitions.store(numPartitionsToExpect);
     auto& castRelation = const_cast<std::vector<CastRelation>&>(leftRelation);
     auto& titleRelation = const_cast<std::vector<TitleRelation>&>(rightRelation);
     //auto castRelation(leftRelation);
     //auto titleRelation(rightRelation);
+    [[maybe_unused]] const auto relationBytes = leftRelation.size() * sizeof(CastRelation) + rightRelation.size() * sizeof(TitleRelation);
+    PPDS_RESIZE(MemoryCategory::RELATIONS, 0, relationBytes);
     std::vector<PartitionPair> partitions(numPartitionsToExpect);
-    ThreadPool threadPool(numThreads);
+    PPDS_RESIZE(MemoryCategory::PARTITIONS, 0, partitions.capacity() * sizeof(PartitionPair));
+    ThreadPool threadPool(numThreads, PARTITION_AFFINITY);
     std::vector<ResultRelation> results;
     results.reserve(26810);
+    PPDS_RESIZE(MemoryCategory::RESULTS, 0, results.capacity() * sizeof(ResultRelation));
     std::mutex m_results;
     partition(threadPool, castRelation, titleRelation, partitions, results, m_results);
     std::unique_lock l_threads(m_threads);
     cv_threads.wait(l_threads, []{return missingPartitions == 0;});
+    PPDS_RESIZE(MemoryCategory::PARTITIONS, partitions.capacity() * sizeof(PartitionPair), 0);
+    PPDS_RESIZE(MemoryCategory::RELATIONS, relationBytes, 0);
     return results;
 }
 
@@ -7,13 +7,11 @@
 
 #include "JoinUtils.hpp"
 #include "HashJoin.h"
-#include "generated_variables.h"
 
 #include <span>
 #include <thread>
 #include <ranges>
 #include <algorithm>
-#include <execution>
 #include <iterator>
 #include <iostream>
 #include <vector>
@@ -161,9 +159,9 @@ std::vector<ResultRelation> performThreadedSortJoin(const std::vector<CastRelati
         return performSortMergeJoin(leftRelation, rightRelation);
     }
     std::cout << "CastRelation Min: " << leftRelation[0].movieId << '\n';
-    std::cout << "CastRelation Max: " << leftRelation[leftRelation.size()].movieId << '\n';
+    std::cout << "CastRelation Max: " << leftRelation.back().movieId << '\n';
     std::cout << "TitleRelation Min: " << rightRelation[0].titleId << '\n';
-    std::cout << "TitleRelation Max: " << rightRelation[rightRelation.size()].titleId << '\n';
+    std::cout << "TitleRelation Max: " << rightRelation.back().titleId << '\n';
     const std::size_t chunkSize = (leftRelation.size() / numThreads) > 0 ? leftRelation.size() / numThreads: leftRelation.size();
     //std::vector<ResultRelation> results(leftRelation.size());
     //std::cout << "Initialized results with a size of " << leftRelation.size() << " | size: " << results.size() << std::endl;
@@ -7,69 +7,118 @@
 #include <functional>
 #include <future>
 #include <type_traits>
+#include "Topology.h"
 
+/**
+ * Workers are pinned according to the AffinityPolicy and every NUMA node has its own task queue. A worker takes tasks
+ * of its own node first and only steals from other nodes when that queue is empty.
+ */
 class ThreadPool {
 public:
-    ThreadPool(size_t threads);
+    ThreadPool(size_t threads, AffinityPolicy policy = AffinityPolicy::NONE);
     template<class F, class... Args>
     auto enqueue(F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type>;
+    template<class F, class... Args>
+    auto enqueueOnNode(int node, F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type>;
     void wait_for_empty_queue();
+    [[nodiscard]] int numNodes() const { return static_cast<int>(tasks.size()); }
     ~ThreadPool();
 private:
+    bool empty() const;
+    bool popTask(int node, std::function<void()>& task);
+
     std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
+    std::vector<std::queue<std::function<void()>>> tasks; ///< one queue per NUMA node
     std::mutex queue_mutex;
     std::condition_variable condition;
     std::condition_variable empty_queue_condition;
     bool stop;
 };
 
-ThreadPool::ThreadPool(size_t threads) : stop(false) {
+ThreadPool::ThreadPool(size_t threads, AffinityPolicy policy) : tasks(Topology::get().numNodes()), stop(false) {
+    const auto& topology = Topology::get();
+    const auto cpus = topology.cpuOrder(policy, threads);
     for(size_t i = 0; i < threads; ++i) {
+        const int node = cpus.empty() ? static_cast<int>(i % tasks.size()) : topology.nodeOfCpu(cpus[i]);
         workers.emplace_back(
-                [this] {
+                [this, node] {
                     for(;;) {
                         std::function<void()> task;
                         {
                             std::unique_lock<std::mutex> lock(this->queue_mutex);
-                            this->condition.wait(lock, [this]{ return this->stop || !this->tasks.empty(); });
-                            if(this->stop && this->tasks.empty())
+                            this->condition.wait(lock, [this]{ return this->stop || !this->empty(); });
+                            if(this->stop && this->empty())
                                 return;
-                            task = std::move(this->tasks.front());
-                            this->tasks.pop();
+                            this->popTask(node, task);
                         }
                         task();
                         {
                             std::unique_lock<std::mutex> lock(this->queue_mutex);
-                            if (this->tasks.empty()) {
+                            if (this->empty()) {
                                 this->empty_queue_condition.notify_all();
                             }
                         }
                     }
                 }
         );
+        if(!cpus.empty()) {
+            pinThread(workers.back().native_handle(), cpus[i]);
+        }
     }
 }
 
 template<class F, class... Args>
 auto ThreadPool::enqueue(F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type> {
+    return enqueueOnNode(-1, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+/**
+ * @param node NUMA node whose workers should run the task, e.g. the node the task's data was first touched on.
+ * Values outside [0, numNodes()) put the task on node 0's queue, where every idle worker will find it
+ */
+template<class F, class... Args>
+auto ThreadPool::enqueueOnNode(int node, F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type> {
     using return_type = typename std::invoke_result<F, Args...>::type;
     auto task = std::make_shared<std::packaged_task<return_type()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
     std::future<return_type> res = task->get_future();
+    if(node < 0 || node >= numNodes()) {
+        node = 0;
+    }
     {
         std::unique_lock<std::mutex> lock(queue_mutex);
         if(stop) {
             //std::cerr << "enqueue on stopped ThreadPool" << std::endl;
         }
-        tasks.emplace([task](){ (*task)(); });
+        tasks[node].emplace([task](){ (*task)(); });
     }
     condition.notify_one();
     return res;
 }
 
+bool ThreadPool::empty() const {
+    for(const auto& queue: tasks) {
+        if(!queue.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ThreadPool::popTask(int node, std::function<void()>& task) {
+    for(size_t i = 0; i < tasks.size(); ++i) {
+        auto& queue = tasks[(node + i) % tasks.size()];
+        if(!queue.empty()) {
+            task = std::move(queue.front());
+            queue.pop();
+            return true;
+        }
+    }
+    return false;
+}
+
 void ThreadPool::wait_for_empty_queue() {
     std::unique_lock<std::mutex> lock(queue_mutex);
-    empty_queue_condition.wait(lock, [this]{ return this->tasks.empty(); });
+    empty_queue_condition.wait(lock, [this]{ return this->empty(); });
 }
 
 ThreadPool::~ThreadPool() {
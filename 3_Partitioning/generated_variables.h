@@ -1,7 +0,0 @@
-// Now constantly defined -> no script
-#ifndef GENERATED_VARIABLES_H
-#define GENERATED_VARIABLES_H
-constexpr const size_t L1_CACHE_SIZE=256*1024/8;
-constexpr const size_t L2_CACHE_SIZE=2*1024*1024/8;
-constexpr const size_t L3_CACHE_SIZE=16*1024*1024;
-#endif // GENERATED_VARIABLES_H
\ No newline at end of file
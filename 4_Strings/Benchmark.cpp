@@ -0,0 +1,46 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        https://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+ * Benchmarks the string joins of this stage on synthetic relations, see JoinBenchmark.h. The note of every cast tuple
+ * equals the title of one title tuple, so every join finds at least those pairs:
+ *
+ *   ./4_Strings_BENCHMARK --benchmark_filter='EqualityJoin' --benchmark_out=results.json --benchmark_out_format=json
+ */
+
+#include "JoinUtils.hpp"
+#include "Join.hpp"
+#include "JoinBenchmark.h"
+
+#include <vector>
+
+using Relations = BenchmarkRelations<CastRelation, TitleRelation>;
+
+int main(int argc, char** argv) {
+    JoinBenchmarkConfig config;
+    config.datasets = {BenchmarkDataset::STRINGS};
+    // the strings are row numbers, which share most of their q-grams, so the prefix and similarity joins see many
+    // candidates per note and the sizes stay small
+    config.castSizes = {1 << 12, 1 << 14};
+    // row numbers are within edit distance 2 of hundreds of other rows
+    SimilarityPredicate predicate;
+    predicate.maxDistance = 1;
+    const std::vector<JoinBenchmarkEngine<CastRelation, TitleRelation, ResultRelation>> engines = {
+        {"PrefixJoin", [](const Relations& r, int threads) {return performJoin(r.cast, r.title, threads);}, true},
+        {"SortJoin", [](const Relations& r, int threads) {return performSortJoin(r.cast, r.title, threads);}, true},
+        {"EqualityJoin", [](const Relations& r, int threads) {return performEqualityJoin(r.cast, r.title, threads);}, true},
+        {"SimilarityJoin", [predicate](const Relations& r, int threads) {return performSimilarityJoin(r.cast, r.title, predicate, threads);}, true},
+    };
+    return runJoinBenchmarks(argc, argv, engines, config);
+}
@@ -15,71 +15,349 @@
 #include "TimerUtil.hpp"
 #include "JoinUtils.hpp"
 #include "Trie.h"
+#include "StringCompression.h"
+#include "StringKernels.h"
+#include "StringSort.h"
+#include "SimilarityJoin.h"
 #include <unordered_map>
 #include <thread>
 #include <iostream>
 #include <gtest/gtest.h>
 #include <string_view>
+#include <mutex>
+#include <cmath>
 #include <omp.h>
 
 static int counterTest = 0;
 
-std::string compressString(const std::string &input) {
-    if (input.empty()) return "";
-    if(input[0] != '1') return input;
+/**
+ * @brief note of a cast tuple split into the codes every title starting with the note shares and the raw tail
+ * that has to be compared against the decoded title, see SymbolTable::encodeStablePrefix
+ */
+struct CompressedNote {
+    const CastRelation* tuple;
+    uint8_t tailLength;
+    char tail[SymbolTable::MAX_SYMBOL_LENGTH - 1];
+};
 
-    std::string compressed;
-    compressed.reserve(input.size()); // Reserve space to avoid multiple allocations
-
-    char currentChar = input[0];
-    int count = 1;
+/**
+ * @brief prefix join between CastRelation::note and TitleRelation::title on compressed strings. Every note that is a
+ * prefix of a title is joined with it.
+ *
+ * Both columns are encoded with a SymbolTable trained on them, the Trie is built over the stable code prefix of
+ * every note, so it has one level per code instead of one per character. Notes too short to have a stable code
+ * prefix are looked up by their raw bytes.
+ */
+std::vector<ResultRelation> performJoin(const std::vector<CastRelation>& castRelation, const std::vector<TitleRelation>& titleRelation, int numThreads) {
+    const auto table = SymbolTable::build(sampleColumns(castRelation, &CastRelation::note, titleRelation, &TitleRelation::title));
+    std::vector<CompressedNote> notes(castRelation.size());
+    Trie<CompressedNote> trie;
+    #pragma omp parallel for num_threads(numThreads)
+    for(std::size_t i = 0; i < castRelation.size(); ++i) {
+        std::string stableCodes;
+        const auto note = columnView(castRelation[i].note);
+        const auto covered = table.encodeStablePrefix(note, stableCodes);
+        notes[i].tuple = &castRelation[i];
+        notes[i].tailLength = static_cast<uint8_t>(note.size() - covered);
+        std::memcpy(notes[i].tail, note.data() + covered, notes[i].tailLength);
+        trie.insert(stableCodes, &notes[i]);
+    }
+    std::unordered_map<std::string_view, std::vector<const CastRelation*>, std::hash<std::string_view>, StringEquals> shortNotes;
+    for(const auto& note: notes) {
+        const auto length = strnlen(note.tuple->note, sizeof(note.tuple->note));
+        if(length > 0 && note.tailLength == length) {
+            shortNotes[std::string_view(note.tuple->note, length)].emplace_back(note.tuple);
+        }
+    }
 
-    for (size_t i = 1; i < input.size(); ++i) {
-        if (input[i] == currentChar) {
-            ++count;
-        } else {
-            compressed += currentChar;
-            if (count > 1) {
-                compressed += '*';
-                compressed += std::to_string(count);
+    // every thread collects its matches locally, the output is then sized exactly and each thread materializes its
+    // matches into its own range, so neither pass shares a counter
+    std::vector<std::vector<std::pair<const CastRelation*, const TitleRelation*>>> localResults(numThreads);
+    std::vector<ResultRelation> results;
+    #pragma omp parallel num_threads(numThreads)
+    {
+        const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+        auto& matches = localResults[thread];
+        #pragma omp for schedule(dynamic, 64)
+        for(const auto& titleTuple: titleRelation) {
+            const auto title = columnView(titleTuple.title);
+            for(std::size_t length = 1; length < SymbolTable::MAX_SYMBOL_LENGTH && length <= title.size(); ++length) {
+                if(const auto it = shortNotes.find(title.substr(0, length)); it != shortNotes.end()) {
+                    for(const auto& castTuple : it->second) {
+                        matches.emplace_back(castTuple, &titleTuple);
+                    }
+                }
             }
-            currentChar = input[i];
-            count = 1;
+            const auto codes = table.encode(title);
+            trie.forEachPrefix(codes, [&](const std::vector<const CompressedNote*>& candidates, std::size_t depth) {
+                for(const auto& note : candidates) {
+                    if(table.continuesWith(codes, depth, std::string_view(note->tail, note->tailLength))) {
+                        matches.emplace_back(note->tuple, &titleTuple);
+                    }
+                }
+            });
         }
+        materializeLocalResults(localResults, results);
     }
+    return results;
+}
 
-    // Append the last character and its count
-    compressed += currentChar;
-    if (count > 1) {
-        compressed += '*';
-        compressed += std::to_string(count);
+/**
+ * @brief equi join between CastRelation::note and TitleRelation::title. The hash table is keyed by the compressed
+ * notes and probed with the compressed titles, equal strings always have equal codes.
+ */
+std::vector<ResultRelation> performEqualityJoin(const std::vector<CastRelation>& castRelation, const std::vector<TitleRelation>& titleRelation, int numThreads) {
+    const auto table = SymbolTable::build(sampleColumns(castRelation, &CastRelation::note, titleRelation, &TitleRelation::title));
+    std::vector<std::string> encodedNotes(castRelation.size());
+    #pragma omp parallel for num_threads(numThreads)
+    for(std::size_t i = 0; i < castRelation.size(); ++i) {
+        encodedNotes[i] = table.encode(columnView(castRelation[i].note));
+    }
+    std::unordered_map<std::string_view, std::vector<const CastRelation*>, std::hash<std::string_view>, StringEquals> map;
+    map.reserve(castRelation.size());
+    for(std::size_t i = 0; i < castRelation.size(); ++i) {
+        map[encodedNotes[i]].emplace_back(&castRelation[i]);
     }
 
-    return compressed;
+    std::vector<ResultRelation> results;
+    std::mutex m_results;
+    #pragma omp parallel num_threads(numThreads)
+    {
+        std::vector<std::pair<const CastRelation*, const TitleRelation*>> localResults;
+        #pragma omp for nowait
+        for(std::size_t i = 0; i < titleRelation.size(); ++i) {
+            const auto it = map.find(table.encode(columnView(titleRelation[i].title)));
+            if(it != map.end()) {
+                for(const auto& castTuple : it->second) {
+                    localResults.emplace_back(castTuple, &titleRelation[i]);
+                }
+            }
+        }
+        std::lock_guard l_results(m_results);
+        for(const auto& [castTuple, titleTuple] : localResults) {
+            results.emplace_back(createResultTuple(*castTuple, *titleTuple));
+        }
+    }
+    return results;
 }
 
+/**
+ * @brief prefix join between CastRelation::note and TitleRelation::title without an index, same result as performJoin.
+ *
+ * Both sides are sorted, so every note comes before all titles it is a prefix of. A merge scan keeps the notes that
+ * are prefixes of each other on a stack; before a title is joined, the stack is reduced to prefixes of that title.
+ * The sorted titles are split into one range per thread, each range starts with the notes that are proper prefixes of
+ * its first title, which are found by binary search.
+ */
+std::vector<ResultRelation> performSortJoin(const std::vector<CastRelation>& castRelation, const std::vector<TitleRelation>& titleRelation, int numThreads) {
+    std::vector<SortedString<CastRelation>> notes;
+    notes.reserve(castRelation.size());
+    for(const auto& castTuple : castRelation) {
+        // empty notes are not joined, as in the trie engines
+        if(const auto note = columnView(castTuple.note); !note.empty()) {
+            notes.push_back({note, &castTuple});
+        }
+    }
+    std::vector<SortedString<TitleRelation>> titles(titleRelation.size());
+    #pragma omp parallel for num_threads(numThreads)
+    for(std::size_t i = 0; i < titleRelation.size(); ++i) {
+        titles[i] = {columnView(titleRelation[i].title), &titleRelation[i]};
+    }
+    parallelStringSort(notes, numThreads);
+    parallelStringSort(titles, numThreads);
 
+    using NoteRange = std::pair<std::size_t, std::size_t>; // equal notes [first, second)
+    auto equalNotes = [&notes](std::string_view key) {
+        const auto range = std::equal_range(notes.begin(), notes.end(), SortedString<CastRelation>{key, nullptr},
+                                            [](const auto& left, const auto& right) {return compareStrings(left.key, right.key) < 0;});
+        return NoteRange(range.first - notes.begin(), range.second - notes.begin());
+    };
 
-std::vector<ResultRelation> performJoin(const std::vector<CastRelation>& castRelation, const std::vector<TitleRelation>& titleRelation, int numThreads) {
-    Trie<CastRelation> trie;
+    std::vector<std::vector<std::pair<const CastRelation*, const TitleRelation*>>> localResults(numThreads);
     std::vector<ResultRelation> results;
-    results.resize(castRelation.size());
-    #pragma omp parallel for num_threads(numThreads)
-    for(const auto& castTuple: castRelation) {
-        trie.insert(compressString(castTuple.note), &castTuple);
+    #pragma omp parallel num_threads(numThreads)
+    {
+        const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+        const auto team = static_cast<std::size_t>(omp_get_num_threads());
+        const auto begin = titles.size() * thread / team;
+        const auto end = titles.size() * (thread + 1) / team;
+        auto& matches = localResults[thread];
+        std::vector<NoteRange> activeNotes;
+        std::size_t nextNote = 0;
+        if(begin < end) {
+            const auto first = titles[begin].key;
+            for(std::size_t length = 1; length < first.size(); ++length) {
+                if(const auto range = equalNotes(first.substr(0, length)); range.first != range.second) {
+                    activeNotes.push_back(range);
+                }
+            }
+            nextNote = equalNotes(first).first;
+        }
+        for(std::size_t i = begin; i < end; ++i) {
+            const auto title = titles[i].key;
+            while(nextNote < notes.size() && compareStrings(notes[nextNote].key, title) <= 0) {
+                const auto note = notes[nextNote].key;
+                auto noteEnd = nextNote + 1;
+                while(noteEnd < notes.size() && stringEquals(notes[noteEnd].key, note)) {
+                    ++noteEnd;
+                }
+                while(!activeNotes.empty() && !startsWith(note, notes[activeNotes.back().first].key)) {
+                    activeNotes.pop_back();
+                }
+                activeNotes.emplace_back(nextNote, noteEnd);
+                nextNote = noteEnd;
+            }
+            while(!activeNotes.empty() && !startsWith(title, notes[activeNotes.back().first].key)) {
+                activeNotes.pop_back();
+            }
+            for(const auto& [noteBegin, noteEnd] : activeNotes) {
+                for(auto note = noteBegin; note < noteEnd; ++note) {
+                    matches.emplace_back(notes[note].record, titles[i].record);
+                }
+            }
+        }
+        materializeLocalResults(localResults, results);
     }
-    std::atomic_size_t resultIndex = 0;
-    // OMP for loop to search for longest prefix
-    #pragma omp parallel for num_threads(numThreads)
-    for(const auto& titleTuple: titleRelation) {
-        auto foundResults = trie.longestPrefix(compressString(titleTuple.title));
-        if(!foundResults.empty()) {
-            for(const auto& result : foundResults) {
-                results[resultIndex++] = createResultTuple(*result, titleTuple);
+    return results;
+}
+
+/**
+ * @brief similarity join between CastRelation::note and TitleRelation::title, see SimilarityPredicate
+ *
+ * Candidates are generated by prefix filtering over q-gram tokens: titles are indexed by the rarest tokens of their
+ * token set, and every note probes with its own rarest tokens. For edit distance k, one edit destroys at most q grams,
+ * so two strings within distance k share one of their first q * k + 1 tokens, unless both have at most q * k tokens.
+ * Such pairs of short strings are compared directly. For Jaccard, the prefix is |tokens| - ceil(threshold * |tokens|) + 1.
+ * Candidates that pass the length filter are verified with boundedEditDistance or the exact token overlap.
+ */
+std::vector<ResultRelation> performSimilarityJoin(const std::vector<CastRelation>& castRelation, const std::vector<TitleRelation>& titleRelation,
+                                                  const SimilarityPredicate& predicate, int numThreads) {
+    const bool editDistance = predicate.measure == SimilarityMeasure::EditDistance;
+    const std::size_t maxShortTokens = QGramTokenizer::Q * predicate.maxDistance;
+    auto prefixLength = [&](std::size_t numTokens) -> std::size_t {
+        if(editDistance) {
+            return std::min(numTokens, maxShortTokens + 1);
+        }
+        const auto required = static_cast<std::size_t>(std::ceil(predicate.threshold * static_cast<double>(numTokens)));
+        return std::min(numTokens, numTokens - std::min(required, numTokens) + 1);
+    };
+
+    std::vector<std::string_view> notes(castRelation.size());
+    std::vector<std::string_view> titles(titleRelation.size());
+    for(std::size_t i = 0; i < castRelation.size(); ++i) {
+        notes[i] = columnView(castRelation[i].note);
+    }
+    for(std::size_t i = 0; i < titleRelation.size(); ++i) {
+        titles[i] = columnView(titleRelation[i].title);
+    }
+    std::vector<std::string_view> allStrings(notes);
+    allStrings.insert(allStrings.end(), titles.begin(), titles.end());
+    const QGramTokenizer tokenizer(allStrings);
+
+    std::vector<std::vector<QGramToken>> noteTokens(notes.size());
+    std::vector<std::vector<QGramToken>> titleTokens(titles.size());
+    #pragma omp parallel num_threads(numThreads)
+    {
+        #pragma omp for schedule(static) nowait
+        for(std::size_t i = 0; i < notes.size(); ++i) {
+            tokenizer.tokenize(notes[i], noteTokens[i]);
+        }
+        #pragma omp for schedule(static)
+        for(std::size_t i = 0; i < titles.size(); ++i) {
+            tokenizer.tokenize(titles[i], titleTokens[i]);
+        }
+    }
+
+    // inverted index over the title prefixes: postings sorted by token, tokenRanges points into them
+    std::vector<std::pair<QGramToken, uint32_t>> postings;
+    std::vector<uint32_t> shortTitles;
+    for(uint32_t i = 0; i < titles.size(); ++i) {
+        const auto& tokens = titleTokens[i];
+        if(tokens.empty()) {
+            if(editDistance) {
+                shortTitles.push_back(i);
             }
+            continue;
+        }
+        for(std::size_t j = 0; j < prefixLength(tokens.size()); ++j) {
+            postings.emplace_back(tokens[j], i);
         }
+        if(editDistance && tokens.size() <= maxShortTokens) {
+            shortTitles.push_back(i);
+        }
+    }
+    std::sort(postings.begin(), postings.end());
+    std::unordered_map<QGramToken, std::pair<std::size_t, std::size_t>> tokenRanges;
+    for(std::size_t begin = 0; begin < postings.size();) {
+        auto end = begin;
+        while(end < postings.size() && postings[end].first == postings[begin].first) {
+            ++end;
+        }
+        tokenRanges.emplace(postings[begin].first, std::make_pair(begin, end));
+        begin = end;
+    }
+
+    std::vector<std::vector<std::pair<const CastRelation*, const TitleRelation*>>> localResults(numThreads);
+    std::vector<ResultRelation> results;
+    #pragma omp parallel num_threads(numThreads)
+    {
+        const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+        auto& matches = localResults[thread];
+        std::vector<uint32_t> lastSeen(titles.size(), 0); // note index + 1 that last produced the title as candidate
+        std::vector<uint32_t> candidates;
+        #pragma omp for schedule(dynamic, 64)
+        for(std::size_t i = 0; i < notes.size(); ++i) {
+            const auto note = notes[i];
+            const auto& tokens = noteTokens[i];
+            const auto stamp = static_cast<uint32_t>(i + 1);
+            candidates.clear();
+            auto addCandidate = [&](uint32_t title) {
+                if(lastSeen[title] == stamp) {
+                    return;
+                }
+                lastSeen[title] = stamp;
+                if(editDistance) {
+                    const auto difference = note.size() > titles[title].size() ? note.size() - titles[title].size() : titles[title].size() - note.size();
+                    if(difference <= predicate.maxDistance) {
+                        candidates.push_back(title);
+                    }
+                } else {
+                    const auto size = static_cast<double>(titleTokens[title].size());
+                    if(size >= predicate.threshold * static_cast<double>(tokens.size()) &&
+                       predicate.threshold * size <= static_cast<double>(tokens.size())) {
+                        candidates.push_back(title);
+                    }
+                }
+            };
+            if(!tokens.empty()) {
+                for(std::size_t j = 0; j < prefixLength(tokens.size()); ++j) {
+                    if(const auto it = tokenRanges.find(tokens[j]); it != tokenRanges.end()) {
+                        for(auto posting = it->second.first; posting < it->second.second; ++posting) {
+                            addCandidate(postings[posting].second);
+                        }
+                    }
+                }
+            }
+            if(editDistance && tokens.size() <= maxShortTokens) {
+                for(const auto title : shortTitles) {
+                    addCandidate(title);
+                }
+            }
+            for(const auto title : candidates) {
+                bool match;
+                if(editDistance) {
+                    match = boundedEditDistance(note, titles[title], predicate.maxDistance) <= predicate.maxDistance;
+                } else {
+                    const auto common = static_cast<double>(overlap(tokens, titleTokens[title]));
+                    match = common >= predicate.threshold * static_cast<double>(tokens.size() + titleTokens[title].size() - common);
+                }
+                if(match) {
+                    matches.emplace_back(&castRelation[i], &titleRelation[title]);
+                }
+            }
+        }
+        materializeLocalResults(localResults, results);
     }
-    results.resize(resultIndex);
     return results;
 }
 
@@ -90,7 +368,7 @@ TEST(StringTest, TestNestedLoopjoin) {
 
     for(const auto& l_record: leftRelation) {
         for(const auto& r_record: rightRelation) {
-            if(strncmp(l_record.note, r_record.title, 100) == 0) {
+            if(fixedStringEquals(l_record.note, r_record.title)) {
                 results.emplace_back(createResultTuple(l_record, r_record));
             }
         }
@@ -110,6 +388,30 @@ TEST(StringTest, TestTrieJoin) {
 }
 
 
+TEST(StringTest, TestSortJoin) {
+    const auto leftRelation = load<CastRelation>(DATA_DIRECTORY + std::string("cast_info_long_strings_200000.csv"));
+    const auto rightRelation = load<TitleRelation>(DATA_DIRECTORY + std::string("title_info_long_strings_200000.csv"));
+    Timer timer("Sort");
+    timer.start();
+    auto results = performSortJoin(leftRelation, rightRelation, 8);
+    timer.pause();
+    std::cout << "Join took: " << printString(timer) << std::endl;
+    std::cout << results.size() << std::endl;
+}
+
+TEST(StringTest, TestSimilarityJoin) {
+    const auto leftRelation = load<CastRelation>(DATA_DIRECTORY + std::string("cast_info_long_strings_200000.csv"));
+    const auto rightRelation = load<TitleRelation>(DATA_DIRECTORY + std::string("title_info_long_strings_200000.csv"));
+    SimilarityPredicate predicate;
+    predicate.maxDistance = 2;
+    Timer timer("Similarity");
+    timer.start();
+    auto results = performSimilarityJoin(leftRelation, rightRelation, predicate, 8);
+    timer.pause();
+    std::cout << "Join took: " << printString(timer) << std::endl;
+    std::cout << results.size() << std::endl;
+}
+
 
 TEST(StringTest, TestTrieJoinSingle) {
     const auto leftRelation = load<CastRelation>(DATA_DIRECTORY + std::string("cast_info_stolen_strings.csv"), 10);
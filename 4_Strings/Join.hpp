@@ -15,7 +15,12 @@
 #define JOIN_HPP
 
 #include "JoinUtils.hpp"
+#include "SimilarityJoin.h"
 
 std::vector<ResultRelation> performJoin(const std::vector<CastRelation>& leftRelation, const std::vector<TitleRelation>& rightRelation, int numThreads);
+std::vector<ResultRelation> performSortJoin(const std::vector<CastRelation>& leftRelation, const std::vector<TitleRelation>& rightRelation, int numThreads);
+std::vector<ResultRelation> performEqualityJoin(const std::vector<CastRelation>& leftRelation, const std::vector<TitleRelation>& rightRelation, int numThreads);
+std::vector<ResultRelation> performSimilarityJoin(const std::vector<CastRelation>& leftRelation, const std::vector<TitleRelation>& rightRelation,
+                                                  const SimilarityPredicate& predicate, int numThreads);
 
 #endif // JOIN_HPP
\ No newline at end of file
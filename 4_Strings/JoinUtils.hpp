@@ -19,7 +19,9 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <utility>
 #include <vector>
+#include <omp.h>
 
 //==--------------------------------------------------------------------==//
 //==------------------ RELATION & RELATION UTILITY----------------------==//
@@ -332,4 +334,31 @@ static constexpr size_t NUM_FIELD_CAST_RELATION = 7;
       return result;
     }
 
+/**
+ * @brief writes the matches every thread of the enclosing parallel region collected in localResults[thread] into
+ * results, which is sized exactly once; each thread fills its own range behind the matches of the threads before it,
+ * so no counter is shared. All threads of the region have to call it once they are done matching.
+ */
+inline void materializeLocalResults(const std::vector<std::vector<std::pair<const CastRelation*, const TitleRelation*>>>& localResults,
+                                    std::vector<ResultRelation>& results) {
+    #pragma omp barrier
+    #pragma omp single
+    {
+        std::size_t size = 0;
+        for(const auto& matches: localResults) {
+            size += matches.size();
+        }
+        results.resize(size);
+    } // implicit barrier, results is sized for every thread
+    const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+    std::size_t offset = 0;
+    for(std::size_t i = 0; i < thread; ++i) {
+        offset += localResults[i].size();
+    }
+    auto output = results.begin() + static_cast<std::ptrdiff_t>(offset);
+    for(const auto& [castTuple, titleTuple] : localResults[thread]) {
+        *output++ = createResultTuple(*castTuple, *titleTuple);
+    }
+}
+
 #endif //JOINUTIL_HPP
@@ -0,0 +1,97 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        https://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+ * Micro-benchmarks of Trie::insert and Trie::search on their own, over random lower case keys of different lengths.
+ * For every key length the number of keys is chosen so the trie sweeps working sets from L1 to DRAM
+ * (see MicroBenchmark.h):
+ *
+ *   ./4_Strings_MICROBENCHMARK --benchmark_filter='Trie::search/.*length:32' --benchmark_out=trie.json --benchmark_out_format=json
+ */
+
+#include "Trie.h"
+#include "MicroBenchmark.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// random keys share almost no prefixes, so every character is one node: its child map, data vector, two mutexes
+/// and the entry in the child map of its parent (a red black tree node of about 48 bytes)
+static constexpr const std::size_t TRIE_NODE_BYTES = sizeof(std::map<char, void*>) + sizeof(std::vector<const void*>) + 2 * sizeof(std::mutex) + 48;
+static constexpr const int64_t KEY_LENGTHS[] = {8, 16, 32, 64};
+
+static void benchmarkTrieInsert(benchmark::State& state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto length = static_cast<std::size_t>(state.range(1));
+    const auto keys = randomStrings(n, length);
+    for(auto _ : state) {
+        state.PauseTiming();
+        auto trie = std::make_unique<Trie<int>>();
+        state.ResumeTiming();
+        for(std::size_t i = 0; i < n; ++i) {
+            trie->insert(keys[i], nullptr);
+        }
+        state.PauseTiming(); // deleting the nodes is not part of the insert
+        trie.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * n * length));
+    setWorkingSet(state, n * length * TRIE_NODE_BYTES);
+}
+
+static void benchmarkTrieSearch(benchmark::State& state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    const auto length = static_cast<std::size_t>(state.range(1));
+    const auto keys = randomStrings(n, length);
+    const int value = 0;
+    Trie<int> trie;
+    for(const auto& key: keys) {
+        trie.insert(key, &value);
+    }
+    std::size_t found = 0;
+    for(auto _ : state) {
+        found = 0;
+        for(const auto& key: keys) {
+            found += trie.search(key).size();
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    if(found < n) {
+        state.SkipWithError("every key should have been found");
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * n * length));
+    setWorkingSet(state, n * length * TRIE_NODE_BYTES);
+}
+
+int main(int argc, char** argv) {
+    for(const auto length: KEY_LENGTHS) {
+        const auto nodeBytes = static_cast<std::size_t>(length) * TRIE_NODE_BYTES;
+        const auto keyCounts = workingSetElements(nodeBytes, nodeBytes + static_cast<std::size_t>(length) + sizeof(std::string), 1);
+        benchmark::RegisterBenchmark("Trie::insert", benchmarkTrieInsert)->ArgsProduct({keyCounts, {length}})->ArgNames({"keys", "length"})->Unit(benchmark::kMicrosecond);
+        benchmark::RegisterBenchmark("Trie::search", benchmarkTrieSearch)->ArgsProduct({keyCounts, {length}})->ArgNames({"keys", "length"})->Unit(benchmark::kMicrosecond);
+    }
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    addCacheContext();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
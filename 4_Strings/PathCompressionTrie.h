@@ -13,6 +13,8 @@
 #include <iostream>
 #include <memory>
 
+#include "StringKernels.h"
+
 template<typename T>
 class PathCompressionTrie {
 private:
@@ -72,11 +74,7 @@ public:
 
             // Find the longest common prefix between the edge label and the remaining key
             std::string_view edgeLabel = childNode->edgeLabel;
-            size_t matchLength = 0;
-            while (matchLength < edgeLabel.length() && depth + matchLength < key.length() &&
-                   edgeLabel[matchLength] == key[depth + matchLength]) {
-                matchLength++;
-            }
+            const size_t matchLength = commonPrefixLength(edgeLabel, key.substr(depth));
 
             if (matchLength == edgeLabel.length()) {
                 // Full match of the edge label, move to the next node
@@ -122,12 +120,7 @@ public:
 
             TrieNode* childNode = currentNode->children[currentChar].get();
             std::string_view edgeLabel = childNode->edgeLabel;
-            size_t matchLength = 0;
-
-            while (matchLength < edgeLabel.length() && depth + matchLength < key.length() &&
-                   edgeLabel[matchLength] == key[depth + matchLength]) {
-                matchLength++;
-            }
+            const size_t matchLength = commonPrefixLength(edgeLabel, key.substr(depth));
 
             if (matchLength != edgeLabel.length() || depth + matchLength > key.length()) {
                 return emptyVector;
@@ -157,12 +150,7 @@ public:
 
             TrieNode* childNode = currentNode->children[currentChar].get();
             std::string_view edgeLabel = childNode->edgeLabel;
-            size_t matchLength = 0;
-
-            while (matchLength < edgeLabel.length() && depth + matchLength < key.length() &&
-                   edgeLabel[matchLength] == key[depth + matchLength]) {
-                matchLength++;
-            }
+            const size_t matchLength = commonPrefixLength(edgeLabel, key.substr(depth));
 
             if (matchLength == 0) {
                 break;
@@ -14,6 +14,8 @@
 #include <unordered_map>
 #include <shared_mutex>
 
+#include "StringKernels.h"
+
 template<typename T>
 class RadixTrie {
 private:
@@ -46,7 +48,7 @@ private:
         }
 
         for (const auto& [childKey, childNode] : node->children) {
-            if (key.substr(depth, childKey.size()) == childKey) {
+            if (startsWith(key.substr(depth), childKey)) {
                 return longestPrefixRecursive(childNode, key, depth + childKey.size());
             }
         }
@@ -75,10 +77,7 @@ public:
             bool found = false;
 
             for (auto& [childKey, childNode] : currentNode->children) {
-                size_t matchLength = 0;
-                while (matchLength < childKey.length() && depth + matchLength < key.length() && childKey[matchLength] == key[depth + matchLength]) {
-                    ++matchLength;
-                }
+                const size_t matchLength = commonPrefixLength(childKey, key.substr(depth));
 
                 if (matchLength == childKey.length()) {
                     currentNode->nodeMutex.unlock();
@@ -127,7 +126,7 @@ public:
             bool found = false;
 
             for (const auto& [childKey, childNode] : currentNode->children) {
-                if (key.substr(depth, childKey.length()) == childKey) {
+                if (startsWith(key.substr(depth), childKey)) {
                     currentNode = childNode;
                     depth += childKey.length();
                     found = true;
@@ -0,0 +1,196 @@
+#ifndef PPDS_4_STRINGS_SIMILARITYJOIN_H
+#define PPDS_4_STRINGS_SIMILARITYJOIN_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+using QGramToken = uint64_t;
+
+enum class SimilarityMeasure {
+    EditDistance, ///< join if the Levenshtein distance is at most maxDistance
+    Jaccard       ///< join if the Jaccard similarity of the q-gram sets is at least threshold
+};
+
+struct SimilarityPredicate {
+    SimilarityMeasure measure = SimilarityMeasure::EditDistance;
+    uint32_t maxDistance = 2;
+    double threshold = 0.8;
+};
+
+/**
+ * @brief Levenshtein distance of left and right, computed with the bit-parallel algorithm of Myers in the block based
+ * form of Hyyrö, so left may be longer than 64 characters.
+ * @param maxDistance the computation stops early once the distance is known to exceed maxDistance
+ * @return the distance or maxDistance + 1 if it is larger than maxDistance
+ */
+inline uint32_t boundedEditDistance(std::string_view left, std::string_view right, const uint32_t maxDistance) {
+    if(left.size() < right.size()) {
+        std::swap(left, right);
+    }
+    if(left.size() - right.size() > maxDistance) {
+        return maxDistance + 1;
+    }
+    if(right.empty()) {
+        return static_cast<uint32_t>(left.size());
+    }
+    // right is the pattern, one bit per character, left is the text
+    using Word = uint64_t;
+    constexpr std::size_t WORD_SIZE = 64;
+    constexpr std::size_t MAX_BLOCKS = 4; // covers the 200 bytes of TitleRelation::title
+    const std::size_t length = right.size();
+    const std::size_t numBlocks = (length + WORD_SIZE - 1) / WORD_SIZE;
+    if(numBlocks > MAX_BLOCKS) {
+        // longer than every join column, fall back to the textbook dynamic program
+        std::vector<uint32_t> row(length + 1);
+        for(std::size_t i = 0; i <= length; ++i) {
+            row[i] = static_cast<uint32_t>(i);
+        }
+        for(std::size_t j = 1; j <= left.size(); ++j) {
+            uint32_t diagonal = row[0];
+            row[0] = static_cast<uint32_t>(j);
+            for(std::size_t i = 1; i <= length; ++i) {
+                const auto up = row[i];
+                row[i] = std::min({row[i] + 1, row[i - 1] + 1, diagonal + (left[j - 1] != right[i - 1])});
+                diagonal = up;
+            }
+        }
+        return std::min(row[length], maxDistance + 1);
+    }
+
+    std::array<std::array<Word, 256>, MAX_BLOCKS> peq{};
+    for(std::size_t i = 0; i < length; ++i) {
+        peq[i / WORD_SIZE][static_cast<uint8_t>(right[i])] |= Word{1} << (i % WORD_SIZE);
+    }
+    std::array<Word, MAX_BLOCKS> pv{};
+    std::array<Word, MAX_BLOCKS> mv{};
+    pv.fill(~Word{0});
+    const Word lastBit = Word{1} << ((length - 1) % WORD_SIZE);
+    constexpr Word HIGH_BIT = Word{1} << (WORD_SIZE - 1);
+    std::size_t score = length;
+
+    for(std::size_t j = 0; j < left.size(); ++j) {
+        const auto character = static_cast<uint8_t>(left[j]);
+        int carry = 1; // the first row of the global distance matrix grows by one per column
+        for(std::size_t block = 0; block < numBlocks; ++block) {
+            Word eq = peq[block][character];
+            const Word xv = eq | mv[block];
+            if(carry < 0) {
+                eq |= 1;
+            }
+            const Word xh = (((eq & pv[block]) + pv[block]) ^ pv[block]) | eq;
+            Word ph = mv[block] | ~(xh | pv[block]);
+            Word mh = pv[block] & xh;
+            const Word outBit = block + 1 == numBlocks ? lastBit : HIGH_BIT;
+            const int carryOut = (ph & outBit) ? 1 : (mh & outBit) ? -1 : 0;
+            ph <<= 1;
+            mh <<= 1;
+            if(carry < 0) {
+                mh |= 1;
+            } else if(carry > 0) {
+                ph |= 1;
+            }
+            pv[block] = mh | ~(xv | ph);
+            mv[block] = ph & xv;
+            carry = carryOut;
+        }
+        score = carry < 0 ? score - 1 : score + carry;
+        // the distance decreases by at most one per remaining column
+        if(score > maxDistance + (left.size() - j - 1)) {
+            return maxDistance + 1;
+        }
+    }
+    return static_cast<uint32_t>(std::min<std::size_t>(score, maxDistance + 1));
+}
+
+/**
+ * @brief q-gram tokens of a set of strings, ordered by ascending global frequency for prefix filtering
+ *
+ * A string of length L has L - q + 1 q-grams. Repeated grams are told apart by their occurrence count, so every token
+ * appears at most once per string and the q-gram multisets become sets. Tokens are numbered such that rare grams have
+ * small numbers, the sorted token list of a string starts with its most selective tokens. A token holds the rank of its
+ * gram in the upper and the occurrence in the lower 32 bits, so all 2^24 grams of three bytes get a token of their own.
+ */
+class QGramTokenizer {
+public:
+    static constexpr std::size_t Q = 3;
+
+    /**
+     * @brief counts the grams of all strings of both sides to fix the global token order
+     */
+    explicit QGramTokenizer(const std::vector<std::string_view>& strings) {
+        std::unordered_map<uint32_t, uint32_t> counts;
+        for(const auto& string : strings) {
+            for(std::size_t i = 0; i + Q <= string.size(); ++i) {
+                ++counts[gramOf(string, i)];
+            }
+        }
+        std::vector<std::pair<uint32_t, uint32_t>> byFrequency(counts.begin(), counts.end());
+        std::sort(byFrequency.begin(), byFrequency.end(), [](const auto& left, const auto& right) {
+            return std::tie(left.second, left.first) < std::tie(right.second, right.first);
+        });
+        ranks.reserve(byFrequency.size());
+        for(uint32_t rank = 0; rank < byFrequency.size(); ++rank) {
+            ranks[byFrequency[rank].first] = rank;
+        }
+    }
+
+    /**
+     * @brief sorted tokens of string, rarest first
+     */
+    void tokenize(std::string_view string, std::vector<QGramToken>& tokens) const {
+        tokens.clear();
+        for(std::size_t i = 0; i + Q <= string.size(); ++i) {
+            const auto it = ranks.find(gramOf(string, i));
+            // grams not seen while counting are rarer than every known gram
+            const QGramToken rank = it != ranks.end() ? QGramToken{it->second} + 1 : 0;
+            tokens.push_back(rank << OCCURRENCE_BITS);
+        }
+        std::sort(tokens.begin(), tokens.end());
+        for(std::size_t i = 1; i < tokens.size(); ++i) {
+            if((tokens[i] >> OCCURRENCE_BITS) == (tokens[i - 1] >> OCCURRENCE_BITS)) {
+                tokens[i] = tokens[i - 1] + 1;
+            }
+        }
+    }
+
+private:
+    static constexpr std::size_t OCCURRENCE_BITS = 32;
+
+    std::unordered_map<uint32_t, uint32_t> ranks;
+
+    static uint32_t gramOf(std::string_view string, std::size_t position) {
+        uint32_t gram = 0;
+        for(std::size_t i = 0; i < Q; ++i) {
+            gram = (gram << 8) | static_cast<uint8_t>(string[position + i]);
+        }
+        return gram;
+    }
+};
+
+/**
+ * @brief number of common elements of two sorted token lists
+ */
+inline std::size_t overlap(const std::vector<QGramToken>& left, const std::vector<QGramToken>& right) {
+    std::size_t common = 0;
+    auto l = left.begin();
+    auto r = right.begin();
+    while(l != left.end() && r != right.end()) {
+        if(*l < *r) {
+            ++l;
+        } else if(*r < *l) {
+            ++r;
+        } else {
+            ++common;
+            ++l;
+            ++r;
+        }
+    }
+    return common;
+}
+
+#endif //PPDS_4_STRINGS_SIMILARITYJOIN_H
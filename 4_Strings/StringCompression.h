@@ -0,0 +1,280 @@
+#ifndef PPDS_4_STRINGS_STRINGCOMPRESSION_H
+#define PPDS_4_STRINGS_STRINGCOMPRESSION_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "StringKernels.h"
+
+/**
+ * @brief Static symbol table in the spirit of FSST (Boncz et al., VLDB 2020).
+ * Up to 255 symbols of 1-8 bytes are mapped to one-byte codes, every other byte is written as ESCAPE followed by the
+ * literal byte. Encoding is a greedy longest match, which makes it deterministic: two strings are equal iff their
+ * codes are equal, so equality predicates can run on the codes directly.
+ */
+class SymbolTable {
+public:
+    static constexpr uint8_t ESCAPE = 255;
+    static constexpr std::size_t MAX_SYMBOLS = 255;
+    static constexpr std::size_t MAX_SYMBOL_LENGTH = 8;
+
+    /**
+     * @brief trains a symbol table on a sample of strings
+     * @param sample strings to train on, should be representative for both join columns
+     * @param rounds number of refinement rounds, FSST reports 5 to be sufficient
+     */
+    static SymbolTable build(const std::vector<std::string_view>& sample, const int rounds = 5) {
+        SymbolTable table;
+        for(int round = 0; round < rounds; ++round) {
+            table = table.refine(sample);
+        }
+        return table;
+    }
+
+    /**
+     * @brief compresses input into a string of codes
+     */
+    [[nodiscard]] std::string encode(std::string_view input) const {
+        std::string codes;
+        codes.reserve(input.size());
+        std::size_t position = 0;
+        while(position < input.size()) {
+            const auto code = longestMatch(input, position);
+            if(code == ESCAPE) {
+                codes.push_back(static_cast<char>(ESCAPE));
+                codes.push_back(input[position]);
+                position += 1;
+            } else {
+                codes.push_back(static_cast<char>(code));
+                position += lengths[code];
+            }
+        }
+        return codes;
+    }
+
+    /**
+     * @brief decompresses codes created by encode of the same table
+     */
+    [[nodiscard]] std::string decode(std::string_view codes) const {
+        std::string output;
+        output.reserve(codes.size() * 2);
+        for(std::size_t i = 0; i < codes.size(); ++i) {
+            const auto code = static_cast<uint8_t>(codes[i]);
+            if(code == ESCAPE) {
+                output.push_back(codes[++i]);
+            } else {
+                output.append(symbols[code].data(), lengths[code]);
+            }
+        }
+        return output;
+    }
+
+    /**
+     * @brief splits the encoding of a string into a part that every extension of the string encodes identically
+     * and a short raw tail.
+     *
+     * Greedy matching at position p only looks at the next MAX_SYMBOL_LENGTH bytes, so every code starting at least
+     * MAX_SYMBOL_LENGTH bytes before the end of input is also produced when encoding any string starting with input.
+     * The remaining tail is shorter than MAX_SYMBOL_LENGTH bytes.
+     * @param input uncompressed string
+     * @param stableCodes receives the stable code prefix
+     * @return number of input bytes covered by stableCodes, the tail is input.substr(return value)
+     */
+    std::size_t encodeStablePrefix(std::string_view input, std::string& stableCodes) const {
+        stableCodes.clear();
+        std::size_t position = 0;
+        while(position + MAX_SYMBOL_LENGTH <= input.size()) {
+            const auto code = longestMatch(input, position);
+            if(code == ESCAPE) {
+                stableCodes.push_back(static_cast<char>(ESCAPE));
+                stableCodes.push_back(input[position]);
+                position += 1;
+            } else {
+                stableCodes.push_back(static_cast<char>(code));
+                position += lengths[code];
+            }
+        }
+        return position;
+    }
+
+    /**
+     * @brief compares raw bytes against the string encoded in codes, starting at code offset codeIndex
+     * @return true if the decoded string continues with tail
+     */
+    [[nodiscard]] bool continuesWith(std::string_view codes, std::size_t codeIndex, std::string_view tail) const {
+        std::size_t matched = 0;
+        while(matched < tail.size()) {
+            if(codeIndex >= codes.size()) {
+                return false;
+            }
+            const auto code = static_cast<uint8_t>(codes[codeIndex]);
+            if(code == ESCAPE) {
+                if(codes[codeIndex + 1] != tail[matched]) {
+                    return false;
+                }
+                matched += 1;
+                codeIndex += 2;
+            } else {
+                const std::size_t length = std::min<std::size_t>(lengths[code], tail.size() - matched);
+                if(!startsWith(tail.substr(matched), std::string_view(symbols[code].data(), length))) {
+                    return false;
+                }
+                matched += length;
+                codeIndex += 1;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] std::size_t size() const { return numSymbols; }
+
+private:
+    std::array<std::array<char, MAX_SYMBOL_LENGTH>, MAX_SYMBOLS> symbols{};
+    std::array<uint8_t, MAX_SYMBOLS> lengths{};
+    std::size_t numSymbols = 0;
+    std::array<std::vector<uint8_t>, 256> byFirstByte; ///< codes per first byte, longest symbols first
+
+    /**
+     * @return code of the longest symbol matching input at position or ESCAPE if there is none
+     */
+    [[nodiscard]] uint8_t longestMatch(std::string_view input, std::size_t position) const {
+        const std::size_t remaining = input.size() - position;
+        for(const auto code: byFirstByte[static_cast<uint8_t>(input[position])]) {
+            if(lengths[code] <= remaining &&
+               std::memcmp(symbols[code].data(), input.data() + position, lengths[code]) == 0) {
+                return code;
+            }
+        }
+        return ESCAPE;
+    }
+
+    void addSymbol(std::string_view symbol) {
+        std::memcpy(symbols[numSymbols].data(), symbol.data(), symbol.size());
+        lengths[numSymbols] = static_cast<uint8_t>(symbol.size());
+        byFirstByte[static_cast<uint8_t>(symbol[0])].push_back(static_cast<uint8_t>(numSymbols));
+        ++numSymbols;
+    }
+
+    void finalize() {
+        for(auto& codes: byFirstByte) {
+            std::sort(codes.begin(), codes.end(), [this](uint8_t a, uint8_t b) {return lengths[a] > lengths[b];});
+        }
+    }
+
+    /**
+     * @brief one FSST training round: parse the sample with the current table, count how often every symbol and
+     * every pair of adjacent symbols occurs and keep the MAX_SYMBOLS candidates that save the most bytes.
+     * Bytes without a symbol take part as pseudo symbols 256 + byte.
+     */
+    [[nodiscard]] SymbolTable refine(const std::vector<std::string_view>& sample) const {
+        constexpr std::size_t CODE_SPACE = 512;
+        std::vector<uint32_t> singleCount(CODE_SPACE, 0);
+        std::vector<uint32_t> pairCount(CODE_SPACE * CODE_SPACE, 0);
+
+        for(const auto& string: sample) {
+            std::size_t position = 0;
+            uint16_t previous = UINT16_MAX;
+            while(position < string.size()) {
+                const auto code = longestMatch(string, position);
+                uint16_t current;
+                if(code == ESCAPE) {
+                    current = 256 + static_cast<uint8_t>(string[position]);
+                    position += 1;
+                } else {
+                    current = code;
+                    position += lengths[code];
+                }
+                ++singleCount[current];
+                if(previous != UINT16_MAX) {
+                    ++pairCount[previous * CODE_SPACE + current];
+                }
+                previous = current;
+            }
+        }
+
+        auto symbolOf = [this](uint16_t code) {
+            if(code >= 256) {
+                return std::string(1, static_cast<char>(code - 256));
+            }
+            return std::string(symbols[code].data(), lengths[code]);
+        };
+
+        // the same symbol can be produced by several pairs, so gains are summed up per symbol first
+        std::unordered_map<std::string, uint64_t> gains;
+        for(uint16_t first = 0; first < CODE_SPACE; ++first) {
+            if(singleCount[first] == 0) {
+                continue;
+            }
+            const auto firstSymbol = symbolOf(first);
+            // single bytes are boosted as FSST does, every byte without a symbol costs two bytes
+            const uint64_t boost = firstSymbol.size() == 1 ? 8 : 1;
+            gains[firstSymbol] += boost * singleCount[first] * firstSymbol.size();
+            if(firstSymbol.size() == MAX_SYMBOL_LENGTH) {
+                continue;
+            }
+            for(uint16_t second = 0; second < CODE_SPACE; ++second) {
+                const auto count = pairCount[first * CODE_SPACE + second];
+                if(count == 0) {
+                    continue;
+                }
+                auto combined = firstSymbol + symbolOf(second);
+                if(combined.size() > MAX_SYMBOL_LENGTH) {
+                    combined.resize(MAX_SYMBOL_LENGTH);
+                }
+                gains[combined] += static_cast<uint64_t>(count) * combined.size();
+            }
+        }
+
+        using Candidate = std::pair<uint64_t, std::string_view>; // gain, symbol
+        std::vector<Candidate> candidates;
+        candidates.reserve(gains.size());
+        for(const auto& [symbol, gain]: gains) {
+            candidates.emplace_back(gain, symbol);
+        }
+        const auto numCandidates = std::min(MAX_SYMBOLS, candidates.size());
+        std::partial_sort(candidates.begin(), candidates.begin() + numCandidates, candidates.end(), std::greater<>());
+
+        SymbolTable refined;
+        for(std::size_t i = 0; i < numCandidates; ++i) {
+            refined.addSymbol(candidates[i].second);
+        }
+        refined.finalize();
+        return refined;
+    }
+};
+
+/**
+ * @brief returns the used part of a fixed width char column, the columns are only zero terminated if they are not full
+ */
+template<std::size_t N>
+inline std::string_view columnView(const char (&column)[N]) {
+    return {column, strnlen(column, N)};
+}
+
+/**
+ * @brief collects up to maxSamples strings of both join columns to train a SymbolTable on
+ */
+template<typename LeftRelation, typename RightRelation, typename LeftColumn, typename RightColumn>
+std::vector<std::string_view> sampleColumns(const std::vector<LeftRelation>& left, LeftColumn leftColumn,
+                                            const std::vector<RightRelation>& right, RightColumn rightColumn,
+                                            const std::size_t maxSamples = 4096) {
+    std::vector<std::string_view> sample;
+    sample.reserve(2 * maxSamples);
+    const std::size_t leftStep = std::max<std::size_t>(1, left.size() / maxSamples);
+    const std::size_t rightStep = std::max<std::size_t>(1, right.size() / maxSamples);
+    for(std::size_t i = 0; i < left.size(); i += leftStep) {
+        sample.emplace_back(columnView(left[i].*leftColumn));
+    }
+    for(std::size_t i = 0; i < right.size(); i += rightStep) {
+        sample.emplace_back(columnView(right[i].*rightColumn));
+    }
+    return sample;
+}
+
+#endif //PPDS_4_STRINGS_STRINGCOMPRESSION_H
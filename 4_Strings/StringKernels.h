@@ -0,0 +1,155 @@
+#ifndef PPDS_4_STRINGS_STRINGKERNELS_H
+#define PPDS_4_STRINGS_STRINGKERNELS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__AVX2__) || defined(__SSE4_2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Comparison kernels for the string joins and tries.
+ * All kernels only read inside the given lengths, so they are safe on the fixed width char columns of CastRelation and
+ * TitleRelation, which are not zero terminated if they are full. The vector width is chosen at compile time: AVX2
+ * compare masks, SSE4.2 PCMPISTRI for zero terminated comparisons, SSE2 compare masks, and a scalar loop for the tail.
+ */
+namespace string_kernels {
+
+    /**
+     * @brief scalar reference of firstDifference
+     */
+    template<bool StopAtZero>
+    inline std::size_t firstDifferenceScalar(const char* left, const char* right, std::size_t position, const std::size_t length) {
+        for(; position < length; ++position) {
+            if(left[position] != right[position] || (StopAtZero && left[position] == '\0')) {
+                return position;
+            }
+        }
+        return length;
+    }
+
+    /**
+     * @brief first position in [0, length) at which left and right differ, or if StopAtZero is set, at which left
+     * ends. Returns length if there is none.
+     */
+    template<bool StopAtZero>
+    inline std::size_t firstDifference(const char* left, const char* right, const std::size_t length) {
+        std::size_t position = 0;
+#if defined(__AVX2__)
+        const __m256i zero256 = _mm256_setzero_si256();
+        for(; position + 32 <= length; position += 32) {
+            const __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + position));
+            const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + position));
+            auto mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(l, r)));
+            if constexpr (StopAtZero) {
+                mask |= static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(l, zero256)));
+            }
+            if(mask != 0) {
+                return position + static_cast<std::size_t>(__builtin_ctz(mask));
+            }
+        }
+#endif
+#if defined(__SSE4_2__)
+        if constexpr (StopAtZero) {
+            constexpr int MODE = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_EACH | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT;
+            for(; position + 16 <= length; position += 16) {
+                const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + position));
+                const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + position));
+                // reports the first mismatch before the end of both strings, equal terminators are not reported
+                const int index = _mm_cmpistri(l, r, MODE);
+                if(index < 16) {
+                    return position + static_cast<std::size_t>(index);
+                }
+                if(_mm_cmpistrs(l, r, MODE)) {
+                    const auto zeros = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(l, _mm_setzero_si128())));
+                    return position + static_cast<std::size_t>(__builtin_ctz(zeros));
+                }
+            }
+        }
+#endif
+#if defined(__SSE2__)
+        const __m128i zero128 = _mm_setzero_si128();
+        for(; position + 16 <= length; position += 16) {
+            const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + position));
+            const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + position));
+            auto mask = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(l, r))) & 0xFFFFu;
+            if constexpr (StopAtZero) {
+                mask |= static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(l, zero128)));
+            }
+            if(mask != 0) {
+                return position + static_cast<std::size_t>(__builtin_ctz(mask));
+            }
+        }
+#endif
+        return firstDifferenceScalar<StopAtZero>(left, right, position, length);
+    }
+}
+
+/**
+ * @brief length of the longest common prefix of left and right
+ */
+inline std::size_t commonPrefixLength(std::string_view left, std::string_view right) {
+    return string_kernels::firstDifference<false>(left.data(), right.data(), std::min(left.size(), right.size()));
+}
+
+/**
+ * @brief true if value starts with prefix
+ */
+inline bool startsWith(std::string_view value, std::string_view prefix) {
+    return prefix.size() <= value.size() &&
+           string_kernels::firstDifference<false>(value.data(), prefix.data(), prefix.size()) == prefix.size();
+}
+
+/**
+ * @brief same result as left == right
+ */
+inline bool stringEquals(std::string_view left, std::string_view right) {
+    return left.size() == right.size() && string_kernels::firstDifference<false>(left.data(), right.data(), left.size()) == left.size();
+}
+
+/**
+ * @brief negative, zero or positive like std::string_view::compare, bytes are compared unsigned
+ */
+inline int compareStrings(std::string_view left, std::string_view right) {
+    const auto length = std::min(left.size(), right.size());
+    const auto position = string_kernels::firstDifference<false>(left.data(), right.data(), length);
+    if(position < length) {
+        return static_cast<unsigned char>(left[position]) < static_cast<unsigned char>(right[position]) ? -1 : 1;
+    }
+    return left.size() < right.size() ? -1 : (left.size() > right.size() ? 1 : 0);
+}
+
+/**
+ * @brief key equality of the hash tables over string_views, with stringEquals
+ */
+struct StringEquals {
+    bool operator()(std::string_view left, std::string_view right) const { return stringEquals(left, right); }
+};
+
+/**
+ * @brief equality of two zero terminated fixed width columns, same result as strncmp(left, right, min(N, M)) == 0
+ */
+template<std::size_t N, std::size_t M>
+inline bool fixedStringEquals(const char (&left)[N], const char (&right)[M]) {
+    constexpr std::size_t length = std::min(N, M);
+    const auto position = string_kernels::firstDifference<true>(left, right, length);
+    return position == length || left[position] == right[position];
+}
+
+/**
+ * @brief true if the zero terminated fixed width column prefix is a prefix of value, an empty prefix always matches
+ */
+template<std::size_t N, std::size_t M>
+inline bool fixedStringStartsWith(const char (&value)[N], const char (&prefix)[M]) {
+    constexpr std::size_t length = std::min(N, M);
+    const auto position = string_kernels::firstDifference<true>(prefix, value, length);
+    if(position == length) {
+        return M <= N || prefix[length] == '\0';
+    }
+    return prefix[position] == '\0';
+}
+
+#endif //PPDS_4_STRINGS_STRINGKERNELS_H
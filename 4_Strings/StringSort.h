@@ -0,0 +1,122 @@
+#ifndef PPDS_4_STRINGS_STRINGSORT_H
+#define PPDS_4_STRINGS_STRINGSORT_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <omp.h>
+
+#include "StringKernels.h"
+
+/**
+ * @brief string key of a tuple, sorting moves only these 24 bytes instead of the tuples
+ */
+template<typename T>
+struct SortedString {
+    std::string_view key;
+    const T* record;
+};
+
+namespace string_sort {
+    constexpr std::size_t NUM_BUCKETS = 257; ///< bucket 0 holds strings ending at the current depth
+    constexpr std::size_t SMALL_SORT_THRESHOLD = 64;
+    constexpr std::size_t TASK_THRESHOLD = 1 << 12;
+
+    inline std::size_t bucketOf(std::string_view key, const std::size_t depth) {
+        return depth < key.size() ? static_cast<uint8_t>(key[depth]) + 1 : 0;
+    }
+
+    /**
+     * @brief sorts data by the bytes of key from depth on, all keys share their first depth bytes
+     */
+    template<typename T>
+    void msdRadixSort(SortedString<T>* data, SortedString<T>* buffer, const std::size_t size, const std::size_t depth) {
+        if(size < SMALL_SORT_THRESHOLD) {
+            std::sort(data, data + size, [depth](const SortedString<T>& left, const SortedString<T>& right) {
+                return compareStrings(left.key.substr(depth), right.key.substr(depth)) < 0;
+            });
+            return;
+        }
+        std::array<std::size_t, NUM_BUCKETS> offsets{};
+        for(std::size_t i = 0; i < size; ++i) {
+            ++offsets[bucketOf(data[i].key, depth)];
+        }
+        std::size_t sum = 0;
+        for(auto& offset : offsets) {
+            sum += std::exchange(offset, sum);
+        }
+        const auto begins = offsets;
+        for(std::size_t i = 0; i < size; ++i) {
+            buffer[offsets[bucketOf(data[i].key, depth)]++] = data[i];
+        }
+        std::copy(buffer, buffer + size, data);
+        // offsets now holds the bucket ends, bucket 0 is already sorted
+        for(std::size_t bucket = 1; bucket < NUM_BUCKETS; ++bucket) {
+            const auto begin = begins[bucket];
+            const auto bucketSize = offsets[bucket] - begin;
+            if(bucketSize < 2) {
+                continue;
+            }
+            #pragma omp task if(bucketSize > TASK_THRESHOLD) default(none) firstprivate(data, buffer, begin, bucketSize, depth)
+            msdRadixSort(data + begin, buffer + begin, bucketSize, depth + 1);
+        }
+        #pragma omp taskwait
+    }
+}
+
+/**
+ * @brief parallel MSD radix sort of strings, lexicographic by unsigned bytes like std::string_view::compare
+ *
+ * The first byte is distributed by all threads at once, each thread counts and scatters its own part of the input.
+ * The resulting buckets and all their sub buckets are sorted by OpenMP tasks.
+ */
+template<typename T>
+void parallelStringSort(std::vector<SortedString<T>>& strings, const int numThreads) {
+    using namespace string_sort;
+    std::vector<SortedString<T>> buffer(strings.size());
+    std::vector<std::array<std::size_t, NUM_BUCKETS>> threadOffsets(numThreads);
+    std::array<std::size_t, NUM_BUCKETS + 1> bucketBegins{};
+    #pragma omp parallel num_threads(numThreads)
+    {
+        const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+        auto& offsets = threadOffsets[thread];
+        #pragma omp for schedule(static)
+        for(std::size_t i = 0; i < strings.size(); ++i) {
+            ++offsets[bucketOf(strings[i].key, 0)];
+        }
+        #pragma omp single
+        {
+            std::size_t sum = 0;
+            for(std::size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+                bucketBegins[bucket] = sum;
+                for(auto& threadOffset : threadOffsets) {
+                    sum += std::exchange(threadOffset[bucket], sum);
+                }
+            }
+            bucketBegins[NUM_BUCKETS] = sum;
+        }
+        // same static schedule as above, so every thread scatters exactly the elements it counted
+        #pragma omp for schedule(static)
+        for(std::size_t i = 0; i < strings.size(); ++i) {
+            buffer[offsets[bucketOf(strings[i].key, 0)]++] = strings[i];
+        }
+        #pragma omp for schedule(static)
+        for(std::size_t i = 0; i < strings.size(); ++i) {
+            strings[i] = buffer[i];
+        }
+        #pragma omp single
+        for(std::size_t bucket = 1; bucket < NUM_BUCKETS; ++bucket) {
+            const auto begin = bucketBegins[bucket];
+            const auto bucketSize = bucketBegins[bucket + 1] - begin;
+            if(bucketSize > 1) {
+                #pragma omp task default(none) firstprivate(begin, bucketSize) shared(strings, buffer)
+                msdRadixSort(strings.data() + begin, buffer.data() + begin, bucketSize, 1);
+            }
+        }
+    }
+}
+
+#endif //PPDS_4_STRINGS_STRINGSORT_H
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <algorithm>
+#include <tuple>
+
+#include "SimilarityJoin.h"
+#include "StringCompression.h"
+#include "JoinUtils.hpp"
+#include "Join.hpp"
+
+class TestSimilarityJoin : public ::testing::Test {
+protected:
+    std::mt19937 generator{4711};
+    std::vector<CastRelation> castTuples;
+    std::vector<TitleRelation> titleTuples;
+
+    static uint32_t editDistance(std::string_view left, std::string_view right) {
+        std::vector<uint32_t> row(right.size() + 1);
+        for(std::size_t j = 0; j <= right.size(); ++j) {
+            row[j] = static_cast<uint32_t>(j);
+        }
+        for(std::size_t i = 1; i <= left.size(); ++i) {
+            uint32_t diagonal = row[0];
+            row[0] = static_cast<uint32_t>(i);
+            for(std::size_t j = 1; j <= right.size(); ++j) {
+                const auto up = row[j];
+                row[j] = std::min({row[j] + 1, row[j - 1] + 1, diagonal + (left[i - 1] != right[j - 1])});
+                diagonal = up;
+            }
+        }
+        return row[right.size()];
+    }
+
+    // applies up to maxEdits random substitutions, insertions and deletions
+    std::string mutate(std::string value, const uint32_t maxEdits, const std::size_t maxLength) {
+        const auto edits = generator() % (maxEdits + 1);
+        for(uint32_t i = 0; i < edits; ++i) {
+            const auto position = value.empty() ? 0 : generator() % value.size();
+            const auto character = static_cast<char>('a' + generator() % 4);
+            switch(generator() % 3) {
+                case 0: if(!value.empty()) value[position] = character; break;
+                case 1: value.insert(value.begin() + static_cast<std::ptrdiff_t>(position), character); break;
+                default: if(!value.empty()) value.erase(position, 1); break;
+            }
+        }
+        return value.substr(0, maxLength);
+    }
+
+    void SetUp() override {
+        const std::vector<std::string> titles = {
+                "Good  the Bad and the Ugly  The (Buono  il brutto  il cattivo  Il) (1966)",
+                "Good  the Bad and the Ugly  The",
+                "Return of Martin Guerre  The (Retour de Martin Guerre  Le) (1982)",
+                "Dr. Strangelove",
+                "Double Life of Veronique  The (Double Vie de V\xcc\xa9ronique  La) (1991)",
+                "Up",
+                "Heat",
+                "Once Upon a Time in the West (C'era una volta il West) (1968)",
+        };
+        for(int32_t i = 0; i < 800; ++i) {
+            TitleRelation title{};
+            title.titleId = i;
+            const auto value = mutate(titles[i % titles.size()], 4, sizeof(title.title) - 1);
+            std::memcpy(title.title, value.c_str(), value.size() + 1);
+            titleTuples.emplace_back(title);
+        }
+        for(int32_t i = 0; i < 300; ++i) {
+            CastRelation cast{};
+            cast.castInfoId = i;
+            const auto value = mutate(titles[generator() % titles.size()], 4, sizeof(cast.note) - 1);
+            std::memcpy(cast.note, value.c_str(), value.size() + 1);
+            castTuples.emplace_back(cast);
+        }
+    }
+
+    static std::vector<std::pair<int32_t, int32_t>> idPairs(const std::vector<ResultRelation>& results) {
+        std::vector<std::pair<int32_t, int32_t>> pairs;
+        for(const auto& result : results) {
+            pairs.emplace_back(result.castInfoId, result.titleId);
+        }
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    }
+};
+
+TEST_F(TestSimilarityJoin, TestBoundedEditDistance) {
+    for(int i = 0; i < 500; ++i) {
+        std::string left(generator() % 250, 'a');
+        for(auto& character : left) {
+            character = static_cast<char>('a' + generator() % 3);
+        }
+        const auto right = mutate(left, 6, 300);
+        const auto expected = editDistance(left, right);
+        for(const uint32_t maxDistance : {0u, 1u, 3u, 10u, 300u}) {
+            ASSERT_EQ(boundedEditDistance(left, right, maxDistance), std::min(expected, maxDistance + 1))
+                    << left << " " << right;
+        }
+    }
+}
+
+TEST_F(TestSimilarityJoin, TestEditDistanceJoin) {
+    constexpr uint32_t MAX_TESTED_DISTANCE = 3;
+    std::vector<std::tuple<uint32_t, const CastRelation*, const TitleRelation*>> distances;
+    for(const auto& castTuple : castTuples) {
+        for(const auto& titleTuple : titleTuples) {
+            const auto note = columnView(castTuple.note);
+            const auto title = columnView(titleTuple.title);
+            if(std::max(note.size(), title.size()) - std::min(note.size(), title.size()) <= MAX_TESTED_DISTANCE) {
+                distances.emplace_back(editDistance(note, title), &castTuple, &titleTuple);
+            }
+        }
+    }
+    for(uint32_t maxDistance = 0; maxDistance <= MAX_TESTED_DISTANCE; ++maxDistance) {
+        std::vector<ResultRelation> expected;
+        for(const auto& [distance, castTuple, titleTuple] : distances) {
+            if(distance <= maxDistance) {
+                expected.emplace_back(createResultTuple(*castTuple, *titleTuple));
+            }
+        }
+        SimilarityPredicate predicate;
+        predicate.maxDistance = maxDistance;
+        const auto results = performSimilarityJoin(castTuples, titleTuples, predicate, 4);
+        EXPECT_EQ(idPairs(results), idPairs(expected)) << maxDistance;
+    }
+}
+
+TEST_F(TestSimilarityJoin, TestJaccardJoin) {
+    std::vector<std::string_view> strings;
+    for(const auto& castTuple : castTuples) {
+        strings.emplace_back(columnView(castTuple.note));
+    }
+    for(const auto& titleTuple : titleTuples) {
+        strings.emplace_back(columnView(titleTuple.title));
+    }
+    const QGramTokenizer tokenizer(strings);
+    std::vector<std::vector<QGramToken>> noteTokens(castTuples.size());
+    std::vector<std::vector<QGramToken>> titleTokens(titleTuples.size());
+    for(std::size_t i = 0; i < castTuples.size(); ++i) {
+        tokenizer.tokenize(columnView(castTuples[i].note), noteTokens[i]);
+    }
+    for(std::size_t i = 0; i < titleTuples.size(); ++i) {
+        tokenizer.tokenize(columnView(titleTuples[i].title), titleTokens[i]);
+    }
+    for(const double threshold : {0.5, 0.8, 1.0}) {
+        std::vector<ResultRelation> expected;
+        for(std::size_t i = 0; i < castTuples.size(); ++i) {
+            for(std::size_t j = 0; j < titleTuples.size(); ++j) {
+                const auto common = static_cast<double>(overlap(noteTokens[i], titleTokens[j]));
+                const auto all = static_cast<double>(noteTokens[i].size() + titleTokens[j].size()) - common;
+                if(!noteTokens[i].empty() && !titleTokens[j].empty() && common >= threshold * all) {
+                    expected.emplace_back(createResultTuple(castTuples[i], titleTuples[j]));
+                }
+            }
+        }
+        SimilarityPredicate predicate;
+        predicate.measure = SimilarityMeasure::Jaccard;
+        predicate.threshold = threshold;
+        const auto results = performSimilarityJoin(castTuples, titleTuples, predicate, 4);
+        EXPECT_EQ(idPairs(results), idPairs(expected)) << threshold;
+    }
+}
+
+TEST_F(TestSimilarityJoin, TestQGramTokens) {
+    // more repetitions of one gram than a byte can count, each occurrence has to stay a token of its own
+    const std::string repeated(400, 'a');
+    const std::string rare = "xyz" + repeated;
+    const QGramTokenizer tokenizer({repeated, rare});
+    std::vector<QGramToken> tokens;
+    tokenizer.tokenize(repeated, tokens);
+    ASSERT_EQ(tokens.size(), repeated.size() - QGramTokenizer::Q + 1);
+    ASSERT_TRUE(std::is_sorted(tokens.begin(), tokens.end()));
+    std::vector<QGramToken> rareTokens;
+    tokenizer.tokenize(rare, rareTokens);
+    ASSERT_EQ(rareTokens.size(), rare.size() - QGramTokenizer::Q + 1);
+    ASSERT_LT(rareTokens.front(), tokens.front()); // "xyz" is rarer than "aaa" and comes first
+    ASSERT_EQ(overlap(tokens, rareTokens), tokens.size());
+}
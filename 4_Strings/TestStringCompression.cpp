@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <algorithm>
+
+#include "StringCompression.h"
+#include "JoinUtils.hpp"
+#include "Join.hpp"
+
+class TestStringCompression : public ::testing::Test {
+protected:
+    std::vector<CastRelation> castTuples;
+    std::vector<TitleRelation> titleTuples;
+
+    void SetUp() override {
+        const std::vector<std::string> titles = {
+                "Good  the Bad and the Ugly  The (Buono  il brutto  il cattivo  Il) (1966)",
+                "Good  the Bad and the Ugly  The (1966)",
+                "Return of Martin Guerre  The (Retour de Martin Guerre  Le) (1982)",
+                "Three Lives and Only One Death (Trois vies & une seule mort) (1996)",
+                "Halloween: The Curse of Michael Myers (Halloween 6: The Curse of Michael Myers) (1995)",
+                "Dr. Strangelove or: How I Learned to Stop Worrying and Love the Bomb (1964)",
+                "Double Life of Veronique  The (Double Vie de V\xcc\xa9ronique  La) (1991)",
+                "Once Upon a Time in the West (C'era una volta il West) (1968)",
+        };
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> letter('a', 'z');
+        for(int32_t i = 0; i < 500; ++i) {
+            TitleRelation title{};
+            title.titleId = i;
+            std::string value = titles[i % titles.size()];
+            if(i >= static_cast<int32_t>(titles.size())) {
+                value += " ";
+                for(int j = 0; j < i % 13; ++j) {
+                    value += static_cast<char>(letter(generator));
+                }
+            }
+            std::memcpy(title.title, value.c_str(), std::min(value.size() + 1, sizeof(title.title)));
+            titleTuples.emplace_back(title);
+        }
+        for(int32_t i = 0; i < 2000; ++i) {
+            CastRelation cast{};
+            cast.castInfoId = i;
+            const auto& title = titleTuples[generator() % titleTuples.size()];
+            const auto titleLength = strnlen(title.title, sizeof(title.title));
+            std::string value(title.title, 1 + generator() % std::min<std::size_t>(titleLength, sizeof(cast.note) - 1));
+            if(i % 5 == 0) {
+                value.back() = static_cast<char>(letter(generator));
+            }
+            std::memcpy(cast.note, value.c_str(), value.size() + 1);
+            castTuples.emplace_back(cast);
+        }
+    }
+
+    static std::vector<std::pair<int32_t, int32_t>> idPairs(const std::vector<ResultRelation>& results) {
+        std::vector<std::pair<int32_t, int32_t>> pairs;
+        for(const auto& result : results) {
+            pairs.emplace_back(result.castInfoId, result.titleId);
+        }
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    }
+};
+
+TEST_F(TestStringCompression, TestRoundTrip) {
+    const auto table = SymbolTable::build(sampleColumns(castTuples, &CastRelation::note, titleTuples, &TitleRelation::title));
+    std::size_t rawBytes = 0;
+    std::size_t compressedBytes = 0;
+    for(const auto& titleTuple : titleTuples) {
+        const auto title = columnView(titleTuple.title);
+        const auto codes = table.encode(title);
+        EXPECT_EQ(table.decode(codes), title);
+        rawBytes += title.size();
+        compressedBytes += codes.size();
+    }
+    EXPECT_LT(compressedBytes, rawBytes);
+    std::cout << "Compressed " << rawBytes << " bytes into " << compressedBytes << " bytes using " << table.size() << " symbols" << std::endl;
+}
+
+TEST_F(TestStringCompression, TestStablePrefix) {
+    const auto table = SymbolTable::build(sampleColumns(castTuples, &CastRelation::note, titleTuples, &TitleRelation::title));
+    std::string stableCodes;
+    for(const auto& titleTuple : titleTuples) {
+        const auto title = columnView(titleTuple.title);
+        const auto codes = table.encode(title);
+        for(std::size_t length = 0; length <= title.size(); ++length) {
+            const auto prefix = title.substr(0, length);
+            const auto covered = table.encodeStablePrefix(prefix, stableCodes);
+            ASSERT_LT(length - covered, SymbolTable::MAX_SYMBOL_LENGTH);
+            ASSERT_TRUE(std::string_view(codes).starts_with(stableCodes)) << prefix;
+            ASSERT_TRUE(table.continuesWith(codes, stableCodes.size(), prefix.substr(covered))) << prefix;
+        }
+    }
+}
+
+TEST_F(TestStringCompression, TestPrefixJoin) {
+    std::vector<ResultRelation> expected;
+    for(const auto& castTuple : castTuples) {
+        for(const auto& titleTuple : titleTuples) {
+            if(columnView(titleTuple.title).starts_with(columnView(castTuple.note))) {
+                expected.emplace_back(createResultTuple(castTuple, titleTuple));
+            }
+        }
+    }
+    const auto results = performJoin(castTuples, titleTuples, 4);
+    EXPECT_EQ(idPairs(results), idPairs(expected));
+}
+
+TEST_F(TestStringCompression, TestPrefixJoinDuplicateNotes) {
+    // every title matches all notes, far more results than cast tuples
+    std::vector<CastRelation> duplicates(castTuples.begin(), castTuples.begin() + 100);
+    for(auto& castTuple : duplicates) {
+        std::memcpy(castTuple.note, "Good", 5);
+    }
+    const auto results = performJoin(duplicates, titleTuples, 8);
+    std::size_t matchingTitles = 0;
+    for(const auto& titleTuple : titleTuples) {
+        matchingTitles += columnView(titleTuple.title).starts_with("Good");
+    }
+    EXPECT_EQ(results.size(), duplicates.size() * matchingTitles);
+}
+
+TEST_F(TestStringCompression, TestEqualityJoin) {
+    std::vector<ResultRelation> expected;
+    for(const auto& castTuple : castTuples) {
+        for(const auto& titleTuple : titleTuples) {
+            if(strncmp(castTuple.note, titleTuple.title, 100) == 0) {
+                expected.emplace_back(createResultTuple(castTuple, titleTuple));
+            }
+        }
+    }
+    const auto results = performEqualityJoin(castTuples, titleTuples, 4);
+    EXPECT_EQ(idPairs(results), idPairs(expected));
+}
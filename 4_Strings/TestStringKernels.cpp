@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <cstring>
+
+#include "StringKernels.h"
+
+class TestStringKernels : public ::testing::Test {
+protected:
+    std::mt19937 generator{7};
+
+    // fills column with a random string over a small alphabet, so that long common prefixes are likely
+    template<std::size_t N>
+    void randomColumn(char (&column)[N], const char (&base)[N]) {
+        std::memcpy(column, base, N);
+        const auto change = generator() % (N + 1);
+        if(change < N) {
+            column[change] = static_cast<char>('a' + generator() % 3);
+            if(generator() % 4 == 0) {
+                std::memset(column + change, 0, N - change);
+            }
+        }
+    }
+
+    template<std::size_t N>
+    void fillBase(char (&column)[N], const bool full) {
+        const auto length = full ? N : generator() % N;
+        for(std::size_t i = 0; i < length; ++i) {
+            column[i] = static_cast<char>('a' + generator() % 3);
+        }
+        std::memset(column + length, 0, N - length);
+    }
+};
+
+TEST_F(TestStringKernels, TestCommonPrefixLength) {
+    for(int i = 0; i < 10000; ++i) {
+        std::string left(generator() % 100, 'a');
+        for(auto& character : left) {
+            character = static_cast<char>('a' + generator() % 2);
+        }
+        std::string right = left.substr(0, generator() % (left.size() + 1)) + std::string(generator() % 50, 'y');
+        std::size_t expected = 0;
+        while(expected < left.size() && expected < right.size() && left[expected] == right[expected]) {
+            ++expected;
+        }
+        ASSERT_EQ(commonPrefixLength(left, right), expected);
+        ASSERT_EQ(startsWith(left, right), std::string_view(left).starts_with(right));
+    }
+}
+
+TEST_F(TestStringKernels, TestStringEqualsAndCompare) {
+    for(int i = 0; i < 10000; ++i) {
+        std::string left(generator() % 80, 'a');
+        for(auto& character : left) {
+            character = static_cast<char>('a' + generator() % 2);
+        }
+        std::string right = left.substr(0, generator() % (left.size() + 1));
+        const auto suffix = generator() % 3;
+        right += suffix == 0 ? "" : (suffix == 1 ? "b" : "\xe9"); // a byte above 127 has to sort after ascii
+        const auto sign = [](const int value) {return (value > 0) - (value < 0);};
+        ASSERT_EQ(stringEquals(left, right), left == right);
+        ASSERT_EQ(sign(compareStrings(left, right)), sign(std::string_view(left).compare(right))) << left << " " << right;
+        ASSERT_EQ(sign(compareStrings(right, left)), sign(std::string_view(right).compare(left))) << left << " " << right;
+    }
+}
+
+TEST_F(TestStringKernels, TestFixedStringEquals) {
+    for(int i = 0; i < 10000; ++i) {
+        char base[100];
+        char note[100];
+        char title[200] = {};
+        fillBase(base, i % 10 == 0);
+        randomColumn(note, base);
+        std::memcpy(title, base, sizeof(base));
+        if(i % 3 == 0) {
+            title[generator() % sizeof(title)] = 'c';
+        }
+        ASSERT_EQ(fixedStringEquals(note, title), strncmp(note, title, 100) == 0);
+        ASSERT_EQ(fixedStringEquals(title, note), strncmp(title, note, 100) == 0);
+    }
+}
+
+TEST_F(TestStringKernels, TestFixedStringStartsWith) {
+    for(int i = 0; i < 10000; ++i) {
+        char base[100];
+        char note[100];
+        char title[200] = {};
+        fillBase(base, i % 10 == 0);
+        std::memcpy(title, base, sizeof(base));
+        title[100 + generator() % 100] = 'b';
+        randomColumn(note, base);
+        const auto noteView = std::string_view(note, strnlen(note, sizeof(note)));
+        const auto titleView = std::string_view(title, strnlen(title, sizeof(title)));
+        ASSERT_EQ(fixedStringStartsWith(title, note), titleView.starts_with(noteView)) << noteView << " " << titleView;
+    }
+}
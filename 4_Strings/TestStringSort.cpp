@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <algorithm>
+
+#include "StringSort.h"
+#include "StringCompression.h"
+#include "JoinUtils.hpp"
+#include "Join.hpp"
+
+class TestStringSort : public ::testing::Test {
+protected:
+    std::mt19937 generator{1337};
+
+    // strings over a two letter alphabet, so there are many shared prefixes and duplicates
+    std::string randomString(const std::size_t maxLength) {
+        std::string value(generator() % (maxLength + 1), 'a');
+        for(auto& character : value) {
+            character = static_cast<char>('a' + generator() % 2);
+        }
+        return value;
+    }
+
+    static std::vector<std::pair<int32_t, int32_t>> idPairs(const std::vector<ResultRelation>& results) {
+        std::vector<std::pair<int32_t, int32_t>> pairs;
+        for(const auto& result : results) {
+            pairs.emplace_back(result.castInfoId, result.titleId);
+        }
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    }
+};
+
+TEST_F(TestStringSort, TestParallelStringSort) {
+    std::vector<std::string> values;
+    for(int i = 0; i < 100000; ++i) {
+        values.emplace_back(randomString(40));
+    }
+    values.emplace_back("\xff\x80");
+    values.emplace_back("\x01");
+    std::vector<SortedString<std::string>> strings;
+    for(const auto& value : values) {
+        strings.push_back({value, &value});
+    }
+    parallelStringSort(strings, 8);
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(strings.size(), expected.size());
+    for(std::size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(strings[i].key, expected[i]);
+        ASSERT_EQ(*strings[i].record, expected[i]);
+    }
+}
+
+TEST_F(TestStringSort, TestSortJoin) {
+    std::vector<TitleRelation> titleTuples(2000);
+    for(std::size_t i = 0; i < titleTuples.size(); ++i) {
+        titleTuples[i].titleId = static_cast<int32_t>(i);
+        const auto value = randomString(20);
+        std::memcpy(titleTuples[i].title, value.c_str(), value.size() + 1);
+    }
+    std::vector<CastRelation> castTuples(500);
+    for(std::size_t i = 0; i < castTuples.size(); ++i) {
+        castTuples[i].castInfoId = static_cast<int32_t>(i);
+        const auto value = randomString(12);
+        std::memcpy(castTuples[i].note, value.c_str(), value.size() + 1);
+    }
+    std::vector<ResultRelation> expected;
+    for(const auto& castTuple : castTuples) {
+        for(const auto& titleTuple : titleTuples) {
+            const auto note = columnView(castTuple.note);
+            if(!note.empty() && columnView(titleTuple.title).starts_with(note)) {
+                expected.emplace_back(createResultTuple(castTuple, titleTuple));
+            }
+        }
+    }
+    const auto expectedPairs = idPairs(expected);
+    for(const int numThreads : {1, 3, 8}) {
+        EXPECT_EQ(idPairs(performSortJoin(castTuples, titleTuples, numThreads)), expectedPairs) << numThreads;
+    }
+    EXPECT_EQ(idPairs(performJoin(castTuples, titleTuples, 8)), expectedPairs);
+}
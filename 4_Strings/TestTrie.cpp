@@ -8,13 +8,23 @@
 #include "Trie.h"
 #include "JoinUtils.hpp"
 #include "TimerUtil.hpp"
+#include "DataGenerator.h"
 
 class TestTrie : public ::testing::Test {
 protected:
-    const std::vector<CastRelation> castTuples = loadCastRelation(DATA_DIRECTORY + std::string("cast_info_short_strings_20000.csv"));;
-    const std::vector<TitleRelation> titleTuples = loadTitleRelation(DATA_DIRECTORY + std::string("title_info_short_strings_20000.csv"));;
+    static GeneratedRelations<CastRelation, TitleRelation> shortStrings(const std::size_t numTuples) {
+        RelationSpec spec;
+        spec.numCasts = numTuples;
+        spec.numTitles = numTuples;
+        spec.stringLength = 20;
+        return generateRelations<CastRelation, TitleRelation>(spec);
+    }
+
+    const GeneratedRelations<CastRelation, TitleRelation> generated = shortStrings(20000);
+    const std::vector<CastRelation>& castTuples = generated.cast;
+    const std::vector<TitleRelation>& titleTuples = generated.title;
     const std::vector<CastRelation> stolenCastTuples = loadCastRelation(DATA_DIRECTORY + std::string("cast_info_stolen_strings.csv"), 100);;
-    const std::vector<TitleRelation> thirtyTitleTuples = loadTitleRelation(DATA_DIRECTORY + std::string("title_info_short_strings_30.csv"));;
+    const std::vector<TitleRelation> thirtyTitleTuples = shortStrings(30).title;
     void SetUp() override {
         // Code here will be called immediately after the constructor (right before each test).
     }
@@ -136,6 +136,22 @@ public:
     inline const std::vector<const T*>& longestPrefix(std::string_view key) {
         return longestPrefixRecursive(root, key, 0);
     }
+
+    // Calls visitor(dataVector, depth) for every node with data on the path of key, shortest prefixes first
+    template<typename Visitor>
+    inline void forEachPrefix(std::string_view key, Visitor&& visitor) {
+        TrieNode* currentNode = root;
+        for (size_t depth = 0; depth < key.length(); ++depth) {
+            auto it = currentNode->children.find(key[depth]);
+            if (it == currentNode->children.end()) {
+                return;
+            }
+            currentNode = it->second;
+            if (!currentNode->dataVector.empty()) {
+                visitor(currentNode->dataVector, depth + 1);
+            }
+        }
+    }
 };
 
 #endif // PPDS_PARALLELISM_TRIE_H
@@ -28,13 +28,15 @@ default_output_size=1048576
 #default_output_size=$one_gebi_byte
 fldr_name="data"
 
+# ppds_datagen is the native generator of Util/include/DataGenerator.h, it takes the arguments of the python generators
+cmake -S native -B native/build -DCMAKE_BUILD_TYPE=Release > /dev/null && cmake --build native/build --target ppds_datagen > /dev/null || exit 1
+datagen="native/build/ppds_datagen"
+
 echo "Creating the data files now..."
-cd generator_code
 # We require only one file for the title table, as we purely change cast_info
-parallel python3 -m main --generator_type=Title --key_field_name="id" --output_file_size="$default_output_size" --output_file="../$fldr_name"/"title_info_uniform1mb.csv"
+parallel "$datagen" --generator_type=Title --output_file_size="$default_output_size" --output_file="$fldr_name"/"title_info_uniform1mb.csv"
 
 # Files for Throughput over Threads figure
-parallel python3 -m main --generator_type=Uniform --output_file_size="$default_output_size" --output_file="../$fldr_name"/"cast_info_uniform1mb.csv"
-cd ..
+parallel "$datagen" --generator_type=Uniform --output_file_size="$default_output_size" --output_file="$fldr_name"/"cast_info_uniform1mb.csv"
 
 wait
\ No newline at end of file
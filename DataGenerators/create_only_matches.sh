@@ -39,13 +39,15 @@ fldr_name="data"
 echo "Deleting all data in $fldr_name..."
 rm -rf $fldr_name/*_matching.csv
 
+# ppds_datagen is the native generator of Util/include/DataGenerator.h, it takes the arguments of the python generators
+cmake -S native -B native/build -DCMAKE_BUILD_TYPE=Release > /dev/null && cmake --build native/build --target ppds_datagen > /dev/null || exit 1
+datagen="native/build/ppds_datagen"
+
 echo "Creating the data files now..."
-cd generator_code
 # We require only one file for the title table, as we purely change cast_info
-parallel python3 -m main --generator_type=Title --key_field_name="id" --output_file_size="$default_output_size" --output_file="../$fldr_name"/"title_info_matching.csv" --num_records=8659209
+parallel "$datagen" --generator_type=Title --output_file_size="$default_output_size" --output_file="$fldr_name"/"title_info_matching.csv" --num_records=8659209
 
 # Files for Throughput over Threads figure
-parallel python3 -m main --generator_type=MatchRate --output_file_size="$default_output_size" --output_file="../$fldr_name"/"cast_info_matching.csv" --match_rate=0.0 --max_value=8659209 --num_records=8659209
-cd ..
+parallel "$datagen" --generator_type=MatchRate --output_file_size="$default_output_size" --output_file="$fldr_name"/"cast_info_matching.csv" --match_rate=0.0 --max_value=8659209 --num_records=8659209
 
 wait
\ No newline at end of file
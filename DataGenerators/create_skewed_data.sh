@@ -35,14 +35,16 @@ default_output_size=$one_mebi_byte
 #default_output_size=$one_hundret_mebi_byte
 fldr_name="data"
 
+# ppds_datagen is the native generator of Util/include/DataGenerator.h, it takes the arguments of the python generators
+cmake -S native -B native/build -DCMAKE_BUILD_TYPE=Release > /dev/null && cmake --build native/build --target ppds_datagen > /dev/null || exit 1
+datagen="native/build/ppds_datagen"
+
 echo "Creating the data files now..."
-cd generator_code
 # We require only one file for the title table, as we purely change cast_info
-#parallel python3 -m main --generator_type=Title --key_field_name="id" --output_file_size="$default_output_size" --output_file="../$fldr_name"/"title_info_uniform1mb.csv"
+#parallel "$datagen" --generator_type=Title --output_file_size="$default_output_size" --output_file="$fldr_name"/"title_info_uniform1mb.csv"
 
 # Files for Throughput over Threads figure
-parallel python3 -m main --generator_type=Zipfian --output_file_size="$default_output_size" --output_file="../$fldr_name"/"cast_info_zipfian1mTest.csv"
+parallel "$datagen" --generator_type=Zipfian --output_file_size="$default_output_size" --output_file="$fldr_name"/"cast_info_zipfian1mTest.csv"
 
-cd ..
 
 wait
\ No newline at end of file
@@ -0,0 +1,128 @@
+/*
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        https://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+ * Command line front end of DataGenerator.h, taking the arguments of generator_code/main.py and
+ * StringDataGenerator/generateStringData.py:
+ *
+ *   ./ppds_datagen --generator_type=Zipfian --output_file_size=1073741824 --output_file=../data/cast_info_zipfian.csv
+ *   ./ppds_datagen --generator_type=Title --num_records=8659209 --format=binary --output_file=../data/title_info.bin
+ *
+ * StringCast and StringTitle replace generateStringData.py --generator_type=Cast/Title.
+ */
+
+#include "JoinUtils.hpp"
+#include "DataGenerator.h"
+
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " --generator_type=<Uniform|Zipfian|MatchRate|Sorted|Title|StringCast|StringTitle>"
+              << " --output_file=<path> (--output_file_size=<bytes> | --num_records=<n>)\n"
+              << "    [--min_value=1] [--max_value=1001] [--match_rate=<fraction in [0, 1]>] [--zipf_alpha=2.0]\n"
+              << "    [--format=<csv|binary>] [--seed=42] [--threads=<hardware concurrency>]\n";
+}
+
+template<typename T>
+static bool parseNumber(const std::string_view text, T& value) {
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() && end == text.data() + text.size();
+}
+
+int main(int argc, char** argv) {
+    std::map<std::string, std::string> arguments;
+    for(int i = 1; i < argc; ++i) {
+        const std::string_view argument(argv[i]);
+        const auto separator = argument.find('=');
+        if(!argument.starts_with("--") || separator == std::string_view::npos) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        arguments.emplace(std::string(argument.substr(2, separator - 2)), std::string(argument.substr(separator + 1)));
+    }
+    const auto type = arguments["generator_type"];
+    const auto outputFile = arguments["output_file"];
+    if(type.empty() || outputFile.empty() || (!arguments.contains("output_file_size") && !arguments.contains("num_records"))) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    GeneratorOptions options;
+    std::size_t outputFileSize = 0;
+    bool valid = true;
+    for(const auto& [name, value]: arguments) {
+        if(name == "min_value") valid &= parseNumber(value, options.minValue);
+        else if(name == "max_value") valid &= parseNumber(value, options.maxValue);
+        else if(name == "match_rate") valid &= parseNumber(value, options.matchRate);
+        else if(name == "zipf_alpha") valid &= parseNumber(value, options.zipfAlpha);
+        else if(name == "num_records") valid &= parseNumber(value, options.numRecords);
+        else if(name == "output_file_size") valid &= parseNumber(value, outputFileSize);
+        else if(name == "seed") valid &= parseNumber(value, options.seed);
+        else if(name == "threads") valid &= parseNumber(value, options.numThreads) && options.numThreads > 0;
+        else if(name == "format") valid &= value == "csv" || value == "binary";
+        else if(name != "generator_type" && name != "output_file") valid = false;
+        if(!valid) {
+            std::cerr << "Error: Invalid argument --" << name << "=" << value << std::endl;
+            return 1;
+        }
+    }
+    if(!(options.matchRate >= 0 && options.matchRate <= 1)) { // a fraction, as MatchRateCastInfoGenerator.py uses it
+        std::cerr << "Error: --match_rate must be a fraction in [0, 1], got " << arguments["match_rate"] << std::endl;
+        return 1;
+    }
+    const auto format = arguments["format"] == "binary" ? OutputFormat::BINARY : OutputFormat::CSV;
+
+    bool title = false;
+    if(type == "Uniform") options.distribution = KeyDistribution::UNIFORM;
+    else if(type == "Zipfian") options.distribution = KeyDistribution::ZIPFIAN;
+    else if(type == "MatchRate") options.distribution = KeyDistribution::MATCH_RATE;
+    else if(type == "Sorted") options.distribution = KeyDistribution::SORTED;
+    else if(type == "Title" || type == "StringTitle") title = true;
+    else if(type == "StringCast") options.distribution = KeyDistribution::SEQUENTIAL;
+    else {
+        std::cerr << "Error: Invalid generator type " << type << std::endl;
+        return 1;
+    }
+    if(title) {
+        options.distribution = KeyDistribution::SEQUENTIAL;
+    }
+    options.stringKeys = type.starts_with("String");
+    // like main.py, Title is sized by --output_file_size alone and only falls back to --num_records without it
+    const bool ignoreNumRecords = type == "Title" && arguments.contains("output_file_size");
+    if(ignoreNumRecords && arguments.contains("num_records")) {
+        std::cout << "Ignoring --num_records for Title, its size follows --output_file_size" << std::endl;
+    }
+    if(ignoreNumRecords || !arguments.contains("num_records")) {
+        options.numRecords = recordsForFileSize(outputFileSize, title ? TITLE_CSV_ROW_SIZE : CAST_CSV_ROW_SIZE);
+    }
+
+    std::cout << "Generating " << options.numRecords << " records for " << type << " and saving to " << outputFile << "..." << std::endl;
+    const auto start = std::chrono::steady_clock::now();
+    const bool written = title ? writeRelation<TitleRelation>(outputFile, options, format)
+                               : writeRelation<CastRelation>(outputFile, options, format);
+    if(!written) {
+        std::cerr << "Error: Could not generate data for " << type << " and output file " << outputFile << std::endl;
+        return 1;
+    }
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Data generated in " << seconds << " s (" << static_cast<double>(options.numRecords) / seconds / 1e6
+              << " M records/s)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,449 @@
+#ifndef PPDS_UTIL_DATAGENERATOR_H
+#define PPDS_UTIL_DATAGENERATOR_H
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#include <omp.h>
+
+/**
+ * Native counterpart of DataGenerators/generator_code and DataGenerators/StringDataGenerator. Relations are generated
+ * in chunks of GENERATOR_CHUNK_SIZE rows, every chunk with its own PRNG stream seeded by (seed, chunk index), so the
+ * same options give the same relation for any number of threads and whether it is generated in memory or written to
+ * a file. Record types are template parameters and only need the fields of CastRelation or TitleRelation of the stages.
+ */
+
+static constexpr const std::size_t GENERATOR_CHUNK_SIZE = 1 << 14; ///< rows per PRNG stream
+static constexpr const std::size_t CAST_CSV_ROW_SIZE = 124; ///< bytes per cast_info row the python generators assume
+static constexpr const std::size_t TITLE_CSV_ROW_SIZE = 322; ///< bytes per title row the python generators assume
+static constexpr const int32_t MISS_KEY_OFFSET = 1000; ///< MATCH_RATE misses get maxValue + MISS_KEY_OFFSET
+
+/**
+ * @brief distribution of the key field, movieId of cast records and titleId of title records
+ */
+enum class KeyDistribution : uint8_t {
+    UNIFORM = 0, ///< uniform in [minValue, maxValue)
+    ZIPFIAN = 1, ///< p(k) ~ 1 / k^zipfAlpha for k in [minValue, maxValue)
+    MATCH_RATE = 2, ///< uniform, but only matchRate of the keys are below maxValue
+    SORTED = 3, ///< uniform keys in ascending order
+    SEQUENTIAL = 4, ///< 1, 2, ... with every key repeated duplicatesPerKey times, the key of a title relation
+};
+
+enum class OutputFormat : uint8_t {
+    CSV = 0, ///< with header, readable by load<Relation>() of the stages
+    BINARY = 1, ///< RelationFileHeader followed by the raw records, readable by loadBinary<Relation>()
+};
+
+struct GeneratorOptions {
+    std::size_t numRecords = 0;
+    KeyDistribution distribution = KeyDistribution::UNIFORM;
+    int32_t minValue = 1; ///< also bounds all other integer fields
+    int32_t maxValue = 1001;
+    double matchRate = 1.0; ///< fraction of keys below maxValue, the others miss every title
+    double zipfAlpha = 2.0; ///< skew theta of ZIPFIAN
+    std::size_t duplicatesPerKey = 1; ///< SEQUENTIAL only
+    std::size_t stringLength = 0; ///< characters of note and title, 0 fills the whole column
+    bool stringKeys = false; ///< title and note hold the number 10^(length - 1) + row, equal for cast and title row i
+    uint64_t seed = 42;
+    int numThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+};
+
+template<typename Record>
+concept CastRecord = requires(Record record) { record.castInfoId; record.movieId; record.note; };
+
+template<typename Record>
+concept TitleRecord = requires(Record record) { record.titleId; record.title; record.md5sum; };
+
+/**
+ * @brief number of rows a file of outputSize bytes holds, rounded up like calcNumberOfRecords of the python generators
+ */
+inline std::size_t recordsForFileSize(const std::size_t outputSize, const std::size_t rowSize) {
+    return (outputSize + rowSize - 1) / rowSize;
+}
+
+/**
+ * @brief draws keys of one distribution, shared read only by all generating threads
+ */
+class KeySampler {
+public:
+    explicit KeySampler(const GeneratorOptions& options) : options(options) {
+        if(options.distribution == KeyDistribution::ZIPFIAN) {
+            const auto minValue = std::max(1, options.minValue); // 1 / 0^alpha is undefined
+            cdf.resize(static_cast<std::size_t>(std::max(1, options.maxValue - minValue)));
+            double sum = 0;
+            for(std::size_t rank = 0; rank < cdf.size(); ++rank) {
+                sum += 1.0 / std::pow(static_cast<double>(minValue) + static_cast<double>(rank), options.zipfAlpha);
+                cdf[rank] = sum;
+            }
+            for(auto& value: cdf) {
+                value /= sum;
+            }
+        }
+    }
+
+    int32_t operator()(const std::size_t row, std::mt19937_64& rng) const {
+        switch(options.distribution) {
+            case KeyDistribution::SEQUENTIAL:
+                return static_cast<int32_t>(row / std::max<std::size_t>(1, options.duplicatesPerKey) + 1);
+            case KeyDistribution::ZIPFIAN: {
+                const auto rank = std::lower_bound(cdf.begin(), cdf.end(), unit(rng)) - cdf.begin();
+                const auto key = std::max(1, options.minValue) + static_cast<int32_t>(std::min<std::ptrdiff_t>(rank, static_cast<std::ptrdiff_t>(cdf.size()) - 1));
+                return miss(rng) ? options.maxValue + MISS_KEY_OFFSET : key;
+            }
+            default: {
+                const auto key = uniform(rng);
+                return miss(rng) ? options.maxValue + MISS_KEY_OFFSET : key;
+            }
+        }
+    }
+
+    /**
+     * @brief uniform in [minValue, maxValue)
+     */
+    [[nodiscard]] int32_t uniform(std::mt19937_64& rng) const {
+        const auto range = static_cast<uint64_t>(std::max<int64_t>(1, int64_t(options.maxValue) - options.minValue));
+        return options.minValue + static_cast<int32_t>(rng() % range);
+    }
+
+private:
+    /**
+     * @brief only draws if there are misses at all, so relations without misses keep their keys
+     */
+    [[nodiscard]] bool miss(std::mt19937_64& rng) const {
+        return (options.distribution == KeyDistribution::MATCH_RATE || options.matchRate < 1) && unit(rng) >= options.matchRate;
+    }
+
+    static double unit(std::mt19937_64& rng) {
+        return static_cast<double>(rng() >> 11) * 0x1.0p-53;
+    }
+
+    GeneratorOptions options;
+    std::vector<double> cdf;
+};
+
+/**
+ * @brief characters of a string column with N bytes, one byte is always left for the terminator
+ */
+template<std::size_t N>
+constexpr std::size_t stringLengthFor(const std::size_t requested, const std::size_t fallback = N - 1) {
+    return std::min(N - 1, requested == 0 ? fallback : requested);
+}
+
+/**
+ * @brief fills length characters of field with random lowercase letters and zeroes the rest, so it prints and compares
+ * like a loaded string
+ */
+template<std::size_t N>
+inline void fillRandomString(char (&field)[N], std::mt19937_64& rng, const std::size_t length = N - 1) {
+    static_assert(N > 0);
+    for(std::size_t i = 0; i < length;) {
+        auto bits = rng();
+        for(int letter = 0; letter < 13 && i < length; ++letter, ++i, bits /= 26) { // 26^13 < 2^64
+            field[i] = static_cast<char>('a' + bits % 26);
+        }
+    }
+    std::memset(field + length, 0, N - length);
+}
+
+/**
+ * @brief writes 10^(length - 1) + row like the StringDataGenerator does with length 60, so the strings of cast row i
+ * and title row i are equal and all strings share a long common prefix. length grows if row does not fit.
+ */
+template<std::size_t N>
+inline void fillRowString(char (&field)[N], const std::size_t row, std::size_t length = 60) {
+    char digits[20];
+    const auto end = std::to_chars(digits, digits + sizeof(digits), row).ptr;
+    const auto numDigits = static_cast<std::size_t>(end - digits);
+    length = std::min(N - 1, std::max(length, numDigits + 1));
+    std::memset(field, '0', length);
+    field[0] = '1';
+    std::memcpy(field + length - numDigits, digits, numDigits);
+    std::memset(field + length, 0, N - length);
+}
+
+/**
+ * @brief generates rows [firstRow, firstRow + rows.size()) of a relation, firstRow has to be a multiple of
+ * GENERATOR_CHUNK_SIZE. Key ordering of SORTED is not applied here.
+ */
+template<typename Record>
+inline void generateRows(const std::span<Record> rows, const std::size_t firstRow, const KeySampler& sampler, const GeneratorOptions& options) {
+    const auto numChunks = static_cast<int64_t>((rows.size() + GENERATOR_CHUNK_SIZE - 1) / GENERATOR_CHUNK_SIZE);
+    #pragma omp parallel for schedule(dynamic) num_threads(options.numThreads)
+    for(int64_t chunk = 0; chunk < numChunks; ++chunk) {
+        const auto begin = static_cast<std::size_t>(chunk) * GENERATOR_CHUNK_SIZE;
+        const auto end = std::min(rows.size(), begin + GENERATOR_CHUNK_SIZE);
+        std::seed_seq seed{options.seed, static_cast<uint64_t>((firstRow + begin) / GENERATOR_CHUNK_SIZE)};
+        std::mt19937_64 rng(seed);
+        for(std::size_t i = begin; i < end; ++i) {
+            const auto row = firstRow + i;
+            Record& record = rows[i];
+            if constexpr(CastRecord<Record>) {
+                record.castInfoId = static_cast<int32_t>(row + 1);
+                record.personId = sampler.uniform(rng);
+                record.movieId = sampler(row, rng);
+                record.personRoleId = sampler.uniform(rng);
+                if(options.stringKeys) {
+                    fillRowString(record.note, row, stringLengthFor<sizeof(record.note)>(options.stringLength, 60));
+                } else {
+                    fillRandomString(record.note, rng, stringLengthFor<sizeof(record.note)>(options.stringLength));
+                }
+                record.nrOrder = sampler.uniform(rng);
+                record.roleId = sampler.uniform(rng);
+            } else {
+                static_assert(TitleRecord<Record>, "Record has to be a cast or a title record");
+                record.titleId = sampler(row, rng);
+                if(options.stringKeys) {
+                    fillRowString(record.title, row, stringLengthFor<sizeof(record.title)>(options.stringLength, 60));
+                } else {
+                    fillRandomString(record.title, rng, stringLengthFor<sizeof(record.title)>(options.stringLength));
+                }
+                fillRandomString(record.imdbIndex, rng);
+                record.kindId = sampler.uniform(rng);
+                record.productionYear = sampler.uniform(rng);
+                record.imdbId = sampler.uniform(rng);
+                fillRandomString(record.phoneticCode, rng);
+                record.episodeOfId = sampler.uniform(rng);
+                record.seasonNr = sampler.uniform(rng);
+                record.episodeNr = sampler.uniform(rng);
+                fillRandomString(record.seriesYears, rng);
+                fillRandomString(record.md5sum, rng);
+            }
+        }
+    }
+}
+
+/**
+ * @brief key field of a cast or title record
+ */
+template<typename Record>
+inline int32_t& keyOf(Record& record) {
+    if constexpr(CastRecord<Record>) {
+        return record.movieId;
+    } else {
+        return record.titleId;
+    }
+}
+
+/**
+ * @brief the whole relation in memory, nothing touches the disk
+ */
+template<typename Record>
+inline std::vector<Record> generateRelation(const GeneratorOptions& options) {
+    std::vector<Record> relation(options.numRecords);
+    const KeySampler sampler(options);
+    generateRows(std::span<Record>(relation), 0, sampler, options);
+    if(options.distribution == KeyDistribution::SORTED) { // sort the keys only, ids stay ascending
+        std::vector<int32_t> keys(relation.size());
+        for(std::size_t i = 0; i < relation.size(); ++i) {
+            keys[i] = keyOf(relation[i]);
+        }
+        std::sort(keys.begin(), keys.end());
+        for(std::size_t i = 0; i < relation.size(); ++i) {
+            keyOf(relation[i]) = keys[i];
+        }
+    }
+    return relation;
+}
+
+/**
+ * @brief a cast and a title relation that join on movieId = titleId
+ */
+struct RelationSpec {
+    std::size_t numCasts = 20000;
+    std::size_t numTitles = 20000;
+    KeyDistribution distribution = KeyDistribution::UNIFORM; ///< of the movieIds over the titleIds
+    double zipfTheta = 0.99;
+    double matchRate = 1.0; ///< fraction of the cast tuples that find a title
+    std::size_t duplicatesPerKey = 1; ///< title tuples per titleId
+    std::size_t stringLength = 0; ///< characters of note and title, 0 fills the whole column
+    bool matchingStrings = false; ///< note of cast tuple i equals title of title tuple i, for the string joins
+    uint64_t seed = 42;
+    int numThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+};
+
+template<typename Cast, typename Title>
+struct GeneratedRelations {
+    std::vector<Cast> cast;
+    std::vector<Title> title;
+};
+
+/**
+ * @brief generates both relations in memory. The titleIds are 1..numTitles / duplicatesPerKey, every duplicatesPerKey
+ * consecutive title tuples share one, and the movieIds are drawn from them with the given distribution.
+ */
+template<typename Cast, typename Title>
+inline GeneratedRelations<Cast, Title> generateRelations(const RelationSpec& spec) {
+    const auto numKeys = std::max<std::size_t>(1, (spec.numTitles + spec.duplicatesPerKey - 1) / std::max<std::size_t>(1, spec.duplicatesPerKey));
+    GeneratorOptions title;
+    title.numRecords = spec.numTitles;
+    title.distribution = KeyDistribution::SEQUENTIAL;
+    title.maxValue = static_cast<int32_t>(numKeys + 1);
+    title.duplicatesPerKey = spec.duplicatesPerKey;
+    title.stringLength = spec.stringLength;
+    title.stringKeys = spec.matchingStrings;
+    title.seed = spec.seed;
+    title.numThreads = spec.numThreads;
+    GeneratorOptions cast = title;
+    cast.numRecords = spec.numCasts;
+    cast.distribution = spec.distribution;
+    cast.duplicatesPerKey = 1;
+    cast.zipfAlpha = spec.zipfTheta;
+    cast.matchRate = spec.matchRate;
+    cast.seed = spec.seed + 1; // independent of the title streams
+    return {generateRelation<Cast>(cast), generateRelation<Title>(title)};
+}
+
+//==--------------------------------------------------------------------==//
+//==----------------------------- OUTPUT -------------------------------==//
+//==--------------------------------------------------------------------==//
+
+/**
+ * @brief first bytes of a binary relation file, the records follow right after it
+ */
+struct RelationFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t tupleSize; ///< sizeof(Record) of the build that wrote the file
+    uint64_t numTuples;
+};
+
+static constexpr const char RELATION_FILE_MAGIC[8] = {'P', 'P', 'D', 'S', 'R', 'E', 'L', '\0'};
+static constexpr const uint32_t RELATION_FILE_VERSION = 1;
+
+inline void appendCsvValue(std::string& out, const int32_t value) {
+    char digits[12];
+    out.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+}
+
+template<std::size_t N>
+inline void appendCsvValue(std::string& out, const char (&value)[N]) {
+    out.append(value, strnlen(value, N));
+}
+
+template<typename Record>
+inline std::string csvHeader(const GeneratorOptions& options) {
+    if constexpr(CastRecord<Record>) {
+        return options.stringKeys ? "id,person_id,movie_id,person_role_id,last_title,nr_order,role_id\n"
+                                  : "id,person_id,movie_id,person_role_id,note,nr_order,role_id\n";
+    } else {
+        return "id,title,imdb_index,kind_id,production_year,imdb_id,phonetic_code,episode_of_id,season_nr,episode_nr,series_years,md5sum\n";
+    }
+}
+
+template<typename Record>
+inline void appendCsvRow(std::string& out, const Record& record) {
+    const auto field = [&out](const auto& value, const char separator) {
+        appendCsvValue(out, value);
+        out.push_back(separator);
+    };
+    if constexpr(CastRecord<Record>) {
+        field(record.castInfoId, ','); field(record.personId, ','); field(record.movieId, ',');
+        field(record.personRoleId, ','); field(record.note, ','); field(record.nrOrder, ','); field(record.roleId, '\n');
+    } else {
+        field(record.titleId, ','); field(record.title, ','); field(record.imdbIndex, ','); field(record.kindId, ',');
+        field(record.productionYear, ','); field(record.imdbId, ','); field(record.phoneticCode, ',');
+        field(record.episodeOfId, ','); field(record.seasonNr, ','); field(record.episodeNr, ',');
+        field(record.seriesYears, ','); field(record.md5sum, '\n');
+    }
+}
+
+/**
+ * @brief writes rows in the given format, CSV rows are formatted in parallel per chunk and written in order
+ */
+template<typename Record>
+inline bool writeRows(std::ofstream& file, const std::span<const Record> rows, const OutputFormat format, const int numThreads) {
+    if(format == OutputFormat::BINARY) {
+        file.write(reinterpret_cast<const char*>(rows.data()), static_cast<std::streamsize>(rows.size_bytes()));
+        return static_cast<bool>(file);
+    }
+    std::vector<std::string> buffers((rows.size() + GENERATOR_CHUNK_SIZE - 1) / GENERATOR_CHUNK_SIZE);
+    #pragma omp parallel for schedule(dynamic) num_threads(numThreads)
+    for(std::size_t chunk = 0; chunk < buffers.size(); ++chunk) {
+        const auto begin = chunk * GENERATOR_CHUNK_SIZE;
+        const auto end = std::min(rows.size(), begin + GENERATOR_CHUNK_SIZE);
+        buffers[chunk].reserve((end - begin) * (CastRecord<Record> ? CAST_CSV_ROW_SIZE : TITLE_CSV_ROW_SIZE));
+        for(std::size_t row = begin; row < end; ++row) {
+            appendCsvRow(buffers[chunk], rows[row]);
+        }
+    }
+    for(const auto& buffer: buffers) {
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+    return static_cast<bool>(file);
+}
+
+/**
+ * @brief generates a relation straight into filepath. Apart from SORTED, which needs all keys at once, only a few
+ * chunks per thread are in memory at any time, so files larger than memory work as well.
+ */
+template<typename Record>
+inline bool writeRelation(const std::string& filepath, const GeneratorOptions& options, const OutputFormat format) {
+    std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+    if(!file.is_open()) {
+        std::cerr << "Error: Failed to open file " << filepath << std::endl;
+        return false;
+    }
+    if(format == OutputFormat::BINARY) {
+        RelationFileHeader header{};
+        std::memcpy(header.magic, RELATION_FILE_MAGIC, sizeof(header.magic));
+        header.version = RELATION_FILE_VERSION;
+        header.tupleSize = sizeof(Record);
+        header.numTuples = options.numRecords;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    } else {
+        file << csvHeader<Record>(options);
+    }
+    if(options.distribution == KeyDistribution::SORTED) {
+        const auto relation = generateRelation<Record>(options);
+        return writeRows(file, std::span<const Record>(relation), format, options.numThreads);
+    }
+    const KeySampler sampler(options);
+    const auto batchSize = GENERATOR_CHUNK_SIZE * 4 * static_cast<std::size_t>(std::max(1, options.numThreads));
+    std::vector<Record> batch(std::min(batchSize, options.numRecords));
+    for(std::size_t firstRow = 0; firstRow < options.numRecords; firstRow += batchSize) {
+        const auto rows = std::span<Record>(batch).first(std::min(batchSize, options.numRecords - firstRow));
+        generateRows(rows, firstRow, sampler, options);
+        if(!writeRows(file, std::span<const Record>(rows), format, options.numThreads)) {
+            std::cerr << "Error: Failed to write " << filepath << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief reads a relation written with OutputFormat::BINARY, std::nullopt if the file is missing or was written for
+ * another record layout
+ */
+template<typename Record>
+inline std::optional<std::vector<Record>> loadBinary(const std::string& filepath) {
+    std::ifstream file(filepath, std::ios::binary);
+    RelationFileHeader header{};
+    if(!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        std::cerr << "Error: Failed to open file " << filepath << std::endl;
+        return std::nullopt;
+    }
+    if(std::memcmp(header.magic, RELATION_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != RELATION_FILE_VERSION
+       || header.tupleSize != sizeof(Record)) {
+        std::cerr << "Error: " << filepath << " is not a binary relation of this record type" << std::endl;
+        return std::nullopt;
+    }
+    std::vector<Record> relation(header.numTuples);
+    if(!file.read(reinterpret_cast<char*>(relation.data()), static_cast<std::streamsize>(relation.size() * sizeof(Record)))) {
+        std::cerr << "Error: " << filepath << " is truncated" << std::endl;
+        return std::nullopt;
+    }
+    return relation;
+}
+
+#endif //PPDS_UTIL_DATAGENERATOR_H
@@ -0,0 +1,299 @@
+#ifndef PPDS_UTIL_DIFFERENTIALHARNESS_H
+#define PPDS_UTIL_DIFFERENTIALHARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <omp.h>
+
+#include "DataGenerator.h"
+
+/**
+ * @brief order insensitive summary of a multiset of result rows. Two result sets with the same fingerprint are equal
+ * up to a collision of two independent 64 bit sums.
+ */
+struct ResultFingerprint {
+    std::size_t rows = 0;
+    uint64_t sum = 0;
+    uint64_t mixedSum = 0;
+
+    bool operator==(const ResultFingerprint&) const = default;
+
+    ResultFingerprint& operator+=(const ResultFingerprint& other) {
+        rows += other.rows;
+        sum += other.sum;
+        mixedSum += other.mixedSum;
+        return *this;
+    }
+};
+
+inline uint64_t mixHash(uint64_t value) { // murmur3 finalizer
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+/**
+ * @brief FNV-1a over the fields of a result row. Fields are hashed one by one, so padding bytes do not matter, and
+ * strings are hashed up to their terminator, like they compare.
+ */
+template<typename Result>
+inline uint64_t hashResultRow(const Result& row) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const auto bytes = [&hash](const void* data, const std::size_t size) {
+        const auto* begin = static_cast<const unsigned char*>(data);
+        for(std::size_t i = 0; i < size; ++i) {
+            hash = (hash ^ begin[i]) * 0x100000001b3ULL;
+        }
+    };
+    const auto field = [&bytes](const auto& value) {
+        if constexpr(std::is_array_v<std::remove_cvref_t<decltype(value)>>) {
+            bytes(value, strnlen(value, sizeof(value)));
+            bytes("", 1); // separates "ab","c" from "a","bc"
+        } else {
+            bytes(&value, sizeof(value));
+        }
+    };
+    field(row.titleId); field(row.title); field(row.imdbIndex); field(row.kindId); field(row.productionYear);
+    field(row.imdbId); field(row.phoneticCode); field(row.episodeOfId); field(row.seasonNr); field(row.episodeNr);
+    field(row.seriesYears); field(row.md5sum); field(row.castInfoId); field(row.personId); field(row.movieId);
+    field(row.personRoleId); field(row.note); field(row.nrOrder); field(row.roleId);
+    return hash;
+}
+
+template<typename Result>
+inline ResultFingerprint fingerprintOf(const Result& row) {
+    const auto hash = hashResultRow(row);
+    return {1, hash, mixHash(hash ^ 0x9e3779b97f4a7c15ULL)};
+}
+
+template<typename Result>
+inline ResultFingerprint fingerprintOf(const std::vector<Result>& rows, const int numThreads) {
+    std::vector<ResultFingerprint> local(static_cast<std::size_t>(std::max(1, numThreads)));
+    #pragma omp parallel num_threads(numThreads)
+    {
+        auto& fingerprint = local[static_cast<std::size_t>(omp_get_thread_num())];
+        #pragma omp for schedule(static)
+        for(std::size_t i = 0; i < rows.size(); ++i) {
+            fingerprint += fingerprintOf(rows[i]);
+        }
+    }
+    ResultFingerprint total;
+    for(const auto& fingerprint: local) {
+        total += fingerprint;
+    }
+    return total;
+}
+
+/**
+ * @brief outcome of one engine on one dataset
+ */
+struct DifferentialOutcome {
+    std::string engine;
+    std::string dataset;
+    bool correct;
+    std::size_t expectedRows;
+    std::size_t actualRows;
+    std::size_t missingRows; ///< rows of the reference the engine did not return, counted with multiplicity
+    std::size_t unexpectedRows; ///< rows the engine returned too often or that are not in the reference
+    double medianMs;
+    double tuplesPerSecond; ///< input tuples of both relations over medianMs
+};
+
+inline std::ostream& operator<<(std::ostream& out, const DifferentialOutcome& outcome) {
+    return out << outcome.engine << " on " << outcome.dataset << ": " << outcome.missingRows << " missing and "
+               << outcome.unexpectedRows << " unexpected rows";
+}
+
+/**
+ * @brief runs every registered engine on the same inputs and compares its results with a hash join reference as
+ * multisets, so result order does not matter but lost, duplicated or corrupted rows do. Timing happens in the same
+ * run. The reference is only fingerprinted, its rows are materialized again solely to explain a mismatch.
+ */
+template<typename Cast, typename Title, typename Result>
+class DifferentialHarness {
+public:
+    using Engine = std::function<std::vector<Result>(const std::vector<Cast>&, const std::vector<Title>&, int)>;
+
+    explicit DifferentialHarness(const int numThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency())), const int repetitions = 1)
+        : numThreads(numThreads), repetitions(std::max(1, repetitions)) {}
+
+    /**
+     * @brief engines with sortedInput get both relations sorted by their join key, like the sort merge joins expect
+     */
+    void add(std::string name, Engine engine, const bool sortedInput = false) {
+        engines.push_back({std::move(name), std::move(engine), sortedInput});
+    }
+
+    std::vector<DifferentialOutcome> run(const std::string& dataset, const std::vector<Cast>& castRelation, const std::vector<Title>& titleRelation) {
+        const auto expected = referenceFingerprint(castRelation, titleRelation);
+        std::vector<Cast> sortedCast;
+        std::vector<Title> sortedTitle;
+        // sorted once up front, an empty side must not leave the other side unsorted or empty
+        if(std::any_of(engines.begin(), engines.end(), [](const auto& engine) {return engine.sortedInput;})) {
+            sortedCast = castRelation;
+            sortedTitle = titleRelation;
+            std::sort(sortedCast.begin(), sortedCast.end(), [](const Cast& a, const Cast& b) {return a.movieId < b.movieId;});
+            std::sort(sortedTitle.begin(), sortedTitle.end(), [](const Title& a, const Title& b) {return a.titleId < b.titleId;});
+        }
+        std::vector<DifferentialOutcome> outcomes;
+        for(const auto& engine: engines) {
+            const auto& cast = engine.sortedInput ? sortedCast : castRelation;
+            const auto& title = engine.sortedInput ? sortedTitle : titleRelation;
+            DifferentialOutcome outcome{engine.name, dataset, true, expected.rows, 0, 0, 0, 0, 0};
+            std::vector<double> runtimes;
+            for(int i = 0; i < repetitions; ++i) {
+                const auto start = std::chrono::steady_clock::now();
+                const auto results = engine.join(cast, title, numThreads);
+                runtimes.emplace_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                const auto actual = fingerprintOf(results, numThreads);
+                if(i == 0 || actual != expected) { // every repetition is checked, the first mismatch is explained
+                    outcome.actualRows = actual.rows;
+                }
+                if(actual != expected && outcome.correct) {
+                    outcome.correct = false;
+                    explainMismatch(castRelation, titleRelation, results, outcome);
+                }
+            }
+            std::sort(runtimes.begin(), runtimes.end());
+            outcome.medianMs = runtimes[runtimes.size() / 2];
+            outcome.tuplesPerSecond = outcome.medianMs > 0 ? static_cast<double>(castRelation.size() + titleRelation.size()) / (outcome.medianMs / 1000) : 0;
+            outcomes.emplace_back(outcome);
+            history.emplace_back(outcome);
+        }
+        return outcomes;
+    }
+
+    [[nodiscard]] const std::vector<DifferentialOutcome>& results() const { return history; }
+
+    void print(std::ostream& out = std::cout) const {
+        out << std::left << std::setw(28) << "engine" << std::setw(16) << "dataset" << std::setw(10) << "correct"
+            << std::setw(12) << "rows" << std::setw(10) << "missing" << std::setw(12) << "unexpected" << std::setw(14) << "median [ms]"
+            << "M tuples/s" << '\n';
+        for(const auto& outcome: history) {
+            out << std::setw(28) << outcome.engine << std::setw(16) << outcome.dataset << std::setw(10) << (outcome.correct ? "yes" : "NO")
+                << std::setw(12) << outcome.actualRows << std::setw(10) << outcome.missingRows << std::setw(12) << outcome.unexpectedRows
+                << std::setw(14) << outcome.medianMs << outcome.tuplesPerSecond / 1e6 << '\n';
+        }
+        out << std::right << std::flush;
+    }
+
+private:
+    struct RegisteredEngine {
+        std::string name;
+        Engine join;
+        bool sortedInput;
+    };
+
+    /**
+     * @brief calls f(cast, title) for every matching pair, in parallel over the cast relation
+     */
+    template<typename F>
+    void forEachReferenceMatch(const std::vector<Cast>& castRelation, const std::vector<Title>& titleRelation, F&& f) const {
+        std::unordered_multimap<int32_t, const Title*> titles;
+        titles.reserve(titleRelation.size());
+        for(const auto& title: titleRelation) {
+            titles.emplace(title.titleId, &title);
+        }
+        #pragma omp parallel for schedule(static) num_threads(numThreads)
+        for(std::size_t i = 0; i < castRelation.size(); ++i) {
+            const auto [begin, end] = titles.equal_range(castRelation[i].movieId);
+            for(auto it = begin; it != end; ++it) {
+                f(castRelation[i], *it->second);
+            }
+        }
+    }
+
+    ResultFingerprint referenceFingerprint(const std::vector<Cast>& castRelation, const std::vector<Title>& titleRelation) const {
+        std::vector<ResultFingerprint> local(static_cast<std::size_t>(numThreads));
+        forEachReferenceMatch(castRelation, titleRelation, [&local](const Cast& cast, const Title& title) {
+            local[static_cast<std::size_t>(omp_get_thread_num())] += fingerprintOf(createResultTuple(cast, title));
+        });
+        ResultFingerprint total;
+        for(const auto& fingerprint: local) {
+            total += fingerprint;
+        }
+        return total;
+    }
+
+    /**
+     * @brief counts missing and unexpected rows by comparing the sorted row hashes of both sides
+     */
+    void explainMismatch(const std::vector<Cast>& castRelation, const std::vector<Title>& titleRelation, const std::vector<Result>& results,
+                         DifferentialOutcome& outcome) const {
+        std::vector<std::vector<uint64_t>> local(static_cast<std::size_t>(numThreads));
+        forEachReferenceMatch(castRelation, titleRelation, [&local](const Cast& cast, const Title& title) {
+            local[static_cast<std::size_t>(omp_get_thread_num())].emplace_back(hashResultRow(createResultTuple(cast, title)));
+        });
+        std::vector<uint64_t> expected;
+        for(const auto& hashes: local) {
+            expected.insert(expected.end(), hashes.begin(), hashes.end());
+        }
+        std::vector<uint64_t> actual(results.size());
+        for(std::size_t i = 0; i < results.size(); ++i) {
+            actual[i] = hashResultRow(results[i]);
+        }
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        std::vector<uint64_t> difference;
+        std::set_difference(expected.begin(), expected.end(), actual.begin(), actual.end(), std::back_inserter(difference));
+        outcome.missingRows = difference.size();
+        difference.clear();
+        std::set_difference(actual.begin(), actual.end(), expected.begin(), expected.end(), std::back_inserter(difference));
+        outcome.unexpectedRows = difference.size();
+    }
+
+    int numThreads;
+    int repetitions;
+    std::vector<RegisteredEngine> engines;
+    std::vector<DifferentialOutcome> history;
+};
+
+/**
+ * @brief relations of a differential dataset, numTitles titles with duplicatesPerKey tuples per titleId
+ */
+template<typename Cast, typename Title>
+inline GeneratedRelations<Cast, Title> differentialDataset(const KeyDistribution distribution, const double matchRate, const std::size_t duplicatesPerKey = 1,
+                                                           const std::size_t numCasts = 40000, const std::size_t numTitles = 20000) {
+    RelationSpec spec;
+    spec.numCasts = numCasts;
+    spec.numTitles = numTitles;
+    spec.distribution = distribution;
+    spec.matchRate = matchRate;
+    spec.duplicatesPerKey = duplicatesPerKey;
+    return generateRelations<Cast, Title>(spec);
+}
+
+/**
+ * @brief runs the harness on the datasets every stage is checked on and returns all outcomes. titleId is unique like
+ * the primary key of title: every title matches two cast tuples on average, zipf skewed, with only 30% of the cast
+ * tuples matching, or exactly one cast tuple per title
+ */
+template<typename Cast, typename Title, typename Result>
+inline std::vector<DifferentialOutcome> runStandardDatasets(DifferentialHarness<Cast, Title, Result>& harness) {
+    std::vector<DifferentialOutcome> outcomes;
+    const auto run = [&harness, &outcomes](const char* name, const GeneratedRelations<Cast, Title>& relations) {
+        const auto datasetOutcomes = harness.run(name, relations.cast, relations.title);
+        outcomes.insert(outcomes.end(), datasetOutcomes.begin(), datasetOutcomes.end());
+    };
+    run("onetomany", differentialDataset<Cast, Title>(KeyDistribution::UNIFORM, 1.0));
+    run("zipf", differentialDataset<Cast, Title>(KeyDistribution::ZIPFIAN, 1.0));
+    run("matchrate", differentialDataset<Cast, Title>(KeyDistribution::UNIFORM, 0.3));
+    run("onetoone", differentialDataset<Cast, Title>(KeyDistribution::SEQUENTIAL, 1.0, 1, 20000));
+    return outcomes;
+}
+
+#endif //PPDS_UTIL_DIFFERENTIALHARNESS_H
@@ -0,0 +1,240 @@
+#ifndef PPDS_UTIL_HARDWAREINFO_H
+#define PPDS_UTIL_HARDWAREINFO_H
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+/**
+ * @brief one data or unified cache level as seen by a single core
+ */
+struct CacheLevel {
+    std::size_t size = 0; ///< total size in bytes
+    std::size_t lineSize = 0;
+    std::size_t associativity = 0;
+    std::size_t sharedBy = 1; ///< number of logical cpus sharing this cache
+
+    /**
+     * @brief the part of the cache a single thread can count on when all cpus sharing it are busy
+     */
+    [[nodiscard]] std::size_t perThread() const { return size / std::max<std::size_t>(1, sharedBy); }
+};
+
+/**
+ * @brief cache and TLB parameters of the machine the binary runs on, detected once at startup.
+ * Sizes come from /sys/devices/system/cpu/cpu0/cache, TLB entries from CPUID. Every value can be overridden with an
+ * environment variable (PPDS_L1_CACHE_SIZE, PPDS_L2_CACHE_SIZE, PPDS_L3_CACHE_SIZE, PPDS_CACHE_LINE_SIZE,
+ * PPDS_DTLB_ENTRIES), which is also the way to tune a host where detection is wrong. Undetectable values fall back to
+ * conservative defaults, never to 0 or -1.
+ */
+class HardwareInfo {
+public:
+    static const HardwareInfo& get() {
+        static const HardwareInfo info;
+        return info;
+    }
+
+    [[nodiscard]] const std::string& cpuName() const { return name; }
+    [[nodiscard]] const CacheLevel& l1() const { return caches[0]; }
+    [[nodiscard]] const CacheLevel& l2() const { return caches[1]; }
+    [[nodiscard]] const CacheLevel& l3() const { return caches[2]; }
+
+    /**
+     * @brief L1 and L2 as available to one physical core, L3 as a whole
+     */
+    [[nodiscard]] std::size_t l1CacheSize() const { return perCore(l1()); }
+    [[nodiscard]] std::size_t l2CacheSize() const { return perCore(l2()); }
+    [[nodiscard]] std::size_t l3CacheSize() const { return l3().size; }
+    [[nodiscard]] std::size_t cacheLineSize() const { return lineSize; }
+    [[nodiscard]] std::size_t dtlbEntries() const { return tlbEntries; }
+    [[nodiscard]] std::size_t smtSiblings() const { return siblings; }
+
+    //==--------------------------------------------------------------------==//
+    //==------------------------- TUNING PARAMETERS ------------------------==//
+    //==--------------------------------------------------------------------==//
+
+    /**
+     * @brief number of entries of entryBytes each that a hash table may have to stay inside the private L2 of one
+     * thread. Override: PPDS_HASHMAP_ENTRIES
+     */
+    [[nodiscard]] std::size_t hashMapEntries(const std::size_t entryBytes) const {
+        return readOverride("PPDS_HASHMAP_ENTRIES", std::max<std::size_t>(1, l2().perThread() / entryBytes));
+    }
+
+    /**
+     * @brief number of radix bits to partition a build side of buildTuples by: enough partitions to keep numThreads
+     * busy and to fit each partition's hash table into L2, but at most as many partitions as the DTLB has entries, so
+     * every partition's output page stays mapped. Override: PPDS_PARTITION_BITS
+     */
+    [[nodiscard]] std::size_t partitionBits(const std::size_t buildTuples, const std::size_t entryBytes, const std::size_t numThreads) const {
+        const auto forThreads = static_cast<std::size_t>(std::bit_width(std::max<std::size_t>(1, numThreads) - 1));
+        const auto partitions = (buildTuples + hashMapEntries(entryBytes) - 1) / hashMapEntries(entryBytes);
+        const auto forCache = static_cast<std::size_t>(std::bit_width(std::max<std::size_t>(1, partitions) - 1));
+        const auto maxBits = static_cast<std::size_t>(std::bit_width(dtlbEntries()) - 1);
+        const auto bits = std::clamp(std::max(forThreads, forCache), std::size_t(1), std::max<std::size_t>(1, maxBits));
+        return readOverride("PPDS_PARTITION_BITS", bits);
+    }
+
+    void print() const {
+        std::cout << "CPU: " << name << '\n'
+                  << "L1 cache size: " << l1().size << " (shared by " << l1().sharedBy << ")\n"
+                  << "L2 cache size: " << l2().size << " (shared by " << l2().sharedBy << ")\n"
+                  << "L3 cache size: " << l3().size << " (shared by " << l3().sharedBy << ")\n"
+                  << "Cache line size: " << lineSize << '\n'
+                  << "DTLB entries: " << tlbEntries << '\n'
+                  << "SMT siblings: " << siblings << std::endl;
+    }
+
+private:
+    HardwareInfo() {
+        name = readCpuName();
+        for(int index = 0; index < 8; ++index) {
+            const auto path = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+            const auto type = readLine(path + "type");
+            if(type.empty()) {
+                break;
+            }
+            const auto level = readNumber(path + "level", 0);
+            if(type == "Instruction" || level < 1 || level > 3) {
+                continue;
+            }
+            auto& cache = caches[level - 1];
+            cache.size = parseSize(readLine(path + "size"));
+            cache.lineSize = readNumber(path + "coherency_line_size", 0);
+            cache.associativity = readNumber(path + "ways_of_associativity", 0);
+            cache.sharedBy = std::max<std::size_t>(1, countCpus(readLine(path + "shared_cpu_list")));
+        }
+        siblings = std::max<std::size_t>(1, countCpus(readLine("/sys/devices/system/cpu/cpu0/topology/thread_siblings_list")));
+
+        // fall back to a small but common configuration instead of leaving anything at 0
+        static constexpr std::size_t DEFAULT_SIZES[] = {32 * 1024, 256 * 1024, 8 * 1024 * 1024};
+        for(std::size_t i = 0; i < 3; ++i) {
+            if(caches[i].size == 0) {
+                caches[i].size = DEFAULT_SIZES[i];
+                caches[i].sharedBy = i < 2 ? siblings : std::max(1u, std::thread::hardware_concurrency());
+            }
+        }
+        caches[0].size = readOverride("PPDS_L1_CACHE_SIZE", caches[0].size);
+        caches[1].size = readOverride("PPDS_L2_CACHE_SIZE", caches[1].size);
+        caches[2].size = readOverride("PPDS_L3_CACHE_SIZE", caches[2].size);
+        lineSize = readOverride("PPDS_CACHE_LINE_SIZE", caches[0].lineSize > 0 ? caches[0].lineSize : 64);
+        tlbEntries = readOverride("PPDS_DTLB_ENTRIES", detectDtlbEntries());
+    }
+
+    [[nodiscard]] std::size_t perCore(const CacheLevel& cache) const {
+        return cache.size / std::max<std::size_t>(1, cache.sharedBy / siblings);
+    }
+
+    static std::string readLine(const std::string& path) {
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+
+    static std::size_t readNumber(const std::string& path, const std::size_t fallback) {
+        const auto line = readLine(path);
+        return line.empty() ? fallback : std::strtoull(line.c_str(), nullptr, 10);
+    }
+
+    static std::size_t readOverride(const char* variable, const std::size_t detected) {
+        const char* value = std::getenv(variable);
+        if(value == nullptr || *value == '\0') {
+            return detected;
+        }
+        const auto parsed = parseSize(value);
+        return parsed > 0 ? parsed : detected;
+    }
+
+    /**
+     * @brief parses sizes like "48K", "2048K", "32M" or plain byte counts
+     */
+    static std::size_t parseSize(const std::string& text) {
+        char* end = nullptr;
+        const auto value = std::strtoull(text.c_str(), &end, 10);
+        switch(end != nullptr ? *end : '\0') {
+            case 'K': case 'k': return value * 1024;
+            case 'M': case 'm': return value * 1024 * 1024;
+            case 'G': case 'g': return value * 1024 * 1024 * 1024;
+            default: return value;
+        }
+    }
+
+    /**
+     * @brief counts the cpus of a sysfs list like "0-3,8-11"
+     */
+    static std::size_t countCpus(const std::string& list) {
+        std::size_t count = 0;
+        std::istringstream ss(list);
+        std::string range;
+        while(std::getline(ss, range, ',')) {
+            if(range.empty()) {
+                continue;
+            }
+            const auto dash = range.find('-');
+            const auto first = std::strtoull(range.c_str(), nullptr, 10);
+            const auto last = dash == std::string::npos ? first : std::strtoull(range.c_str() + dash + 1, nullptr, 10);
+            count += last - first + 1;
+        }
+        return count;
+    }
+
+    static std::string readCpuName() {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while(std::getline(cpuinfo, line)) {
+            if(line.starts_with("model name") || line.starts_with("Model")) {
+                const auto colon = line.find(':');
+                if(colon != std::string::npos) {
+                    return line.substr(line.find_first_not_of(' ', colon + 1));
+                }
+            }
+        }
+        return "unknown";
+    }
+
+    /**
+     * @brief entries of the largest data (or unified) TLB for 4 KiB pages
+     */
+    static std::size_t detectDtlbEntries() {
+        std::size_t entries = 0;
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int eax, ebx, ecx, edx;
+        // Intel: deterministic address translation parameters
+        if(__get_cpuid_count(0x18, 0, &eax, &ebx, &ecx, &edx)) {
+            const auto maxSubleaf = eax;
+            for(unsigned int subleaf = 0; subleaf <= maxSubleaf && subleaf < 32; ++subleaf) {
+                __get_cpuid_count(0x18, subleaf, &eax, &ebx, &ecx, &edx);
+                const auto type = edx & 0x1F; // 1 data, 3 unified
+                const bool smallPages = ebx & 0x1;
+                if((type == 1 || type == 3) && smallPages) {
+                    entries = std::max<std::size_t>(entries, static_cast<std::size_t>(ebx >> 16) * ecx);
+                }
+            }
+        }
+        // AMD: L2 TLB for 4 KiB pages
+        if(entries == 0 && __get_cpuid(0x80000006, &eax, &ebx, &ecx, &edx)) {
+            entries = (ebx >> 16) & 0xFFF;
+        }
+#endif
+        return entries > 0 ? entries : 64;
+    }
+
+    std::string name;
+    CacheLevel caches[3];
+    std::size_t lineSize = 64;
+    std::size_t tlbEntries = 64;
+    std::size_t siblings = 1;
+};
+
+#endif //PPDS_UTIL_HARDWAREINFO_H
@@ -0,0 +1,607 @@
+#ifndef PPDS_UTIL_INSTRUMENTATION_H
+#define PPDS_UTIL_INSTRUMENTATION_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "PerfCounters.h"
+
+/**
+ * Engines mark their phases with PPDS_PHASE(phase, tuples), which times the rest of the enclosing scope, and their
+ * partitions with PPDS_PARTITION(castTuples, titleTuples). Their containers use AccountedAllocator and report
+ * resizes of containers they cannot change the type of with PPDS_RESIZE(category, oldBytes, newBytes), their hash
+ * tables with PPDS_HASH_TABLE(map). All of them compile to nothing unless PPDS_INSTRUMENTATION is
+ * defined to 1 (cmake -DPPDS_INSTRUMENTATION=ON), so the engines pay nothing for them in normal builds. PPDS_PHASE
+ * also compiles in with PPDS_PROFILER (cmake -DPPDS_PROFILER=ON), which attributes samples to the phases.
+ * Instrumentation::get().reset(true) additionally counts the hardware events (PerfCounters) of every phase.
+ */
+#ifndef PPDS_INSTRUMENTATION
+#define PPDS_INSTRUMENTATION 0
+#endif
+
+#ifndef PPDS_PROFILER
+#define PPDS_PROFILER 0
+#endif
+
+/**
+ * @brief the phases of a join that are timed separately
+ */
+enum class Phase : uint8_t {
+    LOAD = 0,
+    PARTITION = 1,
+    BUILD = 2,
+    PROBE = 3,
+    MATERIALIZE = 4,
+    WAIT = 5, ///< blocked on a lock shared with other threads, e.g. m_results
+};
+
+static constexpr const std::size_t NUM_PHASES = 6;
+
+inline const char* phaseName(const Phase phase) {
+    static constexpr const char* NAMES[NUM_PHASES] = {"load", "partition", "build", "probe", "materialize", "wait"};
+    return NAMES[static_cast<std::size_t>(phase)];
+}
+
+/**
+ * @brief the data structures whose memory is accounted separately
+ */
+enum class MemoryCategory : uint8_t {
+    RELATIONS = 0, ///< the input relations
+    PARTITIONS = 1,
+    HASH_TABLE = 2,
+    LOCAL_RESULTS = 3, ///< matches of one thread before they are materialized
+    RESULTS = 4, ///< materialized ResultRelations
+};
+
+static constexpr const std::size_t NUM_MEMORY_CATEGORIES = 5;
+
+inline const char* memoryCategoryName(const MemoryCategory category) {
+    static constexpr const char* NAMES[NUM_MEMORY_CATEGORIES] = {"relations", "partitions", "hash table", "local results", "results"};
+    return NAMES[static_cast<std::size_t>(category)];
+}
+
+/**
+ * @brief resident set size of the process and its high water mark since the last resetPeakResidentBytes(), 0 where
+ * /proc/self/status is not available
+ */
+struct ResidentMemory {
+    uint64_t currentBytes = 0; ///< VmRSS
+    uint64_t peakBytes = 0; ///< VmHWM
+};
+
+inline ResidentMemory readResidentMemory() {
+    ResidentMemory memory;
+    std::ifstream status("/proc/self/status");
+    for(std::string line; std::getline(status, line);) {
+        const auto kiloBytes = [&line] { return std::strtoull(line.c_str() + line.find(':') + 1, nullptr, 10) * 1024; };
+        if(line.starts_with("VmRSS:")) {
+            memory.currentBytes = kiloBytes();
+        } else if(line.starts_with("VmHWM:")) {
+            memory.peakBytes = kiloBytes();
+        }
+    }
+    return memory;
+}
+
+/**
+ * @brief lowers VmHWM to the current VmRSS, false if the kernel does not allow it (before Linux 4.0)
+ */
+inline bool resetPeakResidentBytes() {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.flush();
+    return static_cast<bool>(clearRefs);
+}
+
+/**
+ * @brief phase the calling thread is in, -1 outside of any PhaseScope. Read by the SamplingProfiler signal handler
+ */
+inline thread_local volatile std::sig_atomic_t currentPhase = -1;
+
+/**
+ * @brief time stamp counter, steady_clock nanoseconds where there is none
+ */
+inline uint64_t readTimestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/**
+ * @brief counters of one thread, only ever written by that thread. phase and liveBytes are atomic because
+ * MemorySampler reads them while the thread runs
+ */
+struct ThreadCounters {
+    std::array<uint64_t, NUM_PHASES> ticks{};
+    std::array<uint64_t, NUM_PHASES> tuples{};
+    std::atomic_int8_t phase = -1; ///< phase the thread is in, -1 outside of any
+    std::array<std::atomic_int64_t, NUM_MEMORY_CATEGORIES> liveBytes{}; ///< negative if other threads freed what this thread allocated
+    std::array<int64_t, NUM_MEMORY_CATEGORIES> peakBytes{};
+    std::array<uint64_t, NUM_MEMORY_CATEGORIES> allocatedBytes{};
+    std::array<uint64_t, NUM_MEMORY_CATEGORIES> allocations{};
+    std::array<uint64_t, NUM_PHASES> phaseAllocatedBytes{};
+    uint64_t hashTables = 0;
+    uint64_t hashTableEntries = 0;
+    uint64_t hashTableBuckets = 0;
+    uint64_t hashTableBytes = 0;
+    std::array<PerfCounts, NUM_PHASES> events{};
+    std::unique_ptr<PerfCounters> perf; ///< counters of this thread only, null unless the run counts events
+
+    void allocate(const MemoryCategory category, const std::size_t bytes) {
+        const auto i = static_cast<std::size_t>(category);
+        const auto live = liveBytes[i].load(std::memory_order_relaxed) + static_cast<int64_t>(bytes);
+        liveBytes[i].store(live, std::memory_order_relaxed);
+        peakBytes[i] = std::max(peakBytes[i], live);
+        allocatedBytes[i] += bytes;
+        ++allocations[i];
+        const auto current = phase.load(std::memory_order_relaxed);
+        if(current >= 0) {
+            phaseAllocatedBytes[static_cast<std::size_t>(current)] += bytes;
+        }
+    }
+
+    void deallocate(const MemoryCategory category, const std::size_t bytes) {
+        const auto i = static_cast<std::size_t>(category);
+        liveBytes[i].store(liveBytes[i].load(std::memory_order_relaxed) - static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief result of one instrumented run, times are in nanoseconds
+ */
+struct InstrumentationReport {
+    struct ThreadReport {
+        std::array<double, NUM_PHASES> nanoseconds{};
+        std::array<uint64_t, NUM_PHASES> tuples{};
+        std::array<PerfCounts, NUM_PHASES> events{}; ///< invalid unless the run counted events
+    };
+
+    /**
+     * @brief memory of one data structure. peakBytes sums the peaks of the threads, which is an upper bound of the
+     * footprint they had at the same time, sampledPeakBytes is the largest footprint MemorySampler saw
+     */
+    struct MemoryReport {
+        uint64_t allocatedBytes = 0;
+        uint64_t allocations = 0;
+        int64_t liveBytes = 0;
+        int64_t peakBytes = 0;
+        int64_t sampledPeakBytes = 0;
+    };
+
+    std::vector<ThreadReport> threads;
+    std::vector<std::pair<std::size_t, std::size_t>> partitionSizes; ///< cast and title tuples of every joined partition
+    std::array<MemoryReport, NUM_MEMORY_CATEGORIES> memory{};
+    std::array<uint64_t, NUM_PHASES> phaseAllocatedBytes{}; ///< bytes the accounted containers allocated in every phase
+    std::array<uint64_t, NUM_PHASES> phasePeakResidentBytes{}; ///< largest VmRSS MemorySampler saw while a thread was in the phase
+    ResidentMemory startResident; ///< at reset
+    ResidentMemory resident; ///< at report, peakBytes covers the whole run if VmHWM could be reset
+    uint64_t hashTables = 0;
+    uint64_t hashTableEntries = 0;
+    uint64_t hashTableBuckets = 0;
+    uint64_t hashTableBytes = 0;
+
+    [[nodiscard]] double hashTableLoadFactor() const {
+        return hashTableBuckets > 0 ? static_cast<double>(hashTableEntries) / static_cast<double>(hashTableBuckets) : 0;
+    }
+
+    [[nodiscard]] double hashTableBytesPerEntry() const {
+        return hashTableEntries > 0 ? static_cast<double>(hashTableBytes) / static_cast<double>(hashTableEntries) : 0;
+    }
+
+    /**
+     * @brief time of phase summed over all threads
+     */
+    [[nodiscard]] double totalNanoseconds(const Phase phase) const {
+        double sum = 0;
+        for(const auto& thread: threads) {
+            sum += thread.nanoseconds[static_cast<std::size_t>(phase)];
+        }
+        return sum;
+    }
+
+    /**
+     * @brief time of the slowest thread in phase
+     */
+    [[nodiscard]] double maxNanoseconds(const Phase phase) const {
+        double max = 0;
+        for(const auto& thread: threads) {
+            max = std::max(max, thread.nanoseconds[static_cast<std::size_t>(phase)]);
+        }
+        return max;
+    }
+
+    /**
+     * @brief slowest thread over the average of the threads that took part in phase, 1 is perfectly balanced
+     */
+    [[nodiscard]] double imbalance(const Phase phase) const {
+        std::size_t active = 0;
+        for(const auto& thread: threads) {
+            active += thread.nanoseconds[static_cast<std::size_t>(phase)] > 0;
+        }
+        const auto total = totalNanoseconds(phase);
+        return total > 0 ? maxNanoseconds(phase) * static_cast<double>(active) / total : 1.0;
+    }
+
+    [[nodiscard]] uint64_t totalTuples(const Phase phase) const {
+        uint64_t sum = 0;
+        for(const auto& thread: threads) {
+            sum += thread.tuples[static_cast<std::size_t>(phase)];
+        }
+        return sum;
+    }
+
+    /**
+     * @brief hardware events of phase summed over all threads
+     */
+    [[nodiscard]] PerfCounts totalEvents(const Phase phase) const {
+        PerfCounts sum;
+        for(const auto& thread: threads) {
+            sum += thread.events[static_cast<std::size_t>(phase)];
+        }
+        return sum;
+    }
+
+    [[nodiscard]] std::string toString() const {
+        std::ostringstream str;
+        str << "threads: " << threads.size() << '\n';
+        for(std::size_t i = 0; i < NUM_PHASES; ++i) {
+            const auto phase = static_cast<Phase>(i);
+            if(totalNanoseconds(phase) == 0 && totalTuples(phase) == 0) {
+                continue;
+            }
+            str << phaseName(phase) << ":\ttotal " << totalNanoseconds(phase) / 1e6 << " ms, slowest thread "
+                << maxNanoseconds(phase) / 1e6 << " ms, imbalance " << imbalance(phase) << ", tuples " << totalTuples(phase);
+            if(const auto events = totalEvents(phase); events.any()) {
+                str << ", " << events.toString();
+            }
+            str << '\n';
+        }
+        if(!partitionSizes.empty()) {
+            std::size_t minSize = SIZE_MAX, maxSize = 0, sum = 0;
+            for(const auto& [cast, title]: partitionSizes) {
+                minSize = std::min(minSize, cast + title);
+                maxSize = std::max(maxSize, cast + title);
+                sum += cast + title;
+            }
+            const auto mean = static_cast<double>(sum) / static_cast<double>(partitionSizes.size());
+            double variance = 0;
+            for(const auto& [cast, title]: partitionSizes) {
+                variance += std::pow(static_cast<double>(cast + title) - mean, 2);
+            }
+            str << "partitions: " << partitionSizes.size() << ", tuples min " << minSize << " avg " << mean << " max " << maxSize
+                << " stddev " << std::sqrt(variance / static_cast<double>(partitionSizes.size())) << '\n';
+        }
+        for(std::size_t i = 0; i < NUM_MEMORY_CATEGORIES; ++i) {
+            const auto& category = memory[i];
+            if(category.allocations == 0) {
+                continue;
+            }
+            str << memoryCategoryName(static_cast<MemoryCategory>(i)) << ":\tallocated " << category.allocatedBytes / 1e6 << " MB in "
+                << category.allocations << " allocations, peak " << category.peakBytes / 1e6 << " MB";
+            if(category.sampledPeakBytes > 0) {
+                str << " (sampled " << category.sampledPeakBytes / 1e6 << " MB)";
+            }
+            str << ", live " << category.liveBytes / 1e6 << " MB\n";
+        }
+        if(hashTables > 0) {
+            str << "hash tables: " << hashTables << ", entries " << hashTableEntries << ", load factor " << hashTableLoadFactor()
+                << ", bytes per entry " << hashTableBytesPerEntry() << '\n';
+        }
+        for(std::size_t i = 0; i < NUM_PHASES; ++i) {
+            if(phaseAllocatedBytes[i] > 0 || phasePeakResidentBytes[i] > 0) {
+                str << phaseName(static_cast<Phase>(i)) << ":\tallocated " << phaseAllocatedBytes[i] / 1e6 << " MB, peak rss "
+                    << phasePeakResidentBytes[i] / 1e6 << " MB\n";
+            }
+        }
+        if(resident.peakBytes > 0) {
+            str << "rss: " << startResident.currentBytes / 1e6 << " MB at start, " << resident.currentBytes / 1e6 << " MB now, peak "
+                << resident.peakBytes / 1e6 << " MB\n";
+        }
+        return str.str();
+    }
+};
+
+/**
+ * @brief collects the counters of all threads of a run. Every thread registers its ThreadCounters on its first
+ * PPDS_PHASE and from then on only touches its own counters, so recording needs no synchronization. reset() and
+ * report() must only be called while no instrumented engine is running.
+ */
+class Instrumentation {
+public:
+    static Instrumentation& get() {
+        static Instrumentation instrumentation;
+        return instrumentation;
+    }
+
+    /**
+     * @brief starts a new run, forgets all counters and partitions
+     * @param countEvents every thread opens its own PerfCounters on its first PPDS_PHASE and every phase reads them
+     * when it begins and ends. Phases run without counts where the counters are not available
+     */
+    void reset(const bool countEvents = false) {
+        std::lock_guard lock(m_threads);
+        this->countEvents = countEvents;
+        ++generation;
+        threads.clear();
+        partitionSizes.clear();
+        sampledPeakBytes.fill(0);
+        phasePeakResidentBytes.fill(0);
+        resetPeakResidentBytes();
+        startResident = readResidentMemory();
+        startTicks = readTimestamp();
+        startTime = std::chrono::steady_clock::now();
+    }
+
+    /**
+     * @brief counters of the calling thread in the current run
+     */
+    ThreadCounters& local() {
+        thread_local ThreadCounters* counters = nullptr;
+        thread_local uint64_t counterGeneration = 0;
+        if(counters == nullptr || counterGeneration != generation.load(std::memory_order_relaxed)) {
+            std::lock_guard lock(m_threads);
+            counters = threads.emplace_back(std::make_unique<ThreadCounters>()).get();
+            counterGeneration = generation.load(std::memory_order_relaxed);
+            if(countEvents) {
+                counters->perf = std::make_unique<PerfCounters>(false);
+                if(!counters->perf->available()) {
+                    counters->perf.reset();
+                }
+            }
+        }
+        return *counters;
+    }
+
+    void recordPartition(const std::size_t castTuples, const std::size_t titleTuples) {
+        std::lock_guard lock(m_threads);
+        partitionSizes.emplace_back(castTuples, titleTuples);
+    }
+
+    /**
+     * @brief a container of category grew or shrank from oldBytes to newBytes, counted as allocating the new buffer
+     * before freeing the old one like a reallocation does
+     */
+    void recordResize(const MemoryCategory category, const std::size_t oldBytes, const std::size_t newBytes) {
+        if(oldBytes == newBytes) {
+            return;
+        }
+        auto& counters = local();
+        if(newBytes > 0) {
+            counters.allocate(category, newBytes);
+        }
+        if(oldBytes > 0) {
+            counters.deallocate(category, oldBytes);
+        }
+    }
+
+    /**
+     * @brief a hash table the calling thread just built, its bytes are the HASH_TABLE bytes the thread holds, so it
+     * must be the only accounted table the thread has
+     */
+    template<typename Map>
+    void recordHashTable(const Map& map) {
+        auto& counters = local();
+        ++counters.hashTables;
+        counters.hashTableEntries += map.size();
+        counters.hashTableBuckets += map.bucket_count();
+        counters.hashTableBytes += static_cast<uint64_t>(std::max<int64_t>(0, counters.liveBytes[static_cast<std::size_t>(MemoryCategory::HASH_TABLE)].load(std::memory_order_relaxed)));
+    }
+
+    /**
+     * @brief takes one memory sample: the live bytes of every category summed over all threads and the resident set
+     * size, which is attributed to every phase a thread is in
+     */
+    void sampleMemory() {
+        const auto rss = readResidentMemory().currentBytes;
+        std::lock_guard lock(m_threads);
+        std::array<int64_t, NUM_MEMORY_CATEGORIES> live{};
+        for(const auto& counters: threads) {
+            for(std::size_t i = 0; i < NUM_MEMORY_CATEGORIES; ++i) {
+                live[i] += counters->liveBytes[i].load(std::memory_order_relaxed);
+            }
+            const auto phase = counters->phase.load(std::memory_order_relaxed);
+            if(phase >= 0) {
+                auto& peak = phasePeakResidentBytes[static_cast<std::size_t>(phase)];
+                peak = std::max(peak, rss);
+            }
+        }
+        for(std::size_t i = 0; i < NUM_MEMORY_CATEGORIES; ++i) {
+            sampledPeakBytes[i] = std::max(sampledPeakBytes[i], live[i]);
+        }
+    }
+
+    /**
+     * @brief report of everything recorded since the last reset, ticks are converted with the tick rate measured
+     * between reset and now
+     */
+    [[nodiscard]] InstrumentationReport report() const {
+        std::lock_guard lock(m_threads);
+        const auto elapsedTicks = static_cast<double>(readTimestamp() - startTicks);
+        const auto elapsedNanoseconds = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count());
+        const auto nanosecondsPerTick = elapsedTicks > 0 ? elapsedNanoseconds / elapsedTicks : 1.0;
+        InstrumentationReport report;
+        for(const auto& counters: threads) {
+            auto& thread = report.threads.emplace_back();
+            for(std::size_t i = 0; i < NUM_PHASES; ++i) {
+                thread.nanoseconds[i] = static_cast<double>(counters->ticks[i]) * nanosecondsPerTick;
+                thread.tuples[i] = counters->tuples[i];
+                thread.events[i] = counters->events[i];
+                report.phaseAllocatedBytes[i] += counters->phaseAllocatedBytes[i];
+            }
+            for(std::size_t i = 0; i < NUM_MEMORY_CATEGORIES; ++i) {
+                report.memory[i].allocatedBytes += counters->allocatedBytes[i];
+                report.memory[i].allocations += counters->allocations[i];
+                report.memory[i].liveBytes += counters->liveBytes[i].load(std::memory_order_relaxed);
+                report.memory[i].peakBytes += counters->peakBytes[i];
+            }
+            report.hashTables += counters->hashTables;
+            report.hashTableEntries += counters->hashTableEntries;
+            report.hashTableBuckets += counters->hashTableBuckets;
+            report.hashTableBytes += counters->hashTableBytes;
+        }
+        for(std::size_t i = 0; i < NUM_MEMORY_CATEGORIES; ++i) {
+            report.memory[i].sampledPeakBytes = sampledPeakBytes[i];
+        }
+        report.partitionSizes = partitionSizes;
+        report.phasePeakResidentBytes = phasePeakResidentBytes;
+        report.startResident = startResident;
+        report.resident = readResidentMemory();
+        return report;
+    }
+
+private:
+    Instrumentation() {
+        reset();
+    }
+
+    mutable std::mutex m_threads;
+    std::vector<std::unique_ptr<ThreadCounters>> threads;
+    std::vector<std::pair<std::size_t, std::size_t>> partitionSizes;
+    std::array<int64_t, NUM_MEMORY_CATEGORIES> sampledPeakBytes{};
+    std::array<uint64_t, NUM_PHASES> phasePeakResidentBytes{};
+    ResidentMemory startResident;
+    std::atomic_uint64_t generation = 0;
+    bool countEvents = false;
+    uint64_t startTicks = 0;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+/**
+ * @brief adds the ticks between construction and destruction and the given number of tuples to phase of the calling
+ * thread, and marks the thread as being in phase for the sampling profiler meanwhile. If the run counts events, the
+ * hardware events in between are added to the phase as well
+ */
+class PhaseScope {
+public:
+    explicit PhaseScope(const Phase phase, const uint64_t tuples = 0)
+        : counters(Instrumentation::get().local()), phase(static_cast<std::size_t>(phase)), previousPhase(currentPhase),
+          startEvents(counters.perf ? counters.perf->read() : PerfCounts{}), start(readTimestamp()) {
+        counters.tuples[this->phase] += tuples;
+        currentPhase = static_cast<std::sig_atomic_t>(phase);
+        counters.phase.store(static_cast<int8_t>(phase), std::memory_order_relaxed);
+    }
+
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+    ~PhaseScope() {
+        counters.ticks[phase] += readTimestamp() - start;
+        if(counters.perf) {
+            counters.events[phase] += counters.perf->read() - startEvents;
+        }
+        currentPhase = previousPhase;
+        counters.phase.store(static_cast<int8_t>(previousPhase), std::memory_order_relaxed);
+    }
+
+private:
+    ThreadCounters& counters;
+    const std::size_t phase;
+    const std::sig_atomic_t previousPhase;
+    const PerfCounts startEvents;
+    const uint64_t start;
+};
+
+/**
+ * @brief calls Instrumentation::sampleMemory every interval while it lives, so the report carries the peak resident
+ * set size of every phase and the sampled peak of every memory category
+ */
+class MemorySampler {
+public:
+    explicit MemorySampler(const std::chrono::microseconds interval = std::chrono::milliseconds(1))
+        : sampler([interval](const std::stop_token& stop) {
+              while(!stop.stop_requested()) {
+                  Instrumentation::get().sampleMemory();
+                  std::this_thread::sleep_for(interval);
+              }
+          }) {}
+
+    MemorySampler(const MemorySampler&) = delete;
+    MemorySampler& operator=(const MemorySampler&) = delete;
+
+    ~MemorySampler() {
+        sampler.request_stop();
+        sampler.join();
+        Instrumentation::get().sampleMemory(); // the end of the run is not missed however long the interval is
+    }
+
+private:
+    std::jthread sampler;
+};
+
+/**
+ * @brief std::allocator that accounts everything it allocates to category and to the phase of the calling thread
+ */
+template<typename T, MemoryCategory category>
+struct CountingAllocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = CountingAllocator<U, category>;
+    };
+
+    CountingAllocator() noexcept = default;
+
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U, category>&) noexcept {}
+
+    T* allocate(const std::size_t n) {
+        Instrumentation::get().local().allocate(category, n * sizeof(T));
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* pointer, const std::size_t n) noexcept {
+        Instrumentation::get().local().deallocate(category, n * sizeof(T));
+        std::allocator<T>().deallocate(pointer, n);
+    }
+
+    template<typename U>
+    bool operator==(const CountingAllocator<U, category>&) const noexcept { return true; }
+};
+
+/**
+ * @brief CountingAllocator in instrumented builds, std::allocator otherwise, so the containers keep their usual type
+ */
+template<typename T, MemoryCategory category>
+using AccountedAllocator = std::conditional_t<PPDS_INSTRUMENTATION, CountingAllocator<T, category>, std::allocator<T>>;
+
+#define PPDS_CONCAT_IMPL(a, b) a##b
+#define PPDS_CONCAT(a, b) PPDS_CONCAT_IMPL(a, b)
+
+#if PPDS_INSTRUMENTATION || PPDS_PROFILER
+#define PPDS_PHASE(phase, tuples) const PhaseScope PPDS_CONCAT(ppdsPhaseScope, __LINE__)(phase, tuples)
+#else
+#define PPDS_PHASE(phase, tuples) static_cast<void>(0)
+#endif
+
+#if PPDS_INSTRUMENTATION
+#define PPDS_PARTITION(castTuples, titleTuples) Instrumentation::get().recordPartition(castTuples, titleTuples)
+#define PPDS_RESIZE(category, oldBytes, newBytes) Instrumentation::get().recordResize(category, oldBytes, newBytes)
+#define PPDS_HASH_TABLE(map) Instrumentation::get().recordHashTable(map)
+#else
+#define PPDS_PARTITION(castTuples, titleTuples) static_cast<void>(0)
+#define PPDS_RESIZE(category, oldBytes, newBytes) static_cast<void>(0)
+#define PPDS_HASH_TABLE(map) static_cast<void>(0)
+#endif
+
+#endif //PPDS_UTIL_INSTRUMENTATION_H
@@ -0,0 +1,271 @@
+#ifndef PPDS_UTIL_JOINBENCHMARK_H
+#define PPDS_UTIL_JOINBENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "DataGenerator.h"
+#include "HardwareInfo.h"
+#include "Instrumentation.h"
+
+/**
+ * Driver of the Benchmark.cpp of every stage, which benchmarks the join engines of the stage end to end on generated
+ * relations. Every (engine, dataset, cast size) is one benchmark, parameterized by the number of threads:
+ *
+ *   ./2_Memory_Hierarchy_BENCHMARK --benchmark_filter='PHJ/zipf' --benchmark_out=results.json --benchmark_out_format=json
+ *
+ * Each benchmark runs JoinBenchmarkConfig::repetitions times, so mean, median, stddev and cv are reported next to the
+ * single runs. tuples/s and ns/tuple count both input relations. Benchmarks are registered dataset by dataset and size
+ * by size, so only the relations of the (dataset, size) that is running are in memory. In builds with
+ * PPDS_INSTRUMENTATION, every benchmark also reports the phases its engine marks with PPDS_PHASE, see addPhaseCounters.
+ */
+
+enum class BenchmarkDataset : uint8_t {
+    UNIFORM = 0, ///< movieIds uniform over the titleIds, every cast tuple matches once
+    ZIPFIAN = 1, ///< movieIds zipf distributed, a few titles get most of the matches
+    MATCH_RATE = 2, ///< only part of the cast tuples find a title
+    ONE_TO_MANY = 3, ///< every titleId exists several times
+    STRINGS = 4, ///< note of cast tuple i equals title of title tuple i, for the string joins
+};
+
+inline const char* benchmarkDatasetName(const BenchmarkDataset dataset) {
+    switch(dataset) {
+        case BenchmarkDataset::UNIFORM: return "uniform";
+        case BenchmarkDataset::ZIPFIAN: return "zipf";
+        case BenchmarkDataset::MATCH_RATE: return "matchrate";
+        case BenchmarkDataset::ONE_TO_MANY: return "onetomany";
+        case BenchmarkDataset::STRINGS: return "strings";
+    }
+    return "unknown";
+}
+
+struct JoinBenchmarkConfig {
+    std::vector<BenchmarkDataset> datasets{BenchmarkDataset::UNIFORM, BenchmarkDataset::ZIPFIAN, BenchmarkDataset::MATCH_RATE, BenchmarkDataset::ONE_TO_MANY};
+    std::vector<std::size_t> castSizes{1 << 14, 1 << 18, 1 << 21};
+    std::size_t titlesPerCast = 4; ///< the title relation has a quarter of the cast tuples
+    double zipfTheta = 0.99;
+    double matchRate = 0.5;
+    std::size_t duplicatesPerTitle = 4;
+    std::size_t stringLength = 20; ///< of note and title in STRINGS
+    uint64_t seed = 42;
+    int repetitions = 5;
+};
+
+template<typename Cast, typename Title>
+struct BenchmarkRelations {
+    std::vector<Cast> cast;
+    std::vector<Title> title;
+    std::vector<Cast> sortedCast; ///< by movieId, only if an engine has sortedInput
+    std::vector<Title> sortedTitle;
+    std::string castPath; ///< cast and title as csv files, only if an engine has fileInput
+    std::string titlePath;
+
+    BenchmarkRelations() = default;
+    BenchmarkRelations(const BenchmarkRelations&) = delete;
+    BenchmarkRelations& operator=(const BenchmarkRelations&) = delete;
+
+    ~BenchmarkRelations() {
+        if(!castPath.empty()) {
+            std::filesystem::remove(castPath);
+            std::filesystem::remove(titlePath);
+        }
+    }
+};
+
+template<typename Cast, typename Title, typename Result>
+struct JoinBenchmarkEngine {
+    const char* name;
+    std::function<std::vector<Result>(const BenchmarkRelations<Cast, Title>&, int)> join;
+    bool multithreaded;
+    bool sortedInput = false; ///< joins sortedCast and sortedTitle
+    bool fileInput = false; ///< reads castPath and titlePath
+    bool consumesInput = false; ///< reorders cast and title, so every iteration gets a fresh copy of them
+};
+
+template<typename Record>
+inline bool writeBenchmarkCsv(const std::string& filepath, const std::vector<Record>& relation, const GeneratorOptions& options) {
+    std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+    file << csvHeader<Record>(options);
+    return writeRows(file, std::span<const Record>(relation), OutputFormat::CSV, options.numThreads);
+}
+
+template<typename Cast, typename Title>
+inline std::unique_ptr<BenchmarkRelations<Cast, Title>> generateBenchmarkRelations(const JoinBenchmarkConfig& config, const BenchmarkDataset dataset,
+                                                                                   const std::size_t castSize, const bool sorted, const bool files) {
+    RelationSpec spec;
+    spec.numCasts = castSize;
+    spec.numTitles = std::max<std::size_t>(1, castSize / std::max<std::size_t>(1, config.titlesPerCast));
+    spec.distribution = dataset == BenchmarkDataset::ZIPFIAN ? KeyDistribution::ZIPFIAN : KeyDistribution::UNIFORM;
+    spec.zipfTheta = config.zipfTheta;
+    spec.matchRate = dataset == BenchmarkDataset::MATCH_RATE ? config.matchRate : 1.0;
+    spec.duplicatesPerKey = dataset == BenchmarkDataset::ONE_TO_MANY ? config.duplicatesPerTitle : 1;
+    if(dataset == BenchmarkDataset::STRINGS) {
+        spec.matchingStrings = true;
+        spec.stringLength = config.stringLength;
+    }
+    spec.seed = config.seed;
+    auto generated = generateRelations<Cast, Title>(spec);
+    auto relations = std::make_unique<BenchmarkRelations<Cast, Title>>();
+    relations->cast = std::move(generated.cast);
+    relations->title = std::move(generated.title);
+    if(sorted) {
+        relations->sortedCast = relations->cast;
+        relations->sortedTitle = relations->title;
+        std::sort(relations->sortedCast.begin(), relations->sortedCast.end(), [](const Cast& a, const Cast& b) {return a.movieId < b.movieId;});
+        std::sort(relations->sortedTitle.begin(), relations->sortedTitle.end(), [](const Title& a, const Title& b) {return a.titleId < b.titleId;});
+    }
+    if(files) {
+        const auto prefix = (std::filesystem::temp_directory_path() / ("ppds_benchmark_" + std::to_string(getpid()) + "_")).string();
+        GeneratorOptions options;
+        options.stringKeys = spec.matchingStrings;
+        if(writeBenchmarkCsv(prefix + "cast_info.csv", relations->cast, options) && writeBenchmarkCsv(prefix + "title.csv", relations->title, options)) {
+            relations->castPath = prefix + "cast_info.csv";
+            relations->titlePath = prefix + "title.csv";
+        }
+    }
+    return relations;
+}
+
+/**
+ * @brief the relations of one (dataset, size). Only the last requested ones are kept, the previous ones are freed
+ * before new ones are generated
+ */
+template<typename Cast, typename Title>
+inline const BenchmarkRelations<Cast, Title>& benchmarkRelationsFor(const JoinBenchmarkConfig& config, const BenchmarkDataset dataset,
+                                                                    const std::size_t castSize, const bool sorted, const bool files) {
+    static std::unique_ptr<BenchmarkRelations<Cast, Title>> current;
+    static std::pair<BenchmarkDataset, std::size_t> currentKey;
+    if(!current || currentKey != std::make_pair(dataset, castSize)) {
+        current.reset();
+        current = generateBenchmarkRelations<Cast, Title>(config, dataset, castSize, sorted, files);
+        currentKey = {dataset, castSize};
+    }
+    return *current;
+}
+
+#if PPDS_INSTRUMENTATION
+/**
+ * @brief runs join once more outside of the timed iterations, with Instrumentation counting the hardware events of
+ * every phase, and reports ns, cycles and LLC misses per tuple of every phase the engine marked with PPDS_PHASE,
+ * e.g. probe_ns/tuple. Tuples are the ones the engine passed to PPDS_PHASE
+ */
+template<typename Join>
+inline void addPhaseCounters(benchmark::State& state, Join&& join) {
+    Instrumentation::get().reset(true);
+    join();
+    const auto report = Instrumentation::get().report();
+    for(std::size_t i = 0; i < NUM_PHASES; ++i) {
+        const auto phase = static_cast<Phase>(i);
+        const auto tuples = static_cast<double>(report.totalTuples(phase));
+        if(tuples == 0) {
+            continue;
+        }
+        const auto name = std::string(phaseName(phase));
+        state.counters[name + "_ns/tuple"] = report.totalNanoseconds(phase) / tuples;
+        const auto events = report.totalEvents(phase);
+        if(events.valid[static_cast<std::size_t>(PerfEvent::CYCLES)]) {
+            state.counters[name + "_cycles/tuple"] = static_cast<double>(events[PerfEvent::CYCLES]) / tuples;
+        }
+        if(events.valid[static_cast<std::size_t>(PerfEvent::LLC_MISSES)]) {
+            state.counters[name + "_LLC-misses/tuple"] = static_cast<double>(events[PerfEvent::LLC_MISSES]) / tuples;
+        }
+    }
+}
+#endif
+
+/**
+ * @brief registers every engine on every dataset and size of config, runs the benchmarks selected on the command line
+ * and returns the exit code of main
+ */
+template<typename Cast, typename Title, typename Result>
+inline int runJoinBenchmarks(int argc, char** argv, const std::vector<JoinBenchmarkEngine<Cast, Title, Result>>& engines,
+                             const JoinBenchmarkConfig& config = {}) {
+    std::vector<int64_t> threadCounts;
+    for(int64_t threads = 1; threads < std::jthread::hardware_concurrency(); threads *= 2) {
+        threadCounts.emplace_back(threads);
+    }
+    threadCounts.emplace_back(std::max(1u, std::jthread::hardware_concurrency()));
+    threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+    const bool sorted = std::any_of(engines.begin(), engines.end(), [](const auto& engine) {return engine.sortedInput;});
+    const bool files = std::any_of(engines.begin(), engines.end(), [](const auto& engine) {return engine.fileInput;});
+
+    for(const auto dataset: config.datasets) {
+        for(const auto castSize: config.castSizes) {
+            for(const auto& engine: engines) {
+                const auto name = std::string(engine.name) + "/" + benchmarkDatasetName(dataset);
+                auto* registered = benchmark::RegisterBenchmark(name.c_str(), [&engine, &config, dataset, sorted, files](benchmark::State& state) {
+                    const auto castSize = static_cast<std::size_t>(state.range(0));
+                    const auto numThreads = static_cast<int>(state.range(1));
+                    const auto& relations = benchmarkRelationsFor<Cast, Title>(config, dataset, castSize, sorted, files);
+                    if(engine.fileInput && relations.castPath.empty()) {
+                        state.SkipWithError("could not write the relations as csv");
+                        return;
+                    }
+                    BenchmarkRelations<Cast, Title> scratch;
+                    std::size_t numResults = 0;
+                    double joinNs = 0; // without the copies of consumesInput, which run with the timer paused
+                    for(auto _ : state) {
+                        if(engine.consumesInput) {
+                            state.PauseTiming();
+                            scratch.cast = relations.cast;
+                            scratch.title = relations.title;
+                            state.ResumeTiming();
+                        }
+                        const auto start = std::chrono::steady_clock::now();
+                        {
+                            auto results = engine.join(engine.consumesInput ? scratch : relations, numThreads);
+                            numResults = results.size();
+                            benchmark::DoNotOptimize(results.data());
+                            benchmark::ClobberMemory();
+                        }
+                        joinNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                    }
+                    const auto tuples = static_cast<double>(relations.cast.size() + relations.title.size());
+                    state.counters["tuples/s"] = benchmark::Counter(tuples, benchmark::Counter::kIsIterationInvariantRate);
+                    state.counters["ns/tuple"] = joinNs / (tuples * static_cast<double>(std::max<benchmark::IterationCount>(1, state.iterations())));
+                    state.counters["results"] = static_cast<double>(numResults);
+#if PPDS_INSTRUMENTATION
+                    addPhaseCounters(state, [&] {
+                        if(engine.consumesInput) {
+                            scratch.cast = relations.cast;
+                            scratch.title = relations.title;
+                        }
+                        benchmark::DoNotOptimize(engine.join(engine.consumesInput ? scratch : relations, numThreads).data());
+                    });
+#endif
+                });
+                for(const auto threads: engine.multithreaded ? threadCounts : std::vector<int64_t>{1}) {
+                    registered->Args({static_cast<int64_t>(castSize), threads});
+                }
+                registered->ArgNames({"tuples", "threads"})
+                        ->Repetitions(config.repetitions)
+                        ->UseRealTime()
+                        ->Unit(benchmark::kMillisecond);
+            }
+        }
+    }
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::AddCustomContext("cpu", HardwareInfo::get().cpuName());
+    benchmark::AddCustomContext("l2_cache_size", std::to_string(HardwareInfo::get().l2CacheSize()));
+    benchmark::AddCustomContext("l3_cache_size", std::to_string(HardwareInfo::get().l3CacheSize()));
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
+
+#endif //PPDS_UTIL_JOINBENCHMARK_H
@@ -0,0 +1,120 @@
+#ifndef PPDS_UTIL_MICROBENCHMARK_H
+#define PPDS_UTIL_MICROBENCHMARK_H
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "HardwareInfo.h"
+
+/**
+ * Helpers of the MicroBenchmark.cpp of every stage, which benchmark single primitives over synthetic keys. Every
+ * primitive is swept over working sets from a quarter of L1 up to several times L3, with two points around every
+ * cache level, so the throughput curve shows where the primitive falls out of each level. Points whose whole
+ * footprint would take more than a quarter of the physical memory are left out.
+ */
+
+/**
+ * @brief working set sizes in bytes: half of and slightly above every cache level, and twice and four times L3
+ */
+inline std::vector<std::size_t> workingSetBytes() {
+    const auto& hardware = HardwareInfo::get();
+    std::vector<std::size_t> bytes{hardware.l1CacheSize() / 4};
+    for(const auto cache: {hardware.l1CacheSize(), hardware.l2CacheSize(), hardware.l3CacheSize()}) {
+        bytes.emplace_back(cache / 2);
+        bytes.emplace_back(cache + cache / 4);
+    }
+    bytes.emplace_back(2 * hardware.l3CacheSize());
+    bytes.emplace_back(4 * hardware.l3CacheSize());
+    std::sort(bytes.begin(), bytes.end());
+    bytes.erase(std::unique(bytes.begin(), bytes.end()), bytes.end());
+    return bytes;
+}
+
+inline std::size_t memoryBudget() {
+    const auto pages = sysconf(_SC_PHYS_PAGES);
+    const auto pageSize = sysconf(_SC_PAGESIZE);
+    return pages > 0 && pageSize > 0 ? static_cast<std::size_t>(pages) * static_cast<std::size_t>(pageSize) / 4 : SIZE_MAX;
+}
+
+/**
+ * @brief the working sets as numbers of elements of elementBytes each, at least minElements. footprintBytes is
+ * what one element costs in total, including input that is not part of the working set
+ */
+inline std::vector<int64_t> workingSetElements(const std::size_t elementBytes, const std::size_t footprintBytes = 0, const int64_t minElements = 16) {
+    std::vector<int64_t> elements;
+    const auto budget = memoryBudget();
+    for(const auto bytes: workingSetBytes()) {
+        const auto n = std::max<int64_t>(minElements, static_cast<int64_t>(bytes / std::max<std::size_t>(1, elementBytes)));
+        if(static_cast<std::size_t>(n) * std::max(elementBytes, footprintBytes) <= budget) {
+            elements.emplace_back(n);
+        }
+    }
+    elements.erase(std::unique(elements.begin(), elements.end()), elements.end());
+    return elements;
+}
+
+/**
+ * @brief smallest cache level the working set fits into, "DRAM" if none
+ */
+inline const char* cacheLevelOf(const std::size_t bytes) {
+    const auto& hardware = HardwareInfo::get();
+    if(bytes <= hardware.l1CacheSize()) return "L1";
+    if(bytes <= hardware.l2CacheSize()) return "L2";
+    if(bytes <= hardware.l3CacheSize()) return "L3";
+    return "DRAM";
+}
+
+/**
+ * @brief reports the working set of a benchmark as counter and the cache level it fits into as label
+ */
+inline void setWorkingSet(benchmark::State& state, const std::size_t bytes) {
+    state.counters["working_set"] = benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kDefaults, benchmark::Counter::kIs1024);
+    state.SetLabel(cacheLevelOf(bytes));
+}
+
+/**
+ * @brief n keys uniform over [0, numKeys)
+ */
+inline std::vector<int32_t> uniformKeys(const std::size_t n, const int32_t numKeys, const uint64_t seed = 42) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int32_t> distribution(0, std::max(1, numKeys) - 1);
+    std::vector<int32_t> keys(n);
+    for(auto& key: keys) {
+        key = distribution(rng);
+    }
+    return keys;
+}
+
+/**
+ * @brief n random lower case strings of length characters
+ */
+inline std::vector<std::string> randomStrings(const std::size_t n, const std::size_t length, const uint64_t seed = 42) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int> distribution('a', 'z');
+    std::vector<std::string> strings(n, std::string(length, ' '));
+    for(auto& string: strings) {
+        for(auto& c: string) {
+            c = static_cast<char>(distribution(rng));
+        }
+    }
+    return strings;
+}
+
+/**
+ * @brief adds the cache sizes the sweeps are based on to the benchmark context
+ */
+inline void addCacheContext() {
+    const auto& hardware = HardwareInfo::get();
+    benchmark::AddCustomContext("cpu", hardware.cpuName());
+    benchmark::AddCustomContext("l1_cache_size", std::to_string(hardware.l1CacheSize()));
+    benchmark::AddCustomContext("l2_cache_size", std::to_string(hardware.l2CacheSize()));
+    benchmark::AddCustomContext("l3_cache_size", std::to_string(hardware.l3CacheSize()));
+}
+
+#endif //PPDS_UTIL_MICROBENCHMARK_H
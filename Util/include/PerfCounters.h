@@ -0,0 +1,166 @@
+#ifndef PPDS_UTIL_PERFCOUNTERS_H
+#define PPDS_UTIL_PERFCOUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief hardware events counted by PerfCounters
+ */
+enum class PerfEvent : uint8_t {
+    CYCLES = 0,
+    INSTRUCTIONS = 1,
+    LLC_MISSES = 2,
+    DTLB_MISSES = 3, ///< data TLB load misses
+    BRANCH_MISSES = 4,
+};
+
+static constexpr const std::size_t NUM_PERF_EVENTS = 5;
+
+/**
+ * @brief a set of event counts, events that could not be counted are marked invalid and printed as n/a
+ */
+struct PerfCounts {
+    std::array<uint64_t, NUM_PERF_EVENTS> values{};
+    std::array<bool, NUM_PERF_EVENTS> valid{};
+
+    [[nodiscard]] bool any() const {
+        for(const bool v: valid) {
+            if(v) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] uint64_t operator[](const PerfEvent event) const { return values[static_cast<std::size_t>(event)]; }
+
+    PerfCounts& operator+=(const PerfCounts& other) {
+        for(std::size_t i = 0; i < NUM_PERF_EVENTS; ++i) {
+            if(other.valid[i]) {
+                values[i] = (valid[i] ? values[i] : 0) + other.values[i];
+                valid[i] = true;
+            }
+        }
+        return *this;
+    }
+
+    /**
+     * @brief counts between an earlier reading and this one
+     */
+    [[nodiscard]] PerfCounts operator-(const PerfCounts& earlier) const {
+        PerfCounts delta;
+        for(std::size_t i = 0; i < NUM_PERF_EVENTS; ++i) {
+            delta.valid[i] = valid[i] && earlier.valid[i];
+            delta.values[i] = delta.valid[i] && values[i] > earlier.values[i] ? values[i] - earlier.values[i] : 0;
+        }
+        return delta;
+    }
+
+    [[nodiscard]] std::string toString() const {
+        static constexpr const char* NAMES[NUM_PERF_EVENTS] = {"cycles", "instructions", "LLC-misses", "dTLB-misses", "branch-misses"};
+        std::ostringstream str;
+        for(std::size_t i = 0; i < NUM_PERF_EVENTS; ++i) {
+            str << (i == 0 ? "" : ", ") << NAMES[i] << '=';
+            if(valid[i]) {
+                str << values[i];
+            } else {
+                str << "n/a";
+            }
+        }
+        if(valid[0] && valid[1] && values[0] > 0) {
+            str << ", IPC=" << static_cast<double>(values[1]) / static_cast<double>(values[0]);
+        }
+        return str.str();
+    }
+};
+
+/**
+ * @brief cycles, instructions, LLC misses, dTLB misses and branch misses of the calling thread, read with
+ * perf_event_open. With inherit the counts include every thread the calling thread starts afterwards, once that
+ * thread has exited (jthreads of an engine, not an already running OpenMP pool). Events the kernel or the machine does
+ * not support, e.g. in a VM or with a restrictive /proc/sys/kernel/perf_event_paranoid, stay invalid and everything
+ * else keeps working. Setting PPDS_PERF_COUNTERS=0 disables counting.
+ */
+class PerfCounters {
+public:
+    explicit PerfCounters(const bool inherit = true) {
+        fds.fill(-1);
+        const char* enabled = std::getenv("PPDS_PERF_COUNTERS");
+        if(enabled != nullptr && std::strcmp(enabled, "0") == 0) {
+            return;
+        }
+        static constexpr std::pair<uint32_t, uint64_t> EVENTS[NUM_PERF_EVENTS] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        };
+        for(std::size_t i = 0; i < NUM_PERF_EVENTS; ++i) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = EVENTS[i].first;
+            attr.config = EVENTS[i].second;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.inherit = inherit ? 1 : 0;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+        for(const int fd: fds) {
+            if(fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    [[nodiscard]] bool available() const {
+        for(const int fd: fds) {
+            if(fd >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief current totals since construction, scaled up if the kernel had to multiplex the counters
+     */
+    [[nodiscard]] PerfCounts read() const {
+        PerfCounts counts;
+        for(std::size_t i = 0; i < NUM_PERF_EVENTS; ++i) {
+            if(fds[i] < 0) {
+                continue;
+            }
+            uint64_t data[3]; // value, time enabled, time running
+            if(::read(fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+                continue;
+            }
+            counts.valid[i] = true;
+            counts.values[i] = data[2] > 0 && data[2] < data[1]
+                ? static_cast<uint64_t>(static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]))
+                : data[0];
+        }
+        return counts;
+    }
+
+private:
+    std::array<int, NUM_PERF_EVENTS> fds{};
+};
+
+#endif //PPDS_UTIL_PERFCOUNTERS_H
@@ -0,0 +1,288 @@
+#ifndef PPDS_UTIL_SAMPLINGPROFILER_H
+#define PPDS_UTIL_SAMPLINGPROFILER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <sys/time.h>
+#include <ucontext.h>
+
+#include "Instrumentation.h"
+
+/**
+ * @brief settings of one profiling session
+ */
+struct ProfilerOptions {
+    int frequency = 999; ///< samples per second of cpu time, odd so it does not run in lockstep with periodic work
+    std::size_t maxThreads = 0; ///< threads that get a sample buffer, 0 is four per hardware thread
+    std::size_t samplesPerThread = 1 << 15; ///< only touched pages of the buffers become resident
+};
+
+/**
+ * @brief samples the call stacks of all threads of the process with SIGPROF every 1/frequency seconds of consumed cpu
+ * time and attributes every sample to the PPDS_PHASE the thread was in. Each thread claims its own preallocated
+ * buffer on its first sample, so the signal handler neither locks nor allocates. Stacks are symbolized only when the
+ * folded output is written, with dladdr, which sees the functions of the executable if it is linked with
+ * -rdynamic (cmake -DPPDS_PROFILER=ON does that). Feed the output to flamegraph.pl or speedscope:
+ *
+ *   SamplingProfiler::get().start();
+ *   performPartitionJoin(castRelation, titleRelation, numThreads);
+ *   SamplingProfiler::get().stop();
+ *   SamplingProfiler::get().writeFolded("join.folded");
+ *
+ * Only one session runs at a time and start and stop must not race with each other.
+ */
+class SamplingProfiler {
+public:
+    static constexpr const std::size_t MAX_FRAMES = 48;
+
+    static SamplingProfiler& get() {
+        static SamplingProfiler profiler;
+        return profiler;
+    }
+
+    /**
+     * @brief forgets the previous session and starts sampling, false if the timer or handler could not be installed
+     */
+    bool start(const ProfilerOptions& options = {}) {
+        if(running.load() || options.frequency <= 0) {
+            return false;
+        }
+        void* warmup[1];
+        backtrace(warmup, 1); // loads the unwinder now, the first backtrace allocates and must not happen in the handler
+        numBuffers = options.maxThreads > 0 ? options.maxThreads : 4 * std::max(1u, std::thread::hardware_concurrency());
+        capacity = std::max<std::size_t>(1, options.samplesPerThread);
+        buffers = std::make_unique<SampleBuffer[]>(numBuffers);
+        for(std::size_t i = 0; i < numBuffers; ++i) {
+            buffers[i].samples = std::make_unique_for_overwrite<Sample[]>(capacity);
+        }
+        nextBuffer.store(0);
+        dropped.store(0);
+        generation.fetch_add(1);
+
+        struct sigaction action{};
+        action.sa_sigaction = &SamplingProfiler::onSignal;
+        action.sa_flags = SA_RESTART | SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+        if(sigaction(SIGPROF, &action, &previousAction) != 0) {
+            return false;
+        }
+        running.store(true);
+        const auto interval = std::max<long>(1, 1000000L / options.frequency);
+        itimerval timer{{interval / 1000000, interval % 1000000}, {interval / 1000000, interval % 1000000}};
+        if(setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+            running.store(false);
+            sigaction(SIGPROF, &previousAction, nullptr);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief stops sampling, the samples stay available until the next start
+     */
+    void stop() {
+        if(!running.load()) {
+            return;
+        }
+        itimerval timer{};
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        running.store(false);
+        // a SIGPROF that is still pending finds running false and leaves the buffers alone
+        sigaction(SIGPROF, &previousAction, nullptr);
+    }
+
+    [[nodiscard]] bool isRunning() const { return running.load(); }
+
+    [[nodiscard]] std::size_t samples() const {
+        std::size_t sum = 0;
+        forEachSample([&sum](const Sample&) { ++sum; });
+        return sum;
+    }
+
+    /**
+     * @brief samples taken while a thread was in phase
+     */
+    [[nodiscard]] std::size_t samples(const Phase phase) const {
+        std::size_t sum = 0;
+        forEachSample([&sum, phase](const Sample& sample) { sum += sample.phase == static_cast<int8_t>(phase); });
+        return sum;
+    }
+
+    /**
+     * @brief samples lost because a buffer was full or more threads than maxThreads were sampled
+     */
+    [[nodiscard]] std::size_t droppedSamples() const { return dropped.load(); }
+
+    /**
+     * @brief one line per distinct stack, "[phase];outermost;...;innermost count", the phase is "[none]" for samples
+     * outside of any PPDS_PHASE
+     */
+    [[nodiscard]] std::string folded() const {
+        std::unordered_map<void*, std::string> symbols;
+        const auto symbol = [&symbols](void* address) -> const std::string& {
+            auto it = symbols.find(address);
+            if(it == symbols.end()) {
+                it = symbols.emplace(address, symbolize(address)).first;
+            }
+            return it->second;
+        };
+        std::map<std::string, std::size_t> stacks;
+        forEachSample([&](const Sample& sample) {
+            std::string stack = sample.phase >= 0 ? std::string("[") + phaseName(static_cast<Phase>(sample.phase)) + "]" : "[none]";
+            for(std::size_t i = sample.depth; i > 0; --i) {
+                // return addresses point behind the call, step back into it so inlined callers resolve correctly
+                const auto address = reinterpret_cast<uintptr_t>(sample.frames[i - 1]) - (i > 1 ? 1 : 0);
+                stack += ';';
+                stack += symbol(reinterpret_cast<void*>(address));
+            }
+            ++stacks[stack];
+        });
+        std::ostringstream str;
+        for(const auto& [stack, count]: stacks) {
+            str << stack << ' ' << count << '\n';
+        }
+        return str.str();
+    }
+
+    bool writeFolded(const std::string& filepath) const {
+        std::ofstream file(filepath);
+        file << folded();
+        return static_cast<bool>(file);
+    }
+
+private:
+    struct Sample {
+        void* frames[MAX_FRAMES]; ///< innermost first
+        uint8_t depth;
+        int8_t phase;
+    };
+
+    struct SampleBuffer {
+        std::unique_ptr<Sample[]> samples;
+        std::atomic_size_t size = 0; ///< published with release after the sample is complete
+    };
+
+    SamplingProfiler() = default;
+
+    static void onSignal(int, siginfo_t*, void* context) {
+        const int savedErrno = errno;
+        auto& profiler = get();
+        if(profiler.running.load(std::memory_order_acquire)) {
+            profiler.record(interruptedAddress(context));
+        }
+        errno = savedErrno;
+    }
+
+    /**
+     * @brief instruction the thread was interrupted at, nullptr where the context layout is unknown
+     */
+    static void* interruptedAddress(void* context) {
+        const auto* ucontext = static_cast<const ucontext_t*>(context);
+#if defined(__x86_64__)
+        return reinterpret_cast<void*>(ucontext->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__aarch64__)
+        return reinterpret_cast<void*>(ucontext->uc_mcontext.pc);
+#else
+        static_cast<void>(ucontext);
+        return nullptr;
+#endif
+    }
+
+    void record(void* interrupted) {
+        thread_local SampleBuffer* buffer = nullptr;
+        thread_local uint64_t bufferGeneration = 0;
+        const auto current = generation.load(std::memory_order_relaxed);
+        if(bufferGeneration != current) {
+            const auto index = nextBuffer.fetch_add(1, std::memory_order_relaxed);
+            buffer = index < numBuffers ? &buffers[index] : nullptr;
+            bufferGeneration = current;
+        }
+        const auto size = buffer != nullptr ? buffer->size.load(std::memory_order_relaxed) : capacity;
+        if(size >= capacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // the innermost frames belong to the handler and the signal trampoline, the stack of the thread starts at the
+        // interrupted instruction. How many handler frames there are depends on inlining, so look for it
+        void* frames[MAX_FRAMES + HANDLER_FRAMES];
+        const auto depth = static_cast<std::size_t>(std::max(0, backtrace(frames, static_cast<int>(MAX_FRAMES + HANDLER_FRAMES))));
+        std::size_t first = std::min(depth, HANDLER_FRAMES - 1);
+        for(std::size_t i = 0; i < std::min(depth, HANDLER_FRAMES); ++i) {
+            if(frames[i] == interrupted) {
+                first = i;
+                break;
+            }
+        }
+        auto& sample = buffer->samples[size];
+        sample.depth = static_cast<uint8_t>(std::min(depth - first, MAX_FRAMES));
+        std::memcpy(sample.frames, frames + first, sample.depth * sizeof(void*));
+        sample.phase = static_cast<int8_t>(currentPhase);
+        buffer->size.store(size + 1, std::memory_order_release);
+    }
+
+    template<typename F>
+    void forEachSample(F&& f) const {
+        const auto used = std::min(nextBuffer.load(std::memory_order_acquire), numBuffers);
+        for(std::size_t i = 0; i < used; ++i) {
+            const auto size = buffers[i].size.load(std::memory_order_acquire);
+            for(std::size_t j = 0; j < size; ++j) {
+                f(buffers[i].samples[j]);
+            }
+        }
+    }
+
+    /**
+     * @brief demangled function name, module+offset where dladdr knows no symbol
+     */
+    static std::string symbolize(void* address) {
+        Dl_info info{};
+        std::string name;
+        if(dladdr(address, &info) != 0 && info.dli_sname != nullptr) {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            name = status == 0 && demangled != nullptr ? demangled : info.dli_sname;
+            std::free(demangled);
+        } else {
+            std::ostringstream str;
+            if(info.dli_fname != nullptr) {
+                const char* slash = std::strrchr(info.dli_fname, '/');
+                str << (slash != nullptr ? slash + 1 : info.dli_fname) << "+0x" << std::hex
+                    << reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_fbase);
+            } else {
+                str << "0x" << std::hex << reinterpret_cast<uintptr_t>(address);
+            }
+            name = str.str();
+        }
+        std::replace(name.begin(), name.end(), ';', ':'); // ';' separates the frames of a folded stack
+        return name;
+    }
+
+    static constexpr const std::size_t HANDLER_FRAMES = 4; ///< record, onSignal, the trampoline and one spare
+
+    std::atomic_bool running = false;
+    std::atomic_uint64_t generation = 0;
+    std::atomic_size_t nextBuffer = 0;
+    std::atomic_size_t dropped = 0;
+    std::unique_ptr<SampleBuffer[]> buffers;
+    std::size_t numBuffers = 0;
+    std::size_t capacity = 0;
+    struct sigaction previousAction{};
+};
+
+#endif //PPDS_UTIL_SAMPLINGPROFILER_H
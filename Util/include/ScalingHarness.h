@@ -0,0 +1,225 @@
+#ifndef PPDS_UTIL_SCALINGHARNESS_H
+#define PPDS_UTIL_SCALINGHARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <sched.h>
+#include <omp.h>
+
+#include "Topology.h"
+
+inline const char* affinityPolicyName(const AffinityPolicy policy) {
+    switch(policy) {
+        case AffinityPolicy::NONE: return "none";
+        case AffinityPolicy::COMPACT: return "compact";
+        case AffinityPolicy::SCATTER: return "scatter";
+        case AffinityPolicy::PHYSICAL_CORES: return "physical_cores";
+    }
+    return "unknown";
+}
+
+struct ScalingConfig {
+    std::vector<int> threadCounts; ///< empty sweeps 1..hardware_concurrency
+    std::vector<AffinityPolicy> policies{AffinityPolicy::NONE};
+    int warmups = 1; ///< unmeasured runs before every thread count
+    int repetitions = 5;
+};
+
+/**
+ * @brief one engine at one thread count and affinity policy. speedup, efficiency and the Karp-Flatt serial fraction
+ * are relative to the smallest thread count of the same engine and policy and use the medians
+ */
+struct ScalingPoint {
+    std::string engine;
+    AffinityPolicy policy; ///< requested, see pinned
+    bool pinned; ///< whether the threads actually ran on the cpus of policy, unpinned points are reported as "none"
+    int threads;
+    std::vector<double> runtimesMs;
+    double medianMs;
+    double meanMs;
+    double stddevMs;
+    double speedup;
+    double efficiency;
+    double karpFlatt; ///< experimentally determined serial fraction, 0 for the baseline
+};
+
+/**
+ * @brief measures how engines scale with the number of threads. For every policy other than NONE the calling thread
+ * and the OpenMP pool are restricted to the cpus Topology::cpuOrder picks for the thread count while the engine runs,
+ * and threads the engine starts itself inherit that placement. Where the placement fails, the point is reported as
+ * policy "none".
+ */
+class ScalingHarness {
+public:
+    explicit ScalingHarness(ScalingConfig config) : config(std::move(config)) {
+        if(this->config.threadCounts.empty()) {
+            for(int threads = 1; threads <= static_cast<int>(std::max(1u, std::thread::hardware_concurrency())); ++threads) {
+                this->config.threadCounts.emplace_back(threads);
+            }
+        }
+        std::sort(this->config.threadCounts.begin(), this->config.threadCounts.end());
+    }
+
+    /**
+     * @brief sweeps all thread counts and policies, join(threads) runs the engine once
+     */
+    void run(const std::string& engine, const std::function<void(int)>& join) {
+        for(const auto policy: config.policies) {
+            const auto baseline = points.size();
+            for(const int threads: config.threadCounts) {
+                const PlacementGuard placement(policy, threads);
+                ScalingPoint point{engine, policy, placement.isPinned(), threads, {}, 0, 0, 0, 1, 1, 0};
+                for(int i = 0; i < config.warmups; ++i) {
+                    join(threads);
+                }
+                for(int i = 0; i < config.repetitions; ++i) {
+                    const auto start = std::chrono::steady_clock::now();
+                    join(threads);
+                    point.runtimesMs.emplace_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                }
+                summarize(point, points.size() > baseline ? &points[baseline] : nullptr);
+                points.emplace_back(std::move(point));
+            }
+        }
+    }
+
+    [[nodiscard]] const std::vector<ScalingPoint>& results() const { return points; }
+
+    void print(std::ostream& out = std::cout) const {
+        out << std::left << std::setw(24) << "engine" << std::setw(16) << "policy" << std::setw(9) << "threads"
+            << std::setw(14) << "median [ms]" << std::setw(14) << "stddev [ms]" << std::setw(10) << "speedup"
+            << std::setw(12) << "efficiency" << "karp-flatt" << '\n';
+        for(const auto& point: points) {
+            out << std::setw(24) << point.engine << std::setw(16) << placementName(point) << std::setw(9) << point.threads
+                << std::setw(14) << point.medianMs << std::setw(14) << point.stddevMs << std::setw(10) << point.speedup
+                << std::setw(12) << point.efficiency << point.karpFlatt << '\n';
+        }
+        out << std::right << std::flush;
+    }
+
+    bool writeCsv(const std::string& filepath) const {
+        std::ofstream file(filepath);
+        file << "engine,policy,threads,repetitions,median_ms,mean_ms,stddev_ms,speedup,efficiency,karp_flatt\n";
+        for(const auto& point: points) {
+            file << point.engine << ',' << placementName(point) << ',' << point.threads << ',' << point.runtimesMs.size() << ','
+                 << point.medianMs << ',' << point.meanMs << ',' << point.stddevMs << ',' << point.speedup << ','
+                 << point.efficiency << ',' << point.karpFlatt << '\n';
+        }
+        return static_cast<bool>(file);
+    }
+
+    bool writeJson(const std::string& filepath) const {
+        std::ofstream file(filepath);
+        file << "[\n";
+        for(std::size_t i = 0; i < points.size(); ++i) {
+            const auto& point = points[i];
+            file << "  {\"engine\": \"" << point.engine << "\", \"policy\": \"" << placementName(point)
+                 << "\", \"threads\": " << point.threads << ", \"runtimes_ms\": [";
+            for(std::size_t run = 0; run < point.runtimesMs.size(); ++run) {
+                file << (run == 0 ? "" : ", ") << point.runtimesMs[run];
+            }
+            file << "], \"median_ms\": " << point.medianMs << ", \"mean_ms\": " << point.meanMs << ", \"stddev_ms\": " << point.stddevMs
+                 << ", \"speedup\": " << point.speedup << ", \"efficiency\": " << point.efficiency
+                 << ", \"karp_flatt\": " << point.karpFlatt << '}' << (i + 1 < points.size() ? "," : "") << '\n';
+        }
+        file << "]\n";
+        return static_cast<bool>(file);
+    }
+
+private:
+    static const char* placementName(const ScalingPoint& point) {
+        return point.pinned ? affinityPolicyName(point.policy) : affinityPolicyName(AffinityPolicy::NONE);
+    }
+
+    /**
+     * @brief restricts the calling thread and the threads of the OpenMP pool of a team of threads to the cpus of policy
+     * for its lifetime. The pool is reused by every parallel region of that size, so the engines' regions run on the
+     * same cpus, and threads that are started later inherit the mask of the calling thread
+     */
+    class PlacementGuard {
+    public:
+        PlacementGuard(const AffinityPolicy policy, const int threads) : threads(threads), previous(static_cast<std::size_t>(std::max(1, threads))) {
+            const auto cpus = Topology::get().cpuOrder(policy, static_cast<std::size_t>(threads));
+            if(cpus.empty()) {
+                return;
+            }
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for(const int cpu: cpus) {
+                CPU_SET(cpu, &set);
+            }
+            int failed = 0;
+            #pragma omp parallel num_threads(threads) reduction(+:failed)
+            {
+                auto& [mask, saved] = previous[static_cast<std::size_t>(omp_get_thread_num())];
+                saved = sched_getaffinity(0, sizeof(mask), &mask) == 0 && sched_setaffinity(0, sizeof(set), &set) == 0;
+                failed += !saved;
+            }
+            pinned = failed == 0;
+        }
+
+        PlacementGuard(const PlacementGuard&) = delete;
+        PlacementGuard& operator=(const PlacementGuard&) = delete;
+
+        ~PlacementGuard() {
+            #pragma omp parallel num_threads(threads)
+            {
+                const auto& [mask, saved] = previous[static_cast<std::size_t>(omp_get_thread_num())];
+                if(saved) {
+                    sched_setaffinity(0, sizeof(mask), &mask);
+                }
+            }
+        }
+
+        /**
+         * @brief whether every thread of the team runs on the cpus of the policy, false for AffinityPolicy::NONE
+         */
+        [[nodiscard]] bool isPinned() const { return pinned; }
+
+    private:
+        int threads;
+        std::vector<std::pair<cpu_set_t, bool>> previous; ///< mask of every thread of the team and whether it was replaced
+        bool pinned = false;
+    };
+
+    static void summarize(ScalingPoint& point, const ScalingPoint* baseline) {
+        auto sorted = point.runtimesMs;
+        std::sort(sorted.begin(), sorted.end());
+        if(sorted.empty()) {
+            return;
+        }
+        point.medianMs = sorted.size() % 2 == 1 ? sorted[sorted.size() / 2] : (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2;
+        double sum = 0;
+        for(const auto runtime: sorted) {
+            sum += runtime;
+        }
+        point.meanMs = sum / static_cast<double>(sorted.size());
+        double variance = 0;
+        for(const auto runtime: sorted) {
+            variance += (runtime - point.meanMs) * (runtime - point.meanMs);
+        }
+        point.stddevMs = sorted.size() > 1 ? std::sqrt(variance / static_cast<double>(sorted.size() - 1)) : 0;
+        if(baseline == nullptr || point.medianMs <= 0) {
+            return;
+        }
+        // relative to the baseline's thread count, so a sweep that does not start at 1 thread is still meaningful
+        const auto p = static_cast<double>(point.threads) / static_cast<double>(baseline->threads);
+        point.speedup = baseline->medianMs / point.medianMs;
+        point.efficiency = point.speedup / p;
+        point.karpFlatt = p > 1 ? (1 / point.speedup - 1 / p) / (1 - 1 / p) : 0;
+    }
+
+    ScalingConfig config;
+    std::vector<ScalingPoint> points;
+};
+
+#endif //PPDS_UTIL_SCALINGHARNESS_H
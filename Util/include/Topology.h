@@ -0,0 +1,217 @@
+#ifndef PPDS_UTIL_TOPOLOGY_H
+#define PPDS_UTIL_TOPOLOGY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief how worker threads are spread over the machine
+ */
+enum class AffinityPolicy : uint8_t {
+    NONE = 0, ///< leave placement to the OS
+    COMPACT = 1, ///< fill one NUMA node, including its hyper-threads, before using the next
+    SCATTER = 2, ///< round robin over the NUMA nodes, so every node gets the same share of threads
+    PHYSICAL_CORES = 3, ///< one thread per physical core first, hyper-thread siblings only once all cores are used
+};
+
+struct CpuInfo {
+    int cpu; ///< logical cpu id as used by sched_setaffinity
+    int core; ///< core id, unique only within a package
+    int package; ///< socket
+    int node; ///< NUMA node
+};
+
+/**
+ * @brief cpu and NUMA topology read from sysfs (/sys/devices/system/cpu and /sys/devices/system/node).
+ * Falls back to a single node with hardware_concurrency cpus if sysfs is not available.
+ */
+class Topology {
+public:
+    static const Topology& get() {
+        static const Topology topology;
+        return topology;
+    }
+
+    [[nodiscard]] const std::vector<CpuInfo>& cpus() const { return cpuInfos; }
+
+    [[nodiscard]] int numNodes() const { return nodes; }
+
+    [[nodiscard]] int nodeOfCpu(const int cpu) const {
+        for(const auto& info: cpuInfos) {
+            if(info.cpu == cpu) {
+                return info.node;
+            }
+        }
+        return 0;
+    }
+
+    [[nodiscard]] std::vector<int> cpusOfNode(const int node) const {
+        std::vector<int> result;
+        for(const auto& info: cpuInfos) {
+            if(info.node == node) {
+                result.emplace_back(info.cpu);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief the cpu every one of numThreads workers should be pinned to. If there are more threads than cpus the
+     * order starts over. Empty for AffinityPolicy::NONE
+     */
+    [[nodiscard]] std::vector<int> cpuOrder(const AffinityPolicy policy, const std::size_t numThreads) const {
+        std::vector<CpuInfo> order = cpuInfos;
+        const auto byPlacement = [](const CpuInfo& a, const CpuInfo& b) {
+            return std::tie(a.node, a.package, a.core, a.cpu) < std::tie(b.node, b.package, b.core, b.cpu);
+        };
+        switch(policy) {
+            case AffinityPolicy::NONE:
+                return {};
+            case AffinityPolicy::COMPACT:
+                std::sort(order.begin(), order.end(), byPlacement);
+                break;
+            case AffinityPolicy::SCATTER: {
+                std::sort(order.begin(), order.end(), byPlacement);
+                std::map<int, std::vector<CpuInfo>> perNode;
+                for(const auto& info: order) {
+                    perNode[info.node].emplace_back(info);
+                }
+                order.clear();
+                for(std::size_t i = 0; order.size() < cpuInfos.size(); ++i) {
+                    for(const auto& [node, infos]: perNode) {
+                        if(i < infos.size()) {
+                            order.emplace_back(infos[i]);
+                        }
+                    }
+                }
+                break;
+            }
+            case AffinityPolicy::PHYSICAL_CORES: {
+                // rank 0 is the first hyper-thread of a core, rank 1 its sibling and so on
+                std::sort(order.begin(), order.end(), byPlacement);
+                std::vector<std::pair<int, CpuInfo>> ranked;
+                for(std::size_t i = 0; i < order.size(); ++i) {
+                    const bool sibling = i > 0 && order[i - 1].package == order[i].package && order[i - 1].core == order[i].core;
+                    ranked.emplace_back(sibling ? ranked.back().first + 1 : 0, order[i]);
+                }
+                std::stable_sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {return a.first < b.first;});
+                for(std::size_t i = 0; i < ranked.size(); ++i) {
+                    order[i] = ranked[i].second;
+                }
+                break;
+            }
+        }
+        std::vector<int> result(numThreads);
+        for(std::size_t i = 0; i < numThreads; ++i) {
+            result[i] = order[i % order.size()].cpu;
+        }
+        return result;
+    }
+
+private:
+    Topology() {
+        for(const auto cpu: parseCpuList(readFile("/sys/devices/system/cpu/online"))) {
+            const auto path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            cpuInfos.emplace_back(CpuInfo{cpu, readInt(path + "core_id", cpu), readInt(path + "physical_package_id", 0), 0});
+        }
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if(sched_getaffinity(0, sizeof(allowed), &allowed) == 0) { // cpus outside our cpuset can not be pinned to
+            std::erase_if(cpuInfos, [&allowed](const CpuInfo& info) {return !CPU_ISSET(info.cpu, &allowed);});
+        }
+        if(cpuInfos.empty()) {
+            const int numCpus = std::max(1u, std::thread::hardware_concurrency());
+            for(int cpu = 0; cpu < numCpus; ++cpu) {
+                cpuInfos.emplace_back(CpuInfo{cpu, cpu, 0, 0});
+            }
+        }
+        nodes = 1;
+        for(const auto node: parseCpuList(readFile("/sys/devices/system/node/online"))) {
+            for(const auto cpu: parseCpuList(readFile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"))) {
+                for(auto& info: cpuInfos) {
+                    if(info.cpu == cpu) {
+                        info.node = node;
+                    }
+                }
+            }
+            nodes = std::max(nodes, node + 1);
+        }
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream file(path);
+        std::string content;
+        std::getline(file, content);
+        return content;
+    }
+
+    static int readInt(const std::string& path, const int fallback) {
+        const auto content = readFile(path);
+        return content.empty() ? fallback : std::stoi(content);
+    }
+
+    /**
+     * @brief parses the sysfs list format, e.g. "0-3,8-11,16"
+     */
+    static std::vector<int> parseCpuList(const std::string& list) {
+        std::vector<int> result;
+        std::istringstream ss(list);
+        std::string range;
+        while(std::getline(ss, range, ',')) {
+            if(range.empty()) {
+                continue;
+            }
+            const auto dash = range.find('-');
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for(int i = first; i <= last; ++i) {
+                result.emplace_back(i);
+            }
+        }
+        return result;
+    }
+
+    std::vector<CpuInfo> cpuInfos;
+    int nodes = 1;
+};
+
+/**
+ * @brief pins thread to cpu, returns false if the cpu is not available to this process
+ */
+inline bool pinThread(const pthread_t thread, const int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+}
+
+inline bool pinCurrentThread(const int cpu) {
+    return pinThread(pthread_self(), cpu);
+}
+
+/**
+ * @brief NUMA node the page containing address is placed on, -1 if it is not mapped yet or the kernel has no NUMA support
+ */
+inline int nodeOfAddress(const void* address) {
+    void* page = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(address) & ~static_cast<uintptr_t>(sysconf(_SC_PAGESIZE) - 1));
+    int status = -1;
+    // move_pages without target nodes only reports where the pages are
+    if(syscall(SYS_move_pages, 0, 1, &page, nullptr, &status, 0) != 0 || status < 0) {
+        return -1;
+    }
+    return status;
+}
+
+#endif //PPDS_UTIL_TOPOLOGY_H